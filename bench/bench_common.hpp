@@ -0,0 +1,30 @@
+/*
+ * bench_common.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BENCH_BENCH_COMMON_HPP_
+#define BENCH_BENCH_COMMON_HPP_
+
+#include <chrono>
+
+namespace license {
+namespace bench {
+
+class Stopwatch {
+private:
+	std::chrono::steady_clock::time_point m_start;
+
+public:
+	Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+	inline void restart() { m_start = std::chrono::steady_clock::now(); }
+	inline double elapsed_ns() const {
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+	}
+};
+
+}  // namespace bench
+}  // namespace license
+
+#endif /* BENCH_BENCH_COMMON_HPP_ */
@@ -0,0 +1,136 @@
+/*
+ * bench_runner.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <regex>
+#include <stdexcept>
+
+#include "../src/license_generator/json_writer.hpp"
+#include "../src/license_generator/profiler.hpp"
+#include "bench_common.hpp"
+#include "bench_runner.hpp"
+
+namespace license {
+namespace bench {
+using namespace std;
+
+const uint64_t BenchmarkRunner::BATCH_NS;
+
+static atomic<size_t> sink(0);
+
+void do_not_optimize(size_t value) { sink.fetch_add(value, memory_order_relaxed); }
+
+void BenchmarkRunner::add(const std::string &name, const Benchmark &benchmark) {
+	m_benchmarks.push_back(make_pair(name, benchmark));
+}
+
+std::vector<std::string> BenchmarkRunner::names(const std::string &filter) const {
+	regex pattern;
+	try {
+		pattern = regex(filter);
+	} catch (const regex_error &e) {
+		throw invalid_argument("invalid filter [" + filter + "]: " + e.what());
+	}
+	vector<string> result;
+	for (const auto &benchmark : m_benchmarks) {
+		if (filter.empty() || regex_search(benchmark.first, pattern)) {
+			result.push_back(benchmark.first);
+		}
+	}
+	return result;
+}
+
+static BenchmarkResult measure(const string &name, const BenchmarkRunner::Benchmark &benchmark,
+							   const BenchmarkOptions &options) {
+	// warm up, then grow the batch until it can be timed reliably
+	benchmark(1);
+	size_t batch = 1;
+	while (true) {
+		Stopwatch watch;
+		benchmark(batch);
+		const double elapsed = watch.elapsed_ns();
+		if (elapsed >= BenchmarkRunner::BATCH_NS) {
+			break;
+		}
+		const double growth = elapsed > 0 ? BenchmarkRunner::BATCH_NS * 1.2 / elapsed : 10;
+		batch = (size_t)(batch * min(10.0, max(2.0, growth)));
+	}
+	vector<double> samples;
+	double total_ns = 0;
+	uint64_t operations = 0;
+	for (size_t r = 0; r < options.repetitions; r++) {
+		double repetition_ns = 0;
+		do {
+			Stopwatch watch;
+			benchmark(batch);
+			const double elapsed = watch.elapsed_ns();
+			samples.push_back(elapsed / batch);
+			repetition_ns += elapsed;
+			operations += batch;
+		} while (repetition_ns < options.min_time_ms * 1e6);
+		total_ns += repetition_ns;
+	}
+	sort(samples.begin(), samples.end());
+	BenchmarkResult result;
+	result.name = name;
+	result.operations = operations;
+	result.samples = samples.size();
+	result.mean_ns = total_ns / operations;
+	result.min_ns = samples.front();
+	result.p50_ns = nearest_rank_percentile(samples, 50);
+	result.p90_ns = nearest_rank_percentile(samples, 90);
+	result.p99_ns = nearest_rank_percentile(samples, 99);
+	result.max_ns = samples.back();
+	return result;
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::run(const BenchmarkOptions &options, std::ostream *progress) const {
+	if (options.repetitions == 0) {
+		throw invalid_argument("at least one repetition is needed");
+	}
+	const vector<string> selected = names(options.filter);
+	vector<BenchmarkResult> results;
+	for (const auto &benchmark : m_benchmarks) {
+		if (find(selected.begin(), selected.end(), benchmark.first) == selected.end()) {
+			continue;
+		}
+		results.push_back(measure(benchmark.first, benchmark.second, options));
+		if (progress != nullptr) {
+			print_text(results.back(), *progress);
+		}
+	}
+	return results;
+}
+
+void print_text(const BenchmarkResult &result, std::ostream &os) {
+	const ios::fmtflags flags = os.flags();
+	os << left << setw(32) << result.name << right << fixed << setprecision(1) << " mean " << setw(12) << result.mean_ns
+	   << " ns, p50 " << setw(12) << result.p50_ns << " ns, p99 " << setw(12) << result.p99_ns << " ns, " << setw(12)
+	   << result.ops_per_second() << " ops/s (" << result.operations << " ops)" << endl;
+	os.flags(flags);
+}
+
+std::string results_json(const BenchmarkOptions &options, const std::vector<BenchmarkResult> &results) {
+	string out;
+	JsonWriter writer(out);
+	writer.begin_object().key("repetitions").number(options.repetitions).key("min_time_ms").real(options.min_time_ms);
+	writer.key("benchmarks").begin_array();
+	for (const BenchmarkResult &result : results) {
+		writer.begin_object().key("name").value(result.name).key("operations").number(result.operations);
+		writer.key("samples").number(result.samples).key("ops_per_s").real(result.ops_per_second());
+		writer.key("ns_per_op").begin_object().key("mean").real(result.mean_ns).key("min").real(result.min_ns);
+		writer.key("p50").real(result.p50_ns).key("p90").real(result.p90_ns).key("p99").real(result.p99_ns);
+		writer.key("max").real(result.max_ns).end_object().end_object();
+	}
+	writer.end_array().end_object();
+	out.push_back('\n');
+	return out;
+}
+
+}  // namespace bench
+}  // namespace license
@@ -0,0 +1,87 @@
+/*
+ * bench_runner.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BENCH_BENCH_RUNNER_HPP_
+#define BENCH_BENCH_RUNNER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace license {
+namespace bench {
+
+struct BenchmarkOptions {
+	// regular expression searched in the benchmark names, empty for all of them
+	std::string filter;
+	size_t repetitions;
+	// minimum duration of a repetition
+	double min_time_ms;
+};
+
+struct BenchmarkResult {
+	std::string name;
+	uint64_t operations;
+	size_t samples;
+	// time per operation
+	double mean_ns;
+	double min_ns;
+	double p50_ns;
+	double p90_ns;
+	double p99_ns;
+	double max_ns;
+	inline double ops_per_second() const { return mean_ns > 0 ? 1e9 / mean_ns : 0; }
+};
+
+/**
+ * Runs microbenchmarks and collects the distribution of their time per operation.
+ *
+ * <p>A benchmark is a function running its operation the number of times it is asked to. The runner first finds a
+ * batch size large enough for a batch to be timed reliably (BATCH_NS at least), then each repetition times batches
+ * until it lasts min_time_ms. Every batch is a sample: percentiles are computed on the samples of all the
+ * repetitions, the mean on the total time.</p>
+ */
+class BenchmarkRunner {
+public:
+	typedef std::function<void(size_t operations)> Benchmark;
+	// minimum duration of a timed batch
+	static const uint64_t BATCH_NS = 20000;
+
+private:
+	std::vector<std::pair<std::string, Benchmark>> m_benchmarks;
+
+public:
+	void add(const std::string &name, const Benchmark &benchmark);
+	/**
+	 * Names of the benchmarks matching the filter, in the order they were added.
+	 * @throws invalid_argument if the filter is not a valid regular expression.
+	 */
+	std::vector<std::string> names(const std::string &filter) const;
+	/**
+	 * Run the benchmarks matching the filter, printing their results on progress as they complete (if not null).
+	 */
+	std::vector<BenchmarkResult> run(const BenchmarkOptions &options, std::ostream *progress) const;
+};
+
+void print_text(const BenchmarkResult &result, std::ostream &os);
+/**
+ * The results as a JSON object: {"repetitions": 5, "min_time_ms": 100, "benchmarks": [{"name": "...", "operations":
+ * 1000, "samples": 10, "ops_per_s": 1e+06, "ns_per_op": {"mean": 1000, "min": 900, "p50": 1000, ...}}]}
+ */
+std::string results_json(const BenchmarkOptions &options, const std::vector<BenchmarkResult> &results);
+
+/**
+ * Keep the compiler from optimizing away a result.
+ */
+void do_not_optimize(size_t value);
+
+}  // namespace bench
+}  // namespace license
+
+#endif /* BENCH_BENCH_RUNNER_HPP_ */
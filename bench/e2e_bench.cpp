@@ -0,0 +1,303 @@
+/**
+ * End-to-end issuing throughput: N projects are initialized, then M licenses are issued for them with a mix of
+ * parameters close to production (one to three features, extra data, hardware bound or not, licenses extended with
+ * new features). Both steps run through the library API and through the lccgen executable (project init-batch, one
+ * license batch per project), on the same workload.
+ *
+ * lccgen_e2e_bench [--projects N] [--licenses M] [--seed S] [--json FILE] [--baseline FILE --tolerance PCT]
+ *
+ * The JSON written by --json can be used as a baseline: with --baseline the benchmark fails (exit code 1) if the
+ * throughput of a phase drops more than --tolerance percent below the throughput recorded in the baseline.
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <build_properties.h>
+
+#include "../src/base_lib/base.h"
+#include "../src/inja/nlohmann/json.hpp"
+#include "../src/license_generator/atomic_file.hpp"
+#include "../src/license_generator/json_writer.hpp"
+#include "../src/license_generator/license.hpp"
+#include "../src/license_generator/project.hpp"
+#include "../src/license_generator/project_context.hpp"
+#include "../src/license_generator/project_index.hpp"
+#include "bench_common.hpp"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+using namespace license;
+using namespace license::bench;
+using namespace std;
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+// columns of the license orders, as in the input of license batch
+static const vector<string> COLUMNS = {PARAM_LICENSE_OUTPUT,	 PARAM_FEATURE_NAMES, PARAM_CLIENT_SIGNATURE,
+									   PARAM_BEGIN_DATE,		 PARAM_EXPIRY_DATE,	  PARAM_EXTRA_DATA};
+static const vector<string> FEATURES = {"core", "reports", "export", "api", "cluster"};
+
+struct Phase {
+	string name;
+	// projects or licenses
+	size_t items;
+	double seconds;
+	inline double per_second() const { return seconds > 0 ? items / seconds : 0; }
+};
+
+static string project_name(size_t p) { return "E2E_PROJECT_" + to_string(p); }
+
+/**
+ * The orders of each project, one vector of values (in COLUMNS order) per license. The file name is relative to the
+ * licenses folder of the project.
+ */
+static vector<vector<vector<string>>> make_orders(size_t projects, size_t licenses, unsigned seed) {
+	mt19937 random(seed);
+	auto chance = [&random](unsigned percent) { return random() % 100 < percent; };
+	vector<vector<vector<string>>> orders(projects);
+	for (size_t i = 0; i < licenses; i++) {
+		vector<vector<string>> &project_orders = orders[i % projects];
+		vector<string> order(COLUMNS.size());
+		if (!project_orders.empty() && chance(20)) {
+			// an existing license extended with one more feature
+			const vector<string> &previous = project_orders[random() % project_orders.size()];
+			order[0] = previous[0];
+			order[1] = FEATURES[random() % FEATURES.size()];
+			order[2] = previous[2];
+		} else {
+			order[0] = "customer" + to_string(random() % 1000) + "/license" + to_string(i) + ".lic";
+			const size_t first = random() % FEATURES.size(), count = 1 + random() % 3;
+			for (size_t f = 0; f < count; f++) {
+				order[1] += (f == 0 ? "" : ",") + FEATURES[(first + f) % FEATURES.size()];
+			}
+			if (chance(70)) {
+				order[2] = to_string(1000 + random() % 9000) + "-" + to_string(1000 + random() % 9000) + "-" +
+						   to_string(1000 + random() % 9000);
+			}
+		}
+		if (chance(30)) {
+			order[3] = "2026-01-" + to_string(10 + random() % 19);
+		}
+		order[4] = chance(50) ? "+12m" : "2030-12-31";
+		if (chance(40)) {
+			order[5] = "customer=" + to_string(random() % 1000) + ";seats=" + to_string(1 + random() % 500);
+		}
+		project_orders.push_back(order);
+	}
+	return orders;
+}
+
+static void run_command(const string &command) {
+	if (system((command + " > " NULL_DEVICE).c_str()) != 0) {
+		throw runtime_error("command failed: " + command);
+	}
+}
+
+static Phase init_library(const fs::path &projects_folder, size_t projects, const string &templates_folder) {
+	Stopwatch watch;
+	const shared_ptr<const KeyTemplates> templates = KeyTemplates::get(templates_folder);
+	vector<ProjectManifest> manifests;
+	for (size_t p = 0; p < projects; p++) {
+		Project project(project_name(p), projects_folder.string(), templates, true);
+		if (project.initialize(false) != FUNC_RET_OK) {
+			throw runtime_error("can't initialize " + project_name(p));
+		}
+		manifests.push_back(project.manifest());
+	}
+	update_project_index(projects_folder.string(), manifests);
+	return Phase{"init_library", projects, watch.elapsed_ns() / 1e9};
+}
+
+static Phase init_binary(const fs::path &work, const fs::path &projects_folder, size_t projects,
+						 const string &templates_folder) {
+	const string orders_file = (work / "projects.tsv").string();
+	{
+		ofstream orders(orders_file, ios::trunc);
+		orders << "project-name\n";
+		for (size_t p = 0; p < projects; p++) {
+			orders << project_name(p) << '\n';
+		}
+	}
+	Stopwatch watch;
+	run_command(string("\"") + LCCGEN_PATH + "\" project init-batch --force -i \"" + orders_file + "\" -p \"" +
+				projects_folder.string() + "\" -t \"" + templates_folder + "\"");
+	return Phase{"init_binary", projects, watch.elapsed_ns() / 1e9};
+}
+
+static Phase issue_library(const fs::path &projects_folder, const fs::path &licenses_folder,
+						   const vector<vector<vector<string>>> &orders, size_t licenses) {
+	Stopwatch watch;
+	for (size_t p = 0; p < orders.size(); p++) {
+		const ProjectContext project((projects_folder / project_name(p)).string());
+		AtomicFileWriter file_writer(64, 1000);
+		string license_name;
+		License license(project, &license_name, false, &file_writer);
+		for (const vector<string> &order : orders[p]) {
+			license_name = (licenses_folder / project_name(p) / order[0]).string();
+			license.reset(&license_name);
+			for (size_t c = 1; c < COLUMNS.size(); c++) {
+				if (!order[c].empty()) {
+					license.add_parameter(COLUMNS[c], order[c]);
+				}
+			}
+			license.write_license();
+		}
+		file_writer.commit();
+	}
+	return Phase{"issue_library", licenses, watch.elapsed_ns() / 1e9};
+}
+
+static Phase issue_binary(const fs::path &work, const fs::path &projects_folder, const fs::path &licenses_folder,
+						  const vector<vector<vector<string>>> &orders, size_t licenses) {
+	vector<string> orders_files;
+	for (size_t p = 0; p < orders.size(); p++) {
+		orders_files.push_back((work / (project_name(p) + ".tsv")).string());
+		ofstream file(orders_files.back(), ios::trunc);
+		for (size_t c = 0; c < COLUMNS.size(); c++) {
+			file << (c == 0 ? "" : "\t") << COLUMNS[c];
+		}
+		file << '\n';
+		for (const vector<string> &order : orders[p]) {
+			file << (licenses_folder / project_name(p) / order[0]).string();
+			for (size_t c = 1; c < COLUMNS.size(); c++) {
+				file << '\t' << order[c];
+			}
+			file << '\n';
+		}
+	}
+	Stopwatch watch;
+	for (size_t p = 0; p < orders.size(); p++) {
+		run_command(string("\"") + LCCGEN_PATH + "\" license batch -p \"" +
+					(projects_folder / project_name(p)).string() + "\" -i \"" + orders_files[p] + "\"");
+	}
+	return Phase{"issue_binary", licenses, watch.elapsed_ns() / 1e9};
+}
+
+static string results_json(size_t projects, size_t licenses, unsigned seed, const vector<Phase> &phases) {
+	string out;
+	JsonWriter writer(out);
+	writer.begin_object().key("projects").number(projects).key("licenses").number(licenses).key("seed").number(seed);
+	writer.key("phases").begin_object();
+	for (const Phase &phase : phases) {
+		writer.key(phase.name).begin_object().key("items").number(phase.items).key("seconds").real(phase.seconds);
+		writer.key("per_second").real(phase.per_second()).end_object();
+	}
+	writer.end_object().end_object();
+	out.push_back('\n');
+	return out;
+}
+
+/**
+ * @return the number of phases slower than the baseline allows.
+ */
+static size_t check_baseline(const string &baseline_file, double tolerance, size_t projects, size_t licenses,
+							 const vector<Phase> &phases) {
+	ifstream input(baseline_file);
+	if (!input.is_open()) {
+		throw runtime_error("can't open the baseline [" + baseline_file + "]");
+	}
+	nlohmann::json baseline;
+	try {
+		input >> baseline;
+		if (baseline.at("projects").get<size_t>() != projects || baseline.at("licenses").get<size_t>() != licenses) {
+			throw runtime_error("the baseline was recorded with " + baseline.at("projects").dump() + " projects and " +
+								baseline.at("licenses").dump() + " licenses");
+		}
+	} catch (const nlohmann::json::exception &e) {
+		throw runtime_error("invalid baseline [" + baseline_file + "]: " + e.what());
+	}
+	size_t regressions = 0;
+	for (const Phase &phase : phases) {
+		const auto recorded = baseline["phases"].find(phase.name);
+		if (recorded == baseline["phases"].end()) {
+			continue;
+		}
+		const double expected = recorded->at("per_second").get<double>();
+		const double limit = expected * (100 - tolerance) / 100;
+		const bool regression = phase.per_second() < limit;
+		cout << (regression ? "REGRESSION " : "ok         ") << phase.name << ": " << phase.per_second()
+			 << "/s, baseline " << expected << "/s, limit " << limit << "/s" << endl;
+		regressions += regression;
+	}
+	return regressions;
+}
+
+int main(int argc, const char **argv) {
+	size_t projects, licenses;
+	unsigned seed;
+	double tolerance;
+	string work_folder, json_file, baseline_file;
+	po::options_description desc("lccgen_e2e_bench options");
+	desc.add_options()  //
+		("projects", po::value<size_t>(&projects)->default_value(20), "Number of projects initialized.")  //
+		("licenses", po::value<size_t>(&licenses)->default_value(5000), "Number of licenses issued.")  //
+		("seed", po::value<unsigned>(&seed)->default_value(1), "Seed of the generated workload.")  //
+		("work-folder", po::value<string>(&work_folder)->default_value(
+							(fs::path(PROJECT_TEST_TEMP_DIR) / "bench_e2e").string()),
+		 "Folder of the projects and licenses, emptied at start.")  //
+		("json", po::value<string>(&json_file), "Write the results to this file as JSON (usable as baseline).")  //
+		("baseline", po::value<string>(&baseline_file),
+		 "Results of a previous run: fail if a phase is slower than it by more than the tolerance.")  //
+		("tolerance", po::value<double>(&tolerance)->default_value(30),
+		 "Percentage of the baseline throughput that can be lost before failing.")  //
+		("help,h", "Print this help.");
+	po::variables_map vm;
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+	} catch (const po::error &e) {
+		cerr << e.what() << endl << desc << endl;
+		return 2;
+	}
+	if (vm.count("help") > 0) {
+		cout << desc << endl;
+		return 0;
+	}
+	if (projects == 0 || licenses == 0) {
+		cerr << "at least a project and a license are needed" << endl;
+		return 2;
+	}
+	try {
+		const fs::path work(work_folder);
+		const string templates_folder = (fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src").string();
+		fs::remove_all(work);
+		fs::create_directories(work);
+		const vector<vector<vector<string>>> orders = make_orders(projects, licenses, seed);
+		vector<Phase> phases;
+		phases.push_back(init_library(work / "library" / "projects", projects, templates_folder));
+		phases.push_back(init_binary(work, work / "binary" / "projects", projects, templates_folder));
+		phases.push_back(
+			issue_library(work / "library" / "projects", work / "library" / "licenses", orders, licenses));
+		phases.push_back(
+			issue_binary(work, work / "binary" / "projects", work / "binary" / "licenses", orders, licenses));
+		for (const Phase &phase : phases) {
+			cout << left << setw(14) << phase.name << right << phase.items << " in " << phase.seconds << " s, "
+				 << phase.per_second() << "/s" << endl;
+		}
+		const string results = results_json(projects, licenses, seed, phases);
+		if (!json_file.empty()) {
+			ofstream json(json_file, ios::trunc);
+			json << results;
+			if (!json) {
+				throw runtime_error("can't write [" + json_file + "]");
+			}
+		}
+		if (!baseline_file.empty() && check_baseline(baseline_file, tolerance, projects, licenses, phases) > 0) {
+			return 1;
+		}
+	} catch (const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
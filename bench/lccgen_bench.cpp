@@ -0,0 +1,533 @@
+/**
+ * Microbenchmarks of the license issuing hot path: key handling, signatures, base64, canonicalization, date and
+ * parameter normalization, INI serialization, the rendering of the public key artifacts, the output sinks, the
+ * license index queries and, for comparison, an issue spawning lccgen.
+ *
+ * lccgen_bench [--filter REGEX] [--repetitions N] [--min-time MS] [--json FILE] [--list]
+ */
+#define SI_SUPPORT_IOSTREAMS
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <build_properties.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "../src/base_lib/base.h"
+#include "../src/base_lib/base64.h"
+#include "../src/base_lib/crypto_helper.hpp"
+#include "../src/ini/SimpleIni.h"
+#include "../src/license_generator/atomic_file.hpp"
+#include "../src/license_generator/date_parser.hpp"
+#include "../src/license_generator/license.hpp"
+#include "../src/license_generator/license_index.hpp"
+#include "../src/license_generator/output_sink.hpp"
+#include "../src/license_generator/parameter_schema.hpp"
+#include "../src/license_generator/project.hpp"
+#include "../src/license_generator/project_context.hpp"
+#include "bench_runner.hpp"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+using namespace license;
+using namespace license::bench;
+using namespace std;
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+// licenses in the index queried by the index/ benchmarks
+static const size_t INDEX_SIZE = 1000000;
+// licenses added to the journal of that index by index/query/journal
+static const size_t JOURNAL_SIZE = 5000;
+
+/**
+ * A key accepting every signature: License::verify then measures the license parsing and print_for_sign, the
+ * canonicalization of the sections, that is internal to license.cpp.
+ */
+class AcceptingKey : public CryptoHelper {
+public:
+	void generateKeyPair() override {}
+	const string exportPrivateKey() const override { return string(); }
+	const vector<unsigned char> exportPublicKey() const override { return vector<unsigned char>(); }
+	void loadPrivateKey(const string &) override {}
+	const vector<unsigned char> exportPrivateKeyDer() const override { return vector<unsigned char>(); }
+	void loadPrivateKeyDer(const unsigned char *, size_t) override {}
+	const string signString(const string &) const override { return string(); }
+	bool verifySignature(const string &, const string &) const override { return true; }
+	const string publicKeyFingerprint() const override { return string(); }
+};
+
+static const string read_file(const fs::path &file) {
+	ifstream stream(file.string(), ios::binary);
+	return string((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+}
+
+// implementation of normalize_date up to version 2.1.0
+static const string legacy_normalize_date(const std::string &sDate) {
+	static const std::string formats[] = {"%4u-%2u-%2u", "%4u/%2u/%2u", "%4u%2u%2u"};
+	if (sDate.size() < 8) throw invalid_argument("Date string too small for known formats");
+	unsigned int year, month, day;
+	bool found = false;
+	for (size_t i = 0; i < 3 && !found; ++i) {
+		const int chread = sscanf(sDate.c_str(), formats[i].c_str(), &year, &month, &day);
+		if (chread == 3) {
+			found = true;
+			break;
+		}
+	}
+	if (!found) throw invalid_argument("Date [" + sDate + "] did not match a known format. try YYYY-MM-DD");
+	ostringstream oss;
+	oss << year << "-" << setfill('0') << std::setw(2) << month << "-" << setfill('0') << std::setw(2) << day;
+	return oss.str();
+}
+
+// the segments License::write_license passes to its sink: text, signature, text...
+static const vector<Segment> split_signatures(const string &license) {
+	vector<Segment> segments;
+	const string signature_key = string(LICENSE_SIGNATURE) + " = ";
+	size_t start = 0, found;
+	while ((found = license.find(signature_key, start)) != string::npos) {
+		const size_t value = found + signature_key.size();
+		const size_t end = license.find('\n', value);
+		const Segment text = {license.data() + start, value - start};
+		const Segment signature = {license.data() + value, end - value};
+		segments.push_back(text);
+		segments.push_back(signature);
+		start = end;
+	}
+	const Segment tail = {license.data() + start, license.size() - start};
+	segments.push_back(tail);
+	return segments;
+}
+
+#ifndef _WIN32
+/**
+ * A pipe drained by a thread, like the standard output of lccgen read by another process.
+ */
+class DrainedPipe {
+private:
+	int m_fds[2];
+	thread m_reader;
+
+public:
+	DrainedPipe() {
+		if (pipe(m_fds) != 0) {
+			throw runtime_error("can't create a pipe");
+		}
+		const int read_fd = m_fds[0];
+		m_reader = thread([read_fd]() {
+			char buffer[65536];
+			while (read(read_fd, buffer, sizeof(buffer)) > 0) {
+			}
+		});
+	}
+	DrainedPipe(const DrainedPipe &) = delete;
+	DrainedPipe &operator=(const DrainedPipe &) = delete;
+	~DrainedPipe() {
+		close(m_fds[1]);
+		m_reader.join();
+		close(m_fds[0]);
+	}
+	inline int write_fd() const { return m_fds[1]; }
+};
+#endif
+
+static LicenseRecord make_record(const fs::path &folder, size_t i) {
+	LicenseRecord record;
+	record.path = (folder / ("customer" + to_string(i % 1000)) / ("host" + to_string(i) + ".lic")).string();
+	record.features = i % 10 == 0 ? "PRODUCT,EXTRA" : "PRODUCT";
+	record.valid_from = "2026-01-01";
+	// one year of expiry dates
+	const unsigned month = (unsigned)(i % 12) + 1, day = (unsigned)(i % 28) + 1;
+	record.valid_to = "2027-" + string(month < 10 ? "0" : "") + to_string(month) + "-" + (day < 10 ? "0" : "") +
+					  to_string(day);
+	record.client_signature = "SIG-" + to_string(i);
+	return record;
+}
+
+/**
+ * The license index queried by the index/ benchmarks. It takes seconds to build, so it's built by the first
+ * benchmark using it (in its warm up) instead of when the benchmarks are registered, and removed at the end.
+ */
+class IndexFixture {
+private:
+	const fs::path m_folder;
+	unique_ptr<LicenseIndex> m_index;
+	bool m_journal;
+
+public:
+	explicit IndexFixture(const fs::path &folder) : m_folder(folder), m_journal(false) {}
+	IndexFixture(const IndexFixture &) = delete;
+	IndexFixture &operator=(const IndexFixture &) = delete;
+	~IndexFixture() {
+		m_index.reset();
+		boost::system::error_code ec;
+		fs::remove_all(m_folder, ec);
+	}
+	LicenseIndex &index() {
+		if (!m_index) {
+			fs::remove_all(m_folder);
+			fs::create_directories(m_folder);
+			m_index.reset(new LicenseIndex(m_folder.string()));
+			for (size_t i = 0; i < INDEX_SIZE; i++) {
+				m_index->add(make_record(m_folder, i));
+			}
+			m_index->compact();
+		}
+		return *m_index;
+	}
+	// the index with licenses issued after the last compaction, merged at query time
+	LicenseIndex &index_with_journal() {
+		LicenseIndex &result = index();
+		if (!m_journal) {
+			for (size_t i = 0; i < JOURNAL_SIZE; i++) {
+				result.add(make_record(m_folder, INDEX_SIZE + i));
+			}
+			result.flush();
+			m_journal = true;
+		}
+		return result;
+	}
+};
+
+static void add_crypto_benchmarks(BenchmarkRunner &runner, const string &private_key) {
+	runner.add("crypto/generateKeyPair", [](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+			crypto->generateKeyPair();
+		}
+	});
+	runner.add("crypto/loadPrivateKey", [private_key](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+			crypto->loadPrivateKey(private_key);
+		}
+	});
+	shared_ptr<CryptoHelper> key(CryptoHelper::getInstance());
+	key->loadPrivateKey(private_key);
+	const vector<unsigned char> der = key->exportPrivateKeyDer();
+	runner.add("crypto/loadPrivateKeyDer", [der](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+			crypto->loadPrivateKeyDer(der.data(), der.size());
+		}
+	});
+	for (const size_t size : {64, 1024, 16384}) {
+		const string text(size, 'x');
+		runner.add("crypto/signString/" + to_string(size), [key, text](size_t operations) {
+			for (size_t i = 0; i < operations; i++) {
+				do_not_optimize(key->signString(text).size());
+			}
+		});
+	}
+	const string text(64, 'x');
+	const string signature = key->signString(text);
+	runner.add("crypto/verifySignature/64", [key, text, signature](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(key->verifySignature(text, signature));
+		}
+	});
+}
+
+static void add_base64_benchmarks(BenchmarkRunner &runner) {
+	for (const size_t size : {16, 128, 4096, 65536}) {
+		string data(size, '\0');
+		for (size_t i = 0; i < size; i++) {
+			data[i] = (char)(i * 31 + 7);
+		}
+		runner.add("base64/" + to_string(size), [data](size_t operations) {
+			for (size_t i = 0; i < operations; i++) {
+				do_not_optimize(base64(data.data(), data.size()).size());
+			}
+		});
+		const string encoded = base64(data.data(), data.size());
+		runner.add("unbase64/" + to_string(size), [encoded](size_t operations) {
+			for (size_t i = 0; i < operations; i++) {
+				do_not_optimize(unbase64(encoded).size());
+			}
+		});
+	}
+}
+
+static void add_license_benchmarks(BenchmarkRunner &runner, const string &private_key) {
+	const shared_ptr<const ProjectContext> project = make_shared<const ProjectContext>("BENCH", private_key);
+	const shared_ptr<License> license = make_shared<License>(*project, nullptr);
+	license->add_parameter(PARAM_FEATURE_NAMES, "f1,f2,f3");
+	license->add_parameter(PARAM_EXPIRY_DATE, "2030-01-31");
+	license->add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB-CCCC");
+	license->add_parameter(PARAM_EXTRA_DATA, "customer=ACME");
+	const shared_ptr<string> issued = make_shared<string>();
+	license->write_license(*issued);
+
+	runner.add("license/print_for_sign", [issued](size_t operations) {
+		const AcceptingKey key;
+		vector<SectionVerification> sections;
+		for (size_t i = 0; i < operations; i++) {
+			License::verify(issued->data(), issued->size(), key, sections);
+			do_not_optimize(sections.size());
+		}
+	});
+	const vector<pair<string, string>> row = {{PARAM_FEATURE_NAMES, "feature1,feature2"},
+											  {PARAM_BEGIN_DATE, "2020-01-01"},
+											  {PARAM_EXPIRY_DATE, "20301231"},
+											  {PARAM_CLIENT_SIGNATURE, "AAAA-BBBB-CCCC"},
+											  {PARAM_VERSION_TO, "12"},
+											  {PARAM_EXTRA_DATA, "customer=ACME"}};
+	runner.add("license/find_parameter", [row](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(find_parameter(row[i % row.size()].first) != nullptr);
+		}
+	});
+	runner.add("license/add_parameter", [project, row](size_t operations) {
+		License parameters(*project, nullptr);
+		for (size_t i = 0; i < operations; i++) {
+			const auto &field = row[i % row.size()];
+			parameters.add_parameter(field.first, field.second);
+		}
+	});
+	runner.add("license/write_license", [project, license, issued](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			license->reset(nullptr);
+			license->add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-" + to_string(i));
+			license->add_parameter(PARAM_EXPIRY_DATE, "2030-01-01");
+			license->write_license(*issued);
+		}
+	});
+	const vector<string> dates = {"2020-01-31", "2021/12/01", "20221130", "1999-2-3"};
+	runner.add("date/normalize_date", [dates](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(normalize_date(dates[i % dates.size()]).size());
+		}
+	});
+	runner.add("date/normalize_date/legacy", [dates](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(legacy_normalize_date(dates[i % dates.size()]).size());
+		}
+	});
+	runner.add("date/normalize_date/buffer", [dates](size_t operations) {
+		const RunClock &clock = RunClock::current();
+		char out[DATE_LENGTH];
+		for (size_t i = 0; i < operations; i++) {
+			const string &date = dates[i % dates.size()];
+			normalize_date(date.data(), date.size(), clock, out);
+			do_not_optimize(out[9]);
+		}
+	});
+	const vector<string> relative = {"+365d", "+12m", "+2y", "-1w"};
+	runner.add("date/normalize_date/relative", [relative](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(normalize_date(relative[i % relative.size()]).size());
+		}
+	});
+
+	const string ini_text = *issued;
+	runner.add("ini/load", [ini_text](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			CSimpleIniA ini;
+			ini.LoadData(ini_text.data(), ini_text.size());
+			do_not_optimize(ini.GetSectionSize("F1"));
+		}
+	});
+	const shared_ptr<CSimpleIniA> loaded = make_shared<CSimpleIniA>();
+	loaded->LoadData(ini_text.data(), ini_text.size());
+	runner.add("ini/save", [loaded](size_t operations) {
+		string out;
+		for (size_t i = 0; i < operations; i++) {
+			out.clear();
+			loaded->Save(out);
+			do_not_optimize(out.size());
+		}
+	});
+}
+
+static void add_project_benchmarks(BenchmarkRunner &runner, const string &private_key) {
+	const shared_ptr<const KeyTemplates> templates =
+		make_shared<const KeyTemplates>((fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src").string());
+	unique_ptr<CryptoHelper> key(CryptoHelper::getInstance());
+	key->loadPrivateKey(private_key);
+	const vector<unsigned char> public_key = key->exportPublicKey();
+	runner.add("project/render_public_key", [templates, public_key](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(templates->render("BENCH", public_key).size());
+		}
+	});
+}
+
+static void add_sink_benchmarks(BenchmarkRunner &runner, const string &private_key) {
+	const ProjectContext project("BENCH", private_key);
+	License license(project, nullptr);
+	license.add_parameter(PARAM_FEATURE_NAMES, "feature1,feature2,feature3");
+	license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB-CCCC");
+	license.add_parameter(PARAM_EXPIRY_DATE, "2030-01-01");
+	const shared_ptr<string> issued = make_shared<string>();
+	license.write_license(*issued);
+	// the segments point into issued, that the benchmarks keep alive
+	const vector<Segment> segments = split_signatures(*issued);
+
+	const shared_ptr<string> buffer = make_shared<string>();
+	runner.add("sink/buffer", [issued, segments, buffer](size_t operations) {
+		buffer->clear();
+		BufferSink sink(*buffer);
+		for (size_t i = 0; i < operations; i++) {
+			sink.write(nullptr, segments.data(), segments.size());
+		}
+		do_not_optimize(buffer->size());
+	});
+#ifndef _WIN32
+	const shared_ptr<DrainedPipe> pipe = make_shared<DrainedPipe>();
+	runner.add("sink/pipe", [issued, segments, pipe](size_t operations) {
+		FdSink sink(pipe->write_fd());
+		for (size_t i = 0; i < operations; i++) {
+			sink.write(nullptr, segments.data(), segments.size());
+		}
+	});
+#endif
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / "bench_sinks");
+	fs::create_directories(folder);
+	vector<string> names;
+	for (size_t i = 0; i < 256; i++) {
+		names.push_back((folder / ("license_" + to_string(i) + ".lic")).string());
+	}
+	// every batch ends with the commit of the files still pending
+	runner.add("sink/file_group_commit_64", [issued, segments, names](size_t operations) {
+		AtomicFileWriter file_writer(64, 0);
+		FileSink sink(file_writer);
+		for (size_t i = 0; i < operations; i++) {
+			sink.write(&names[i % names.size()], segments.data(), segments.size());
+		}
+		file_writer.commit();
+	});
+	// the previous implementation: one ofstream per license, not durable
+	runner.add("sink/ofstream", [issued, names](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			ofstream license_file(names[i % names.size()], ios::trunc | ios::binary);
+			license_file << *issued;
+		}
+	});
+}
+
+static void add_index_benchmarks(BenchmarkRunner &runner) {
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / "bench_license_index");
+	const shared_ptr<IndexFixture> fixture = make_shared<IndexFixture>(folder);
+	LicenseFilter feature;
+	feature.feature = "extra";
+	LicenseFilter signature;
+	signature.client_signature = "SIG-4242";
+	LicenseFilter quarter;
+	quarter.expires_after = "2027-01-01";
+	quarter.expires_before = "2027-03-31";
+	const vector<pair<string, LicenseFilter>> queries = {
+		{"all", LicenseFilter()}, {"feature", feature}, {"client_signature", signature}, {"expiry_quarter", quarter}};
+	for (const auto &query : queries) {
+		const LicenseFilter filter = query.second;
+		runner.add("index/query/" + query.first, [fixture, filter](size_t operations) {
+			LicenseIndex &index = fixture->index();
+			for (size_t i = 0; i < operations; i++) {
+				do_not_optimize(index.query(filter, [](const LicenseRecord &) {}));
+			}
+		});
+	}
+	runner.add("index/query/journal", [fixture, quarter](size_t operations) {
+		LicenseIndex &index = fixture->index_with_journal();
+		for (size_t i = 0; i < operations; i++) {
+			do_not_optimize(index.query(quarter, [](const LicenseRecord &) {}));
+		}
+	});
+}
+
+// the cost of a license issued by a new lccgen process, to compare with license/write_license
+static void add_process_benchmarks(BenchmarkRunner &runner) {
+	const fs::path project_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "bench_issue" / "BENCH");
+	fs::create_directories(project_folder);
+	fs::remove(project_folder / PRIVATE_KEY_FNAME);
+	fs::copy_file(fs::path(PROJECT_TEST_SRC_DIR) / "data" / PRIVATE_KEY_FNAME, project_folder / PRIVATE_KEY_FNAME);
+	const string output((project_folder / "bench.lic").string());
+	runner.add("process/license_issue", [project_folder, output](size_t operations) {
+		for (size_t i = 0; i < operations; i++) {
+			const string command = string("\"") + LCCGEN_PATH + "\" license issue -p \"" + project_folder.string() +
+								   "\" -o \"" + output + "\" -e 2030-01-01 -s AAAA-" + to_string(i) + " > " NULL_DEVICE;
+			if (system(command.c_str()) != 0) {
+				throw runtime_error("[" + command + "] failed");
+			}
+		}
+	});
+}
+
+int main(int argc, const char **argv) {
+	BenchmarkOptions options;
+	string json_file;
+	po::options_description desc("lccgen_bench options");
+	desc.add_options()  //
+		("filter,f", po::value<string>(&options.filter)->default_value(""),
+		 "Run only the benchmarks whose name matches this regular expression.")  //
+		("repetitions,r", po::value<size_t>(&options.repetitions)->default_value(5),
+		 "Number of times each benchmark is measured.")  //
+		("min-time", po::value<double>(&options.min_time_ms)->default_value(100),
+		 "Minimum duration of a repetition, in milliseconds.")  //
+		("json", po::value<string>(&json_file),
+		 "Write the results to this file as JSON, - for the standard output.")  //
+		("list", "Print the names of the benchmarks and exit.")  //
+		("help,h", "Print this help.");
+	po::variables_map vm;
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+	} catch (const po::error &e) {
+		cerr << e.what() << endl << desc << endl;
+		return 2;
+	}
+	if (vm.count("help") > 0) {
+		cout << desc << endl;
+		return 0;
+	}
+	try {
+		const string private_key = read_file(fs::path(PROJECT_TEST_SRC_DIR) / "data" / PRIVATE_KEY_FNAME);
+		BenchmarkRunner runner;
+		add_crypto_benchmarks(runner, private_key);
+		add_base64_benchmarks(runner);
+		add_license_benchmarks(runner, private_key);
+		add_project_benchmarks(runner, private_key);
+		add_sink_benchmarks(runner, private_key);
+		add_index_benchmarks(runner);
+		add_process_benchmarks(runner);
+		if (vm.count("list") > 0) {
+			for (const string &name : runner.names(options.filter)) {
+				cout << name << '\n';
+			}
+			return 0;
+		}
+		// with the JSON on the standard output, progress goes to the standard error
+		const vector<BenchmarkResult> results = runner.run(options, json_file == "-" ? &cerr : &cout);
+		if (json_file == "-") {
+			cout << results_json(options, results);
+		} else if (!json_file.empty()) {
+			ofstream json(json_file, ios::trunc);
+			json << results_json(options, results);
+			if (!json) {
+				cerr << "can't write [" << json_file << "]" << endl;
+				return 1;
+			}
+		}
+	} catch (const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
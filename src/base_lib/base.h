@@ -29,6 +29,8 @@ typedef int bool;
 #endif
 
 #define PRIVATE_KEY_FNAME "private_key.rsa"
+// key replaced by the last key rotation (project init --force), used by license resign
+#define PREVIOUS_PRIVATE_KEY_FNAME "private_key.rsa.previous"
 #define PUBLIC_KEY_INC_FNAME "public_key.h"
 
 /**
@@ -40,10 +42,14 @@ typedef int bool;
  * command line parameters
  */
 #define PARAM_BASE64 "base64"
+#define PARAM_FORMAT "format"
 #define PARAM_LICENSE_OUTPUT "output-file-name"
 #define PARAM_FEATURE_NAMES "feature-names"
 #define PARAM_PROJECT_FOLDER "project-folder"
 #define PARAM_PRIMARY_KEY "primary-key"
+#define PARAM_LICENSES_FOLDER "licenses-folder"
+#define PARAM_SHARD_FANOUT "shard-fanout"
+#define PARAM_KEYSTORE "keystore"
 
 // license file parameters -- copy this block to open-license-manager
 #define PARAM_BEGIN_DATE "valid-from"
@@ -64,7 +64,7 @@ string base64(const void* binaryData, size_t len, int lineLenght) {
 	string encodeBuffer;
 	encodeBuffer.reserve(totalLength);
 
-	for (byteNo = 0; byteNo <= len - 3; byteNo += 3) {
+	for (byteNo = 0; (size_t)byteNo + 3 <= len; byteNo += 3) {
 		unsigned char BYTE0 = bin[byteNo];
 		unsigned char BYTE1 = bin[byteNo + 1];
 		unsigned char BYTE2 = bin[byteNo + 2];
@@ -98,7 +98,7 @@ string base64(const void* binaryData, size_t len, int lineLenght) {
 		add_CR_if_needed(encodeBuffer, lineLenght);
 		encodeBuffer += '=';
 	}
-	if (lineLenght && encodeBuffer[encodeBuffer.length() - 1] != '\n') {
+	if (lineLenght > 0 && !encodeBuffer.empty() && encodeBuffer[encodeBuffer.length() - 1] != '\n') {
 		encodeBuffer += '\n';
 	}
 	return encodeBuffer;
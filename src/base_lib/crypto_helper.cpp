@@ -22,6 +22,16 @@ unique_ptr<CryptoHelper> CryptoHelper::getInstance() {
 	return ptr;
 }
 
+const std::string CryptoHelper::toHex(const unsigned char *data, size_t size) {
+	static const char HEX[] = "0123456789abcdef";
+	string hex(size * 2, '0');
+	for (size_t i = 0; i < size; i++) {
+		hex[i * 2] = HEX[data[i] >> 4];
+		hex[i * 2 + 1] = HEX[data[i] & 0xf];
+	}
+	return hex;
+}
+
 void CryptoHelper::loadPrivateKey_file(const std::string &privateKey_file_name) {
 	if (!fs::exists(privateKey_file_name)) {
 		throw logic_error("Private key file [" + privateKey_file_name + "] does not exists");
@@ -24,6 +24,7 @@ namespace license {
 class CryptoHelper {
 protected:
 	inline CryptoHelper() {}
+	static const std::string toHex(const unsigned char *data, size_t size);
 
 public:
 	virtual void generateKeyPair() = 0;
@@ -43,12 +44,34 @@ public:
 	 * string containing the private key representation
 	 */
 	virtual void loadPrivateKey(const std::string &privateKey) = 0;
+	/**
+	 * Private key in pkcs#1 DER format: the binary content of the PEM returned by #exportPrivateKey.
+	 */
+	const virtual std::vector<unsigned char> exportPrivateKeyDer() const = 0;
+	/**
+	 * Load the private key from its pkcs#1 DER encoding, skipping the PEM decoding.
+	 */
+	virtual void loadPrivateKeyDer(const unsigned char *der, size_t size) = 0;
 	/**
 	 * signature algorithm SHA256withRSA
 	 * @param license
 	 * @return
 	 */
 	const virtual std::string signString(const std::string &license) const = 0;
+	/**
+	 * Verify a signature produced by #signString using the public part of the loaded key.
+	 * @param license
+	 * 			the signed data
+	 * @param signature
+	 * 			base64 encoded signature
+	 * @return true if the signature matches the data and the key.
+	 */
+	virtual bool verifySignature(const std::string &license, const std::string &signature) const = 0;
+	/**
+	 * SHA-256 of the public key (as returned by #exportPublicKey), hex encoded.
+	 * It identifies the key without exposing it.
+	 */
+	const virtual std::string publicKeyFingerprint() const = 0;
 	static std::unique_ptr<CryptoHelper> getInstance();
 	virtual ~CryptoHelper() {}
 };
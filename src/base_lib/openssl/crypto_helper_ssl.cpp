@@ -17,6 +17,7 @@
 #include <cstddef>
 #include <stdexcept>
 
+#include "../base64.h"
 #include "crypto_helper_ssl.hpp"
 
 namespace license {
@@ -140,6 +141,39 @@ const string CryptoHelperLinux::signString(const string &license) const {
 	EVP_MD_CTX_destroy(mdctx);
 	return signatureStr;
 }
+bool CryptoHelperLinux::verifySignature(const string &license, const string &signature) const {
+	if (!m_pktmp) {
+		throw logic_error("private key not initialized. Call generate or load first.");
+	}
+	const vector<uint8_t> raw_signature = unbase64(signature);
+	if (raw_signature.empty()) {
+		return false;
+	}
+	EVP_MD_CTX *mdctx = EVP_MD_CTX_create();
+	if (!mdctx) {
+		throw logic_error("Message digest creation context");
+	}
+	bool verified = false;
+	if (EVP_DigestVerifyInit(mdctx, NULL, EVP_sha256(), NULL, m_pktmp) == 1 &&
+		EVP_DigestVerifyUpdate(mdctx, (const void *)license.c_str(), (size_t)license.length()) == 1) {
+		verified = EVP_DigestVerifyFinal(mdctx, &raw_signature[0], raw_signature.size()) == 1;
+	}
+	// a failed verification leaves an error in the openssl queue
+	ERR_clear_error();
+	EVP_MD_CTX_destroy(mdctx);
+	return verified;
+}
+
+const string CryptoHelperLinux::publicKeyFingerprint() const {
+	const vector<unsigned char> public_key = exportPublicKey();
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int digest_len = 0;
+	if (EVP_Digest(&public_key[0], public_key.size(), digest, &digest_len, EVP_sha256(), NULL) != 1) {
+		throw logic_error("Error computing the public key fingerprint");
+	}
+	return toHex(digest, digest_len);
+}
+
 void CryptoHelperLinux::loadPrivateKey(const std::string &privateKey) {
 	if (m_pktmp) {
 		EVP_PKEY_free(m_pktmp);
@@ -154,6 +188,33 @@ void CryptoHelperLinux::loadPrivateKey(const std::string &privateKey) {
 	BIO_free(bio);
 }
 
+const vector<unsigned char> CryptoHelperLinux::exportPrivateKeyDer() const {
+	if (m_pktmp == NULL) {
+		throw logic_error(string("Export not initialized.Call generateKeyPair first."));
+	}
+	// pkcs#1 for RSA keys
+	const int size = i2d_PrivateKey(m_pktmp, nullptr);
+	vector<unsigned char> der(size > 0 ? size : 0);
+	unsigned char *position = der.data();
+	if (size <= 0 || i2d_PrivateKey(m_pktmp, &position) != size) {
+		ERR_clear_error();
+		throw logic_error("Private key can't be exported");
+	}
+	return der;
+}
+
+void CryptoHelperLinux::loadPrivateKeyDer(const unsigned char *der, size_t size) {
+	if (m_pktmp) {
+		EVP_PKEY_free(m_pktmp);
+	}
+	const unsigned char *position = der;
+	m_pktmp = d2i_PrivateKey(EVP_PKEY_RSA, nullptr, &position, (long)size);
+	if (!m_pktmp) {
+		ERR_clear_error();
+		throw logic_error("Private key (DER, " + to_string(size) + " bytes) can't be loaded");
+	}
+}
+
 const string CryptoHelperLinux::Opensslb64Encode(const size_t slen, const unsigned char *signature) const {
 	BIO *mem_bio = BIO_new(BIO_s_mem());
 	BIO *b64 = BIO_new(BIO_f_base64());
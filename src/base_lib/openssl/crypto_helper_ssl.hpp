@@ -33,7 +33,11 @@ public:
 	const virtual string exportPrivateKey() const;
 	const virtual std::vector<unsigned char> exportPublicKey() const;
 	virtual void loadPrivateKey(const std::string &privateKey);
+	const virtual std::vector<unsigned char> exportPrivateKeyDer() const;
+	virtual void loadPrivateKeyDer(const unsigned char *der, size_t size);
 	const virtual string signString(const string &stringToBeSigned) const;
+	virtual bool verifySignature(const string &license, const string &signature) const;
+	const virtual string publicKeyFingerprint() const;
 	virtual ~CryptoHelperLinux();
 };
 
@@ -37,7 +37,11 @@ public:
 	 * loads a private key in openssl pkcs#1 PEM encoded format.
 	 */
 	virtual void loadPrivateKey(const std::string &privateKey);
+	const virtual vector<unsigned char> exportPrivateKeyDer() const;
+	virtual void loadPrivateKeyDer(const unsigned char *der, size_t size);
 	const virtual string signString(const string &license) const;
+	virtual bool verifySignature(const string &license, const string &signature) const;
+	const virtual string publicKeyFingerprint() const;
 
 	virtual ~CryptoHelperWindows();
 };
@@ -0,0 +1,209 @@
+/*
+ * atomic_file.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <process.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "atomic_file.hpp"
+#include "metrics.hpp"
+#include "output_sink.hpp"
+#include "profiler.hpp"
+
+namespace license {
+using namespace std;
+namespace fs = boost::filesystem;
+
+#ifdef _WIN32
+static int open_temporary(const string &fname) {
+	return _open(fname.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+static int sync_fd(int fd) { return _commit(fd); }
+static int close_fd(int fd) { return _close(fd); }
+static int process_id() { return _getpid(); }
+static void sync_file(const string &fname) {
+	const int fd = _open(fname.c_str(), _O_WRONLY | _O_BINARY);
+	if (fd < 0 || _commit(fd) != 0) {
+		if (fd >= 0) _close(fd);
+		throw runtime_error("Can not synchronize file [" + fname + "]: " + strerror(errno));
+	}
+	_close(fd);
+}
+// directory entries can't be synchronized on windows, MoveFileEx(MOVEFILE_WRITE_THROUGH) is used instead
+static bool sync_directory(const string &) { return false; }
+static void replace_file(const string &from, const string &to) {
+	if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		throw runtime_error("Can not rename [" + from + "] to [" + to + "]");
+	}
+}
+#else
+static int open_temporary(const string &fname) {
+	return open(fname.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+}
+static int sync_fd(int fd) { return fsync(fd); }
+static int close_fd(int fd) { return close(fd); }
+static int process_id() { return getpid(); }
+static void sync_file(const string &fname) {
+	const int fd = open(fname.c_str(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0 || fsync(fd) != 0) {
+		const string error(strerror(errno));
+		if (fd >= 0) close(fd);
+		throw runtime_error("Can not synchronize file [" + fname + "]: " + error);
+	}
+	close(fd);
+}
+static bool sync_directory(const string &dir_name) {
+	const int fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		throw runtime_error("Can not open directory [" + dir_name + "]: " + strerror(errno));
+	}
+	// some filesystems don't support fsync on directories (EINVAL), the rename is durable anyway.
+	const bool synced = fsync(fd) == 0 || errno == EINVAL;
+	close(fd);
+	return synced;
+}
+static void replace_file(const string &from, const string &to) {
+	if (rename(from.c_str(), to.c_str()) != 0) {
+		throw runtime_error("Can not rename [" + from + "] to [" + to + "]: " + strerror(errno));
+	}
+}
+#endif
+
+// shared by all the writers: two writers of the same process may write the same file at the same time
+static atomic<unsigned long> tmp_counter(0);
+
+AtomicFileWriter::AtomicFileWriter(size_t commit_every, unsigned int commit_interval_ms)
+	: m_commit_every(commit_every == 0 ? 1 : commit_every), m_commit_interval_ms(commit_interval_ms), m_stats() {}
+
+const string AtomicFileWriter::write_temporary(const string &file_name, const Segment *segments, size_t count) {
+	const fs::path target(file_name);
+	const string tmp_name = (target.parent_path() / ("." + target.filename().string() + "." +
+													 to_string(process_id()) + "." + to_string(tmp_counter++) +
+													 ".tmp"))
+								.string();
+	const int fd = open_temporary(tmp_name);
+	if (fd < 0) {
+		throw runtime_error("Can not create file [" + file_name + "]: " + strerror(errno));
+	}
+	try {
+		FdSink(fd).write(&file_name, segments, count);
+	} catch (const exception &e) {
+		close_fd(fd);
+		fs::remove(tmp_name);
+		throw runtime_error("Error writing file [" + file_name + "]: " + e.what());
+	}
+	// in immediate mode the file is synchronized while it is still open, saving a reopen.
+	if (m_commit_every == 1 && sync_fd(fd) != 0) {
+		const string error(strerror(errno));
+		close_fd(fd);
+		fs::remove(tmp_name);
+		throw runtime_error("Can not synchronize file [" + file_name + "]: " + error);
+	}
+	close_fd(fd);
+	return tmp_name;
+}
+
+void AtomicFileWriter::write(const string &file_name, const char *data, size_t size) {
+	const Segment segment = {data, size};
+	write(file_name, &segment, 1);
+}
+
+void AtomicFileWriter::write(const string &file_name, const Segment *segments, size_t count) {
+	if (m_pending.find(file_name) != m_pending.end()) {
+		// the same file is written twice in a commit window: the first version must land before
+		commit();
+	}
+	const string tmp_name = write_temporary(file_name, segments, count);
+	if (m_pending.empty()) {
+		m_oldest_pending = chrono::steady_clock::now();
+	}
+	if (m_pending.insert(make_pair(file_name, tmp_name)).second) {
+		Metrics::add(Gauge::PENDING_COMMIT_FILES, 1);
+	}
+	if (m_pending.size() >= m_commit_every ||
+		(m_commit_interval_ms > 0 && chrono::steady_clock::now() - m_oldest_pending >=
+										 chrono::milliseconds(m_commit_interval_ms))) {
+		commit();
+	}
+}
+
+bool AtomicFileWriter::is_pending(const string &file_name) const {
+	return m_pending.find(file_name) != m_pending.end();
+}
+
+void AtomicFileWriter::commit() {
+	if (m_pending.empty()) {
+		return;
+	}
+	StageTimer timer(Stage::FILE_COMMIT);
+	const auto start = chrono::steady_clock::now();
+	set<string> directories;
+	if (m_commit_every > 1) {
+		for (const auto &it : m_pending) {
+			sync_file(it.second);
+		}
+	}
+	size_t files = 0;
+	// entries are dropped as soon as they are renamed: a failure leaves pending only the files not renamed yet
+	for (auto it = m_pending.begin(); it != m_pending.end(); it = m_pending.erase(it)) {
+		replace_file(it->second, it->first);
+		fs::path parent = fs::path(it->first).parent_path();
+		directories.insert(parent.empty() ? string(".") : parent.string());
+		Metrics::add(Gauge::PENDING_COMMIT_FILES, -1);
+		files++;
+	}
+	size_t synced_dirs = 0;
+	for (const auto &dir : directories) {
+		if (sync_directory(dir)) synced_dirs++;
+	}
+	const auto end = chrono::steady_clock::now();
+	const chrono::duration<double, milli> elapsed = end - start;
+	Metrics::observe(Histogram::COMMIT_LATENCY,
+					 (uint64_t)chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+	Metrics::add(Counter::FILE_COMMITS);
+	Metrics::add(Counter::FILES_COMMITTED, files);
+	m_stats.commits++;
+	m_stats.files += files;
+	m_stats.directories += synced_dirs;
+	m_stats.latency_ms += elapsed.count();
+}
+
+void AtomicFileWriter::print_summary(ostream &os) const {
+	os << "commits: " << m_stats.commits << ", files: " << m_stats.files;
+	if (m_stats.commits > 0) {
+		os << ", files per commit: " << (double)m_stats.files / m_stats.commits
+		   << ", commit latency: " << m_stats.latency_ms << " ms total, " << m_stats.latency_ms / m_stats.commits
+		   << " ms per commit";
+	}
+	os << endl;
+}
+
+AtomicFileWriter::~AtomicFileWriter() {
+	try {
+		commit();
+	} catch (const exception &e) {
+		cerr << "Error committing license files: " << e.what() << endl;
+	}
+}
+
+} /* namespace license */
@@ -0,0 +1,96 @@
+/*
+ * atomic_file.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_ATOMIC_FILE_HPP_
+#define SRC_LICENSE_GENERATOR_ATOMIC_FILE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <string>
+
+namespace license {
+
+struct Segment;
+
+/**
+ * Running totals of the durable commits of a writer.
+ */
+struct CommitStats {
+	size_t commits;
+	// number of files made durable
+	size_t files;
+	// number of directories synchronized, counted once per commit
+	size_t directories;
+	// time spent in fsync and rename, in milliseconds
+	double latency_ms;
+};
+
+/**
+ * Writes files atomically: the content is written to a temporary file in the destination folder, that is then
+ * renamed over the target. A reader (or a crash) never sees a half written file.
+ *
+ * <p>By default every write is made durable immediately (fsync of the file, rename, fsync of the folder).
+ * In group commit mode the temporary files are left pending and are synchronized and renamed together when
+ * #commit() is called, when <code>commit_every</code> files are pending, or when a file is written and the oldest
+ * pending file is older than <code>commit_interval_ms</code>. This amortizes the cost of fsync across many files.
+ * The interval is only checked by #write(): files stay pending until the next #commit() (or the destruction of the
+ * writer) if nothing else is written.</p>
+ */
+class AtomicFileWriter {
+private:
+	const size_t m_commit_every;
+	const unsigned int m_commit_interval_ms;
+	// target file name -> temporary file name, waiting for the next commit.
+	std::map<std::string, std::string> m_pending;
+	std::chrono::steady_clock::time_point m_oldest_pending;
+	CommitStats m_stats;
+
+	const std::string write_temporary(const std::string &file_name, const Segment *segments, size_t count);
+
+public:
+	/**
+	 * @param commit_every
+	 * 			number of files grouped in the same commit. 1 means every write is durable when #write() returns.
+	 * @param commit_interval_ms
+	 * 			age (in milliseconds) of the oldest pending file that makes the next #write() commit. 0 disables the
+	 * 			time limit.
+	 */
+	explicit AtomicFileWriter(size_t commit_every = 1, unsigned int commit_interval_ms = 0);
+	AtomicFileWriter(const AtomicFileWriter &) = delete;
+	AtomicFileWriter &operator=(const AtomicFileWriter &) = delete;
+
+	/**
+	 * Write (or replace) <code>file_name</code> with <code>data</code>.
+	 * Parent folders must already exist.
+	 */
+	void write(const std::string &file_name, const Segment *segments, size_t count);
+	void write(const std::string &file_name, const char *data, size_t size);
+	inline void write(const std::string &file_name, const std::string &data) {
+		write(file_name, data.data(), data.size());
+	}
+	/**
+	 * @return true if file_name has been written but it was not committed yet.
+	 */
+	bool is_pending(const std::string &file_name) const;
+	/**
+	 * Synchronize and rename all the pending files. If a file can't be renamed the files already renamed are no
+	 * longer pending, the others are left pending.
+	 */
+	void commit();
+	inline size_t pending() const { return m_pending.size(); }
+	inline const CommitStats &commit_stats() const { return m_stats; }
+	/**
+	 * Print a one line summary of the commits (number, files per commit and latency added).
+	 */
+	void print_summary(std::ostream &os) const;
+	virtual ~AtomicFileWriter();
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_ATOMIC_FILE_HPP_ */
@@ -0,0 +1,258 @@
+/*
+ * binary_license.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "../base_lib/base.h"
+#include "../base_lib/base64.h"
+#include "binary_license.hpp"
+
+namespace license {
+using namespace std;
+
+enum FieldType : uint8_t { STRING = 0, UINT = 1, DATE = 2, SIGNATURE = 3 };
+
+// id of a well known key is its position + 1, 0 means the key is written in full
+static const char *const KNOWN_KEYS[] = {LICENSE_VERSION,	   LICENSE_SIGNATURE,  PARAM_BEGIN_DATE,
+										 PARAM_EXPIRY_DATE,	   PARAM_CLIENT_SIGNATURE, PARAM_VERSION_FROM,
+										 PARAM_VERSION_TO,	   PARAM_EXTRA_DATA,   PARAM_MAGIC_NUMBER};
+static const size_t KNOWN_KEYS_COUNT = sizeof(KNOWN_KEYS) / sizeof(KNOWN_KEYS[0]);
+static const size_t HEADER_SIZE = 12;
+static const size_t SECTION_ENTRY_SIZE = 8;
+
+static uint8_t key_id(const string &key) {
+	for (size_t i = 0; i < KNOWN_KEYS_COUNT; i++) {
+		if (key == KNOWN_KEYS[i]) {
+			return (uint8_t)(i + 1);
+		}
+	}
+	return 0;
+}
+
+static void put_u16(string &out, size_t value) {
+	out.push_back((char)(value & 0xff));
+	out.push_back((char)((value >> 8) & 0xff));
+}
+
+static void put_u32(string &out, size_t value) {
+	put_u16(out, value & 0xffff);
+	put_u16(out, (value >> 16) & 0xffff);
+}
+
+static void set_u32(string &out, size_t offset, size_t value) {
+	for (size_t i = 0; i < 4; i++) {
+		out[offset + i] = (char)((value >> (8 * i)) & 0xff);
+	}
+}
+
+static void put_string(string &out, const string &value, size_t max_length, const char *what) {
+	if (value.size() > max_length) {
+		throw invalid_argument(string(what) + " too long for a binary license: " + value.substr(0, 32) + "...");
+	}
+	out.append(value);
+}
+
+static bool is_digits(const string &value, size_t start, size_t length) {
+	for (size_t i = start; i < start + length; i++) {
+		if (value[i] < '0' || value[i] > '9') {
+			return false;
+		}
+	}
+	return true;
+}
+
+// decimal number without leading zeros, that fits 32 bits
+static bool as_uint(const string &value, uint32_t &number) {
+	if (value.empty() || value.size() > 10 || !is_digits(value, 0, value.size()) ||
+		(value[0] == '0' && value.size() > 1)) {
+		return false;
+	}
+	const unsigned long long parsed = stoull(value);
+	number = (uint32_t)parsed;
+	return parsed <= 0xffffffffull;
+}
+
+// YYYY-MM-DD, as written by the date normalization
+static bool is_date(const string &value) {
+	return value.size() == 10 && value[4] == '-' && value[7] == '-' && is_digits(value, 0, 4) &&
+		   is_digits(value, 5, 2) && is_digits(value, 8, 2);
+}
+
+static void encode_value(const string &key, const string &value, uint8_t &type, string &encoded) {
+	uint32_t number;
+	encoded.clear();
+	if (key == LICENSE_SIGNATURE) {
+		const vector<uint8_t> raw = unbase64(value);
+		if (!raw.empty() && base64(raw.data(), raw.size()) == value) {
+			type = SIGNATURE;
+			encoded.assign(raw.begin(), raw.end());
+			return;
+		}
+	} else if (is_date(value)) {
+		type = DATE;
+		put_u16(encoded, stoul(value.substr(0, 4)));
+		encoded.push_back((char)stoul(value.substr(5, 2)));
+		encoded.push_back((char)stoul(value.substr(8, 2)));
+		return;
+	} else if (as_uint(value, number)) {
+		type = UINT;
+		put_u32(encoded, number);
+		return;
+	}
+	type = STRING;
+	encoded = value;
+}
+
+bool is_binary_license(const char *data, size_t size) {
+	return size >= HEADER_SIZE && memcmp(data, BINARY_LICENSE_MAGIC, 4) == 0;
+}
+
+void encode_binary_license(const std::vector<LicenseSection> &sections, std::string &out) {
+	if (sections.size() > 0xffff) {
+		throw invalid_argument("too many sections for a binary license");
+	}
+	out.clear();
+	out.append(BINARY_LICENSE_MAGIC, 4);
+	put_u16(out, BINARY_LICENSE_VERSION);
+	put_u16(out, sections.size());
+	put_u32(out, 0);
+	const size_t table_start = out.size();
+	out.append(sections.size() * SECTION_ENTRY_SIZE, '\0');
+	string encoded;
+	for (size_t s = 0; s < sections.size(); s++) {
+		const LicenseSection &section = sections[s];
+		const size_t section_start = out.size();
+		out.push_back((char)min<size_t>(section.name.size(), 0xff));
+		put_string(out, section.name, 0xff, "section name");
+		if (section.fields.size() > 0xffff) {
+			throw invalid_argument("too many fields in section " + section.name);
+		}
+		put_u16(out, section.fields.size());
+		for (const LicenseField &field : section.fields) {
+			uint8_t type;
+			encode_value(field.key, field.value, type, encoded);
+			const uint8_t id = key_id(field.key);
+			out.push_back((char)type);
+			out.push_back((char)id);
+			if (id == 0) {
+				out.push_back((char)min<size_t>(field.key.size(), 0xff));
+				put_string(out, field.key, 0xff, "key");
+			}
+			put_u16(out, min<size_t>(encoded.size(), 0xffff));
+			put_string(out, encoded, 0xffff, "value");
+		}
+		set_u32(out, table_start + s * SECTION_ENTRY_SIZE, section_start);
+		set_u32(out, table_start + s * SECTION_ENTRY_SIZE + 4, out.size() - section_start);
+	}
+	set_u32(out, 8, out.size());
+}
+
+namespace {
+// bounds checked reader of a binary license
+class Reader {
+private:
+	const unsigned char *m_data;
+	size_t m_position;
+	const size_t m_end;
+
+public:
+	Reader(const char *data, size_t start, size_t end)
+		: m_data(reinterpret_cast<const unsigned char *>(data)), m_position(start), m_end(end) {}
+	const unsigned char *take(size_t size) {
+		if (size > m_end - m_position) {
+			throw runtime_error("corrupted binary license: truncated data");
+		}
+		const unsigned char *bytes = m_data + m_position;
+		m_position += size;
+		return bytes;
+	}
+	uint8_t u8() { return *take(1); }
+	uint16_t u16() {
+		const unsigned char *bytes = take(2);
+		return (uint16_t)(bytes[0] | (bytes[1] << 8));
+	}
+	uint32_t u32() {
+		const unsigned char *bytes = take(4);
+		return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	}
+	void text(size_t size, string &out) {
+		const unsigned char *bytes = take(size);
+		out.assign(reinterpret_cast<const char *>(bytes), size);
+	}
+	inline bool at_end() const { return m_position == m_end; }
+};
+}  // namespace
+
+static void decode_value(uint8_t type, Reader &value, size_t size, string &out) {
+	switch (type) {
+		case STRING:
+			value.text(size, out);
+			return;
+		case UINT:
+			out = to_string(value.u32());
+			break;
+		case DATE: {
+			const unsigned year = value.u16(), month = value.u8(), day = value.u8();
+			char date[16];
+			snprintf(date, sizeof(date), "%04u-%02u-%02u", year, month, day);
+			out = date;
+			break;
+		}
+		case SIGNATURE:
+			out = base64(value.take(size), size);
+			return;
+		default:
+			throw runtime_error("corrupted binary license: unknown field type " + to_string(type));
+	}
+	if (!value.at_end()) {
+		throw runtime_error("corrupted binary license: wrong value size");
+	}
+}
+
+void decode_binary_license(const char *data, size_t size, std::vector<LicenseSection> &sections) {
+	sections.clear();
+	if (!is_binary_license(data, size)) {
+		throw runtime_error("not a binary license");
+	}
+	Reader header(data, 4, size);
+	const uint16_t version = header.u16();
+	if (version != BINARY_LICENSE_VERSION) {
+		throw runtime_error("binary license version " + to_string(version) + " not supported");
+	}
+	const uint16_t section_count = header.u16();
+	if (header.u32() != size) {
+		throw runtime_error("corrupted binary license: wrong size");
+	}
+	sections.resize(section_count);
+	for (size_t s = 0; s < section_count; s++) {
+		const size_t offset = header.u32(), section_size = header.u32();
+		if (offset > size || section_size > size - offset) {
+			throw runtime_error("corrupted binary license: section out of bounds");
+		}
+		Reader section(data, offset, offset + section_size);
+		LicenseSection &decoded = sections[s];
+		section.text(section.u8(), decoded.name);
+		decoded.fields.resize(section.u16());
+		for (LicenseField &field : decoded.fields) {
+			const uint8_t type = section.u8(), id = section.u8();
+			if (id == 0) {
+				section.text(section.u8(), field.key);
+			} else if (id <= KNOWN_KEYS_COUNT) {
+				field.key = KNOWN_KEYS[id - 1];
+			} else {
+				throw runtime_error("corrupted binary license: unknown key id " + to_string(id));
+			}
+			const size_t value_size = section.u16();
+			const unsigned char *value = section.take(value_size);
+			Reader value_reader(reinterpret_cast<const char *>(value), 0, value_size);
+			decode_value(type, value_reader, value_size, field.value);
+		}
+	}
+}
+
+} /* namespace license */
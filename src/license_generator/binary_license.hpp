@@ -0,0 +1,68 @@
+/*
+ * binary_license.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_BINARY_LICENSE_HPP_
+#define SRC_LICENSE_GENERATOR_BINARY_LICENSE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace license {
+
+/**
+ * First bytes of a binary license.
+ */
+#define BINARY_LICENSE_MAGIC "LCCB"
+#define BINARY_LICENSE_VERSION 1
+
+struct LicenseField {
+	std::string key;
+	std::string value;
+};
+
+/**
+ * A section of a license (a feature) with its fields in file order, as text: the same values the INI format
+ * stores.
+ */
+struct LicenseSection {
+	std::string name;
+	std::vector<LicenseField> fields;
+};
+
+/**
+ * Compact binary container for licenses, an alternative to the INI text format.
+ *
+ * <p>All integers are little endian.
+ * <pre>
+ * header      magic "LCCB" (4 bytes), format version (u16), section count (u16), license size in bytes (u32)
+ * section table   for each section: offset from the start of the license (u32), size (u32)
+ * section     name length (u8), name, field count (u16), fields
+ * field       type (u8), key id (u8), [key length (u8), key: only if key id is 0], value length (u16), value
+ * </pre>
+ * Well known keys (lic_ver, sig, valid-from...) are stored as a one byte id. Values are typed: UINT (u32), DATE
+ * (year u16, month u8, day u8), SIGNATURE (the raw bytes of the base64 signature) or STRING (the text as is). A typed
+ * encoding is used only when it turns back into exactly the same text, otherwise the value is stored as a STRING.</p>
+ *
+ * <p>Signatures are not computed on the container: they are computed on the canonical text of each section (upper
+ * case section name followed by the trimmed keys and values, signature excluded, in key order), built from the text
+ * values. Since the binary container gives back the same text values, a license keeps its signatures when it is
+ * converted between the two formats.</p>
+ */
+bool is_binary_license(const char *data, size_t size);
+/**
+ * @throws invalid_argument if a name, a key or a value is too long for the format.
+ */
+void encode_binary_license(const std::vector<LicenseSection> &sections, std::string &out);
+/**
+ * @throws runtime_error if the data is not a well formed binary license.
+ */
+void decode_binary_license(const char *data, size_t size, std::vector<LicenseSection> &sections);
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_BINARY_LICENSE_HPP_ */
@@ -7,7 +7,10 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
@@ -17,7 +20,9 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -34,7 +39,21 @@
 #include "../base_lib/base64.h"
 #include "command_line-parser.hpp"
 #include "license.hpp"
+#include "json_writer.hpp"
+#include "keystore.hpp"
+#include "license_bundle.hpp"
+#include "license_index.hpp"
+#include "license_layout.hpp"
+#include "license_ledger.hpp"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include "output_sink.hpp"
+#include "parameter_schema.hpp"
+#include "profiler.hpp"
+#include "project_context.hpp"
 #include "project.hpp"
+#include "project_index.hpp"
 
 namespace license {
 namespace po = boost::program_options;
@@ -49,7 +68,10 @@ static void printHelpHeader(const char *prog_name) {
 static void printBasicHelp(const char *prog_name) {
 	printHelpHeader(prog_name);
 	cout << fs::path(prog_name).filename().string() << " [command] [options]" << endl;
-	cout << " available commands: \"project initialize\", \"project list\", \"license issue\", \"license list\""
+	cout << " available commands: \"project initialize\", \"project init-batch\", \"project list\", \"license issue\","
+			" \"license batch\", \"license list\", \"license verify\", \"license resign\","
+			" \"license convert\", \"bundle list\", \"bundle extract\", \"ledger find\", \"ledger compact\","
+			" \"keystore import\", \"keystore export\", \"keystore list\""
 		 << endl;
 	cout << " to see help on specific command options type: " << prog_name << " [command] --help" << endl << endl;
 }
@@ -58,6 +80,20 @@ CommandLineParser::CommandLineParser() {}
 
 CommandLineParser::~CommandLineParser() {}
 
+// started when the options of the command are known, stopped when the command ends
+static unique_ptr<MetricsReporter> metrics_reporter;
+
+static void start_metrics(const po::variables_map &vm) {
+	if (vm.count("metrics-file") > 0 && !metrics_reporter) {
+		const unsigned int interval = vm["metrics-interval"].as<unsigned int>();
+		if (interval == 0) {
+			throw invalid_argument("metrics-interval should be at least 1 second");
+		}
+		metrics_reporter.reset(
+			new MetricsReporter(vm["metrics-file"].as<string>(), chrono::milliseconds(interval * 1000ull)));
+	}
+}
+
 static bool rerunBoostPO(const po::parsed_options &parsed, const po::options_description &project_desc,
 						 po::variables_map &vm, const char **argv, const std::string &command_for_logging,
 						 const po::options_description &global) {
@@ -65,9 +101,13 @@ static bool rerunBoostPO(const po::parsed_options &parsed, const po::options_des
 	// (positional) command name, so we need to erase that.
 	// Parse again...
 	bool cont = false;
+	StageTimer parse_timer(Stage::OPTION_PARSING);
 	std::vector<std::string> opts = po::collect_unrecognized(parsed.options, po::include_positional);
 	opts.erase(opts.begin());
-	po::store(po::command_line_parser(opts).options(project_desc).run(), vm);
+	// global options (eg. --profile) may follow the command
+	po::options_description command_options;
+	command_options.add(project_desc).add(global);
+	po::store(po::command_line_parser(opts).options(command_options).run(), vm);
 	if (vm.find("help") == vm.end()) {
 		try {
 			po::notify(vm);
@@ -85,6 +125,9 @@ static bool rerunBoostPO(const po::parsed_options &parsed, const po::options_des
 		global.print(cout);
 		project_desc.print(cout);
 	}
+	if (cont) {
+		start_metrics(vm);
+	}
 	return cont;
 }
 
@@ -96,6 +139,7 @@ static void initializeProject(const po::parsed_options &parsed, po::variables_ma
 	boost::optional<std::string> public_key;
 	std::string project_folder;
 	std::string templates_folder;
+	bool force = false;
 	project_desc.add_options()  //
 		("project-name,n", po::value<std::string>(&project_name)->required(), "New project name (required).")  //
 		(PARAM_PRIMARY_KEY, po::value<boost::optional<std::string>>(&primary_key),
@@ -106,57 +150,255 @@ static void initializeProject(const po::parsed_options &parsed, po::variables_ma
 		 "path to where all the projects configurations are stored.")  //
 		("templates,t", po::value<std::string>(&templates_folder)->default_value("."),
 		 "path to the templates folder.")  //
+		("force", po::bool_switch(&force),
+		 "Generate a new key pair if the project already has one (key rotation). Licenses already issued must be "
+		 "signed again with license resign. The replaced key is kept in " PREVIOUS_PRIVATE_KEY_FNAME
+		 ": the key can't be rotated again until license resign --retire-previous-key removes it.")  //
 		("help", "Print this help.");  //
 	if (rerunBoostPO(parsed, project_desc, vm, argv, "project init", global)) {
 		// cout << templates_folder.is_initialized() << endl;
-		Project project(project_name, project_folder, templates_folder);
+		Project project(project_name, project_folder, templates_folder, force);
 		project.initialize();
 	}
 }
 
+static bool listProjects(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+						 const po::options_description &global) {
+	po::options_description project_desc("project list options");
+	string projects_folder;
+	bool rebuild = false;
+	project_desc.add_options()  //
+		("projects-folder,p", po::value<string>(&projects_folder)->default_value("."),
+		 "path to where project configurations are stored.")  //
+		("rebuild", po::bool_switch(&rebuild),
+		 "Build the index of the projects folder again from the project manifests.")  //
+		("help", "Print this help.");  //
+	if (!rerunBoostPO(parsed, project_desc, vm, argv, "project list", global)) {
+		return true;
+	}
+	vector<ProjectManifest> projects;
+	try {
+		projects = rebuild ? rebuild_project_index(projects_folder) : load_project_index(projects_folder);
+	} catch (const exception &e) {
+		cerr << "Error listing projects: " << e.what() << endl;
+		return false;
+	}
+	size_t name_width = 4;
+	for (const auto &project : projects) {
+		name_width = max(name_width, project.name.size());
+	}
+	cout << left << setw(name_width) << "NAME" << "  " << setw(20) << "CREATED" << "  " << setw(10) << "KEY"
+		 << "  FINGERPRINT" << endl;
+	for (const auto &project : projects) {
+		cout << setw(name_width) << project.name << "  " << setw(20) << project.created << "  " << setw(10)
+			 << project.key_algorithm << "  " << project.key_fingerprint.substr(0, 16) << '\n';
+	}
+	cout << right << projects.size() << " projects" << endl;
+	return true;
+}
+
+struct ProjectOrder {
+	size_t line_number;
+	string name;
+	string projects_folder;
+};
+
+/**
+ * Initialize many projects. Each line of the input file is a project, the first line holds the column names:
+ * project-name (required) and projects-folder. Key pairs are generated on a pool of threads, the public key templates
+ * are parsed once for all the projects.
+ */
+static bool initializeProjectBatch(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+								   const po::options_description &global) {
+	po::options_description project_desc("project init-batch options");
+	string orders_file;
+	string projects_folder;
+	string templates_folder;
+	unsigned int jobs;
+	bool force = false;
+	project_desc.add_options()  //
+		("input,i", po::value<string>(&orders_file)->required(),
+		 "Tab separated file, one project per line. The first line contains the column names: project-name "
+		 "(required) and projects-folder.")  //
+		("projects-folder,p", po::value<string>(&projects_folder)->default_value("."),
+		 "path to where the projects are stored, when the input file doesn't specify it.")  //
+		("templates,t", po::value<string>(&templates_folder)->default_value("."), "path to the templates folder.")  //
+		("jobs,j", po::value<unsigned int>(&jobs)->default_value(default_jobs()),
+		 "Number of projects initialized in parallel.")  //
+		("force", po::bool_switch(&force), "Generate new keys for the projects that already have them.")  //
+		("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, project_desc, vm, argv, "project init-batch", global)) {
+		return true;
+	}
+	ifstream orders(orders_file);
+	if (!orders.is_open()) {
+		throw runtime_error("Can not open [" + orders_file + "]");
+	}
+	string line;
+	vector<string> columns;
+	if (!getline(orders, line)) {
+		throw runtime_error("[" + orders_file + "] is empty");
+	}
+	boost::algorithm::split(columns, boost::trim_copy(line), boost::is_any_of("\t"));
+	const size_t name_idx = find(columns.begin(), columns.end(), "project-name") - columns.begin();
+	const size_t folder_idx = find(columns.begin(), columns.end(), "projects-folder") - columns.begin();
+	if (name_idx == columns.size()) {
+		throw invalid_argument("column project-name not found in [" + orders_file + "]");
+	}
+	vector<ProjectOrder> projects;
+	set<string> unique_projects;
+	vector<string> values;
+	size_t line_number = 1, failed = 0;
+	while (getline(orders, line)) {
+		line_number++;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty() || line[0] == '#') continue;
+		boost::algorithm::split(values, line, boost::is_any_of("\t"));
+		if (values.size() != columns.size()) {
+			cerr << orders_file << ":" << line_number << ": expected " << columns.size() << " columns, found "
+				 << values.size() << endl;
+			failed++;
+			continue;
+		}
+		ProjectOrder order;
+		order.line_number = line_number;
+		order.name = values[name_idx];
+		order.projects_folder =
+			folder_idx < columns.size() && !values[folder_idx].empty() ? values[folder_idx] : projects_folder;
+		// the same project initialized twice in parallel would race on its files
+		if (!unique_projects.insert((fs::path(order.projects_folder) / order.name).string()).second) {
+			cerr << orders_file << ":" << line_number << ": " << order.name << ": duplicate project" << endl;
+			failed++;
+			continue;
+		}
+		projects.push_back(order);
+	}
+
+	const auto start = chrono::steady_clock::now();
+	const shared_ptr<const KeyTemplates> key_templates = KeyTemplates::get(templates_folder);
+	atomic<size_t> generated(0), existing(0), errors(0);
+	mutex results_mutex;
+	// the project indexes are updated once per projects folder, at the end.
+	map<string, vector<ProjectManifest>> manifests;
+	parallel_for(projects.size(), jobs, [&](size_t i) {
+		const ProjectOrder &order = projects[i];
+		try {
+			Project project(order.name, order.projects_folder, key_templates, force);
+			project.initialize(false);
+			(project.keys_generated() ? generated : existing)++;
+			lock_guard<mutex> guard(results_mutex);
+			manifests[order.projects_folder].push_back(project.manifest());
+		} catch (const exception &e) {
+			errors++;
+			lock_guard<mutex> guard(results_mutex);
+			cerr << orders_file << ":" << order.line_number << ": " << order.name << ": " << e.what() << endl;
+		}
+	});
+	for (const auto &it : manifests) {
+		update_project_index(it.first, it.second);
+	}
+	failed += errors;
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	const size_t initialized = generated + existing;
+	cout << "Projects initialized: " << initialized << " (keys generated: " << generated
+		 << ", already existing: " << existing << "), failed: " << failed << ", " << elapsed.count() << " s ("
+		 << (elapsed.count() > 0 ? initialized / elapsed.count() : 0) << " projects/s, " << jobs << " jobs)" << endl;
+	return failed == 0;
+}
+
+/**
+ * Layout of the licenses folder, if the command line specifies one.
+ */
+static unique_ptr<LicenseLayout> open_layout(const po::variables_map &vm) {
+	unique_ptr<LicenseLayout> layout;
+	if (vm.count(PARAM_LICENSES_FOLDER) == 0) {
+		if (vm.count(PARAM_SHARD_FANOUT) > 0) {
+			throw invalid_argument(PARAM_SHARD_FANOUT " requires " PARAM_LICENSES_FOLDER);
+		}
+		return layout;
+	}
+	const string &folder = vm[PARAM_LICENSES_FOLDER].as<string>();
+	if (vm.count(PARAM_SHARD_FANOUT) > 0) {
+		unsigned int fanout;
+		try {
+			fanout = boost::lexical_cast<unsigned int>(vm[PARAM_SHARD_FANOUT].as<string>());
+		} catch (const boost::bad_lexical_cast &) {
+			throw invalid_argument(PARAM_SHARD_FANOUT " should be a number");
+		}
+		layout.reset(new LicenseLayout(LicenseLayout::open(folder, fanout)));
+	} else {
+		layout.reset(new LicenseLayout(LicenseLayout::open(folder)));
+	}
+	return layout;
+}
+
+// format named on the command line
+static LicenseFormat license_format(const string &format_name) {
+	if (format_name == "ini") {
+		return LicenseFormat::INI;
+	} else if (format_name == "binary") {
+		return LicenseFormat::BINARY;
+	} else if (format_name == "json") {
+		return LicenseFormat::JSON;
+	}
+	throw invalid_argument("unknown license format [" + format_name + "], use ini, binary or json");
+}
+
+// project whose key is in the project folder or, if keystore_file is not empty, in a keystore
+static unique_ptr<const ProjectContext> open_project(const string &project_folder, const string &keystore_file) {
+	if (keystore_file.empty()) {
+		return unique_ptr<const ProjectContext>(new ProjectContext(project_folder));
+	}
+	return unique_ptr<const ProjectContext>(
+		new ProjectContext(project_folder, make_shared<const Keystore>(keystore_file)));
+}
+
 static void issueLicense(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
 						 const po::options_description &global) {
 	po::options_description license_desc("license issue options");
-	string license_name;
-	string *license_name_ptr = nullptr;
-	string project_folder;
-	// string output;
-	unsigned int magic_num = 0;
-	bool base64 = false;
-	license_desc.add_options()	//
-		(PARAM_BASE64 ",b", po::bool_switch(&base64),
-		 "Encode license as base64 for inclusion in environment variables.")  //
-		(PARAM_BEGIN_DATE, po::value<string>(),
-		 "Specify the start of the validity for this license. "
-		 " Format YYYYMMDD. If not specified defaults to today")  //
-		(PARAM_EXPIRY_DATE ",e", po::value<string>(),
-		 "Specify the expire date for this license. "
-		 " Format YYYYMMDD. If not specified the license won't expire")	 //
-		(PARAM_CLIENT_SIGNATURE ",s", po::value<string>(),
-		 "The signature of the hardware that requires the license. It should be in the format XXXX-XXXX-XXXX."
-		 " If not specified the license won't be linked to a specific hardware (eg. demo license).")  //
-		(PARAM_LICENSE_OUTPUT ",o", po::value<string>(&license_name),
-		 "License output file name. May contain / that will be interpreded as subfolders.")	 //
-		(PARAM_FEATURE_NAMES ",f", po::value<boost::optional<std::string>>(),
-		 "Feature names: comma separate list of project features to enable. if not specified will be taken as project "
-		 "name.")  //
-		(PARAM_PRIMARY_KEY, po::value<string>(), "Primary key location, in case it is not in default folder")  //
-		(PARAM_PROJECT_FOLDER ",p", po::value<string>(&project_folder)->default_value("."),
-		 "path to where project configurations and licenses are stored.")  //
-		(PARAM_VERSION_FROM, po::value<string>()->default_value("0", "All Versions"),
-		 "Specify the first version of the software this license apply to.")  //
-		(PARAM_VERSION_TO, po::value<string>()->default_value("0", "All Versions"),	 //
-		 "Specify the last version of the software this license apply to.")	 //
-		(PARAM_EXTRA_DATA ",x", po::value<string>(), "Specify extra data to be included into the license")	//
-		("help,h", "Print this help.");	 //
+	for (const ParameterSchema &param : PARAMETER_SCHEMA) {
+		if (param.description == nullptr) {
+			continue;
+		}
+		string option_name(param.name);
+		if (param.short_name != 0) {
+			option_name = option_name + "," + param.short_name;
+		}
+		if (param.kind == ParamKind::FLAG) {
+			license_desc.add_options()(option_name.c_str(), po::bool_switch(), param.description);
+		} else if (param.default_value == nullptr) {
+			license_desc.add_options()(option_name.c_str(), po::value<string>(), param.description);
+		} else if (param.default_description == nullptr) {
+			license_desc.add_options()(option_name.c_str(), po::value<string>()->default_value(param.default_value),
+									   param.description);
+		} else {
+			license_desc.add_options()(
+				option_name.c_str(),
+				po::value<string>()->default_value(param.default_value, param.default_description),
+				param.description);
+		}
+	}
+	license_desc.add_options()("help,h", "Print this help.");
 	if (rerunBoostPO(parsed, license_desc, vm, argv, "license issue", global)) {
-		if (!license_name.empty()) {
-			license_name_ptr = &license_name;
+		string license_name;
+		if (vm.count(PARAM_LICENSE_OUTPUT) > 0) {
+			license_name = vm[PARAM_LICENSE_OUTPUT].as<string>();
 		}
-		License license(license_name_ptr, project_folder, base64);
+		const unique_ptr<LicenseLayout> layout = open_layout(vm);
+		if (layout && !license_name.empty()) {
+			license_name = layout->path(license_name);
+		}
+		const string *license_name_ptr = license_name.empty() ? nullptr : &license_name;
+		const bool base64 = vm[PARAM_BASE64].as<bool>();
+		const unique_ptr<const ProjectContext> project = open_project(
+			vm[PARAM_PROJECT_FOLDER].as<string>(), vm.count(PARAM_KEYSTORE) > 0 ? vm[PARAM_KEYSTORE].as<string>() : "");
+		License license(*project, license_name_ptr, base64);
+		license.set_format(license_format(vm[PARAM_FORMAT].as<string>()));
 		for (const auto &it : vm) {
 			auto &value = it.second.value();
-			if (it.first != "command" && it.first != "subargs" && it.first != "base64") {
+			// global options (--verbose, --profile...) are not license parameters
+			if (it.first != "command" && it.first != "subargs" && it.first != PARAM_BASE64 &&
+				global.find_nothrow(it.first, false) == nullptr) {
 				if (auto v = boost::any_cast<std::string>(&value)) {
 					license.add_parameter(it.first, *v);
 				} else if (auto v = boost::any_cast<boost::optional<std::string>>(value)) {
@@ -169,25 +411,1008 @@ static void issueLicense(const po::parsed_options &parsed, po::variables_map &vm
 		try {
 			license.write_license();
 			cout << "License written " << endl;
+			// the line above is parsed by scripts, it stays as it is
+			if (vm.count("verbose") > 0) {
+				cout << "Sections signed: " << license.signed_sections()
+					 << ", unchanged: " << license.unchanged_sections() << endl;
+			}
 		} catch (exception &ex) {
 			cerr << "License writing error: " << ex.what() << endl;
 		}
 	}
 }
 
+/**
+ * Issue many licenses of the same project. Each line of the input file is a license, the first line holds the
+ * names of the parameters (tab separated).
+ */
+static bool issueLicenseBatch(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+							  const po::options_description &global) {
+	po::options_description batch_desc("license batch options");
+	string orders_file;
+	string project_folder;
+	bool base64 = false;
+	string format_name;
+	size_t commit_every;
+	unsigned int commit_interval;
+	int output_fd;
+	string bundle_file;
+	string keystore_file;
+	string results_file;
+	batch_desc.add_options()  //
+		("input,i", po::value<string>(&orders_file)->required(),
+		 "Tab separated file, one license per line. The first line contains the parameter names, eg: " PARAM_LICENSE_OUTPUT
+		 " " PARAM_FEATURE_NAMES " " PARAM_EXPIRY_DATE ". Column " PARAM_LICENSE_OUTPUT
+		 " is required, unless --output-fd is specified.")  //
+		(PARAM_PROJECT_FOLDER ",p", po::value<string>(&project_folder)->default_value("."),
+		 "path to where project configurations and licenses are stored.")  //
+		(PARAM_BASE64 ",b", po::bool_switch(&base64),
+		 "Encode license as base64 for inclusion in environment variables.")  //
+		(PARAM_FORMAT, po::value<string>(&format_name)->default_value("ini"),
+		 "Format of the licenses: ini, binary or json.")  //
+		(PARAM_LICENSES_FOLDER ",l", po::value<string>(),
+		 "Folder the " PARAM_LICENSE_OUTPUT " column is relative to.")  //
+		(PARAM_SHARD_FANOUT, po::value<string>(),
+		 "Spread the licenses of " PARAM_LICENSES_FOLDER " among this many hash-prefixed subfolders.")  //
+		("commit-every", po::value<size_t>(&commit_every)->default_value(64),
+		 "Number of license files made durable together (group commit).")  //
+		("commit-interval", po::value<unsigned int>(&commit_interval)->default_value(1000),
+		 "Commit the pending license files when a license is written and the oldest has waited this long "
+		 "(milliseconds).")  //
+		("output-fd", po::value<int>(&output_fd)->default_value(-1),
+		 "Write all the licenses, one after the other, to this open file descriptor (eg. 1 for standard output or a "
+		 "pipe opened by the caller) instead of one file per license.")  //
+		(PARAM_KEYSTORE, po::value<string>(&keystore_file),
+		 "Keystore holding the key of the project (see keystore import), used instead of the key in the project "
+		 "folder.")  //
+		("bundle", po::value<string>(&bundle_file),
+		 "Write all the licenses in this bundle file instead of one file per license. The " PARAM_LICENSE_OUTPUT
+		 " column is the name of the license in the bundle.")  //
+		("results", po::value<string>(&results_file),
+		 "Write the outcome of each line of the input file to this file, as JSON lines: {\"line\": 2, \"license\": "
+		 "\"a.lic\", \"issued\": true, \"signed_sections\": 1, \"unchanged_sections\": 0} or {\"line\": 3, "
+		 "\"license\": \"b.lic\", \"issued\": false, \"error\": \"...\"}.")  //
+		("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, batch_desc, vm, argv, "license batch", global)) {
+		return true;
+	}
+	const LicenseFormat format = license_format(format_name);
+	ifstream orders(orders_file);
+	if (!orders.is_open()) {
+		throw runtime_error("Can not open [" + orders_file + "]");
+	}
+	string line;
+	vector<string> columns;
+	if (!getline(orders, line)) {
+		throw runtime_error("[" + orders_file + "] is empty");
+	}
+	boost::algorithm::split(columns, boost::trim_copy(line), boost::is_any_of("\t"));
+	const auto output_column = find(columns.begin(), columns.end(), PARAM_LICENSE_OUTPUT);
+	if (output_column == columns.end() && output_fd < 0) {
+		throw invalid_argument("column " PARAM_LICENSE_OUTPUT " not found in [" + orders_file + "]");
+	}
+	const size_t output_idx = output_column - columns.begin();
+	const size_t client_idx = find(columns.begin(), columns.end(), PARAM_CLIENT_SIGNATURE) - columns.begin();
+	// licenses written to the standard output can't be mixed with the report
+	ostream &report = output_fd == 1 ? cerr : cout;
+	const unique_ptr<LicenseLayout> layout = open_layout(vm);
+	unique_ptr<BundleWriter> bundle;
+	string bundle_buffer;
+	BufferSink bundle_sink(bundle_buffer);
+	if (!bundle_file.empty()) {
+		if (output_fd >= 0 || layout) {
+			throw invalid_argument("--bundle can't be used with --output-fd or " PARAM_LICENSES_FOLDER);
+		}
+		if (output_column == columns.end()) {
+			throw invalid_argument("column " PARAM_LICENSE_OUTPUT " not found in [" + orders_file + "]");
+		}
+		bundle.reset(new BundleWriter(bundle_file));
+	}
+
+	const auto start = chrono::steady_clock::now();
+	const MetricsSnapshot metrics_start = Metrics::snapshot();
+	const unique_ptr<const ProjectContext> project_context = open_project(project_folder, keystore_file);
+	const ProjectContext &project = *project_context;
+	AtomicFileWriter file_writer(commit_every, commit_interval);
+	FdSink fd_sink(output_fd);
+	string license_name;
+	License license(project, &license_name, base64, &file_writer);
+	if (output_fd >= 0) {
+		license.set_sink(&fd_sink);
+	} else if (bundle) {
+		license.set_sink(&bundle_sink);
+	}
+	license.set_format(format);
+	ofstream results;
+	if (!results_file.empty()) {
+		results.open(results_file, ios::trunc);
+		if (!results.is_open()) {
+			throw runtime_error("can't create [" + results_file + "]");
+		}
+	}
+	string result_line;
+	size_t line_number = 1, issued = 0, failed = 0, signed_sections = 0, unchanged_sections = 0;
+	vector<string> values;
+	while (getline(orders, line)) {
+		line_number++;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty() || line[0] == '#') continue;
+		try {
+			boost::algorithm::split(values, line, boost::is_any_of("\t"));
+			if (values.size() != columns.size()) {
+				throw invalid_argument("expected " + to_string(columns.size()) + " columns, found " +
+									   to_string(values.size()));
+			}
+			license_name = output_idx < values.size() ? values[output_idx] : string();
+			if (layout && !license_name.empty()) {
+				license_name = layout->path(license_name);
+			}
+			if (bundle && bundle->contains(license_name)) {
+				// checked before issuing: the license must not be recorded in the ledger
+				throw invalid_argument("license [" + license_name + "] is already in the bundle");
+			}
+			license.reset(&license_name);
+			for (size_t i = 0; i < columns.size(); i++) {
+				if (i != output_idx && !values[i].empty()) {
+					license.add_parameter(columns[i], values[i]);
+				}
+			}
+			bundle_buffer.clear();
+			license.write_license();
+			if (bundle) {
+				bundle->add(license_name, client_idx < values.size() ? values[client_idx] : string(), bundle_buffer);
+			}
+			issued++;
+			signed_sections += license.signed_sections();
+			unchanged_sections += license.unchanged_sections();
+			if (results.is_open()) {
+				result_line.clear();
+				JsonWriter(result_line)
+					.begin_object()
+					.key("line")
+					.number(line_number)
+					.key("license")
+					.value(license_name)
+					.key("issued")
+					.value(true)
+					.key("signed_sections")
+					.number(license.signed_sections())
+					.key("unchanged_sections")
+					.number(license.unchanged_sections())
+					.end_object();
+				results << result_line << '\n';
+			}
+		} catch (const exception &e) {
+			failed++;
+			cerr << orders_file << ":" << line_number << ": " << e.what() << endl;
+			if (results.is_open()) {
+				result_line.clear();
+				JsonWriter(result_line)
+					.begin_object()
+					.key("line")
+					.number(line_number)
+					.key("license")
+					.value(license_name)
+					.key("issued")
+					.value(false)
+					.key("error")
+					.value(e.what())
+					.end_object();
+				results << result_line << '\n';
+			}
+		}
+	}
+	if (results.is_open()) {
+		results.close();
+		if (results.fail()) {
+			throw runtime_error("error writing [" + results_file + "]");
+		}
+	}
+	file_writer.commit();
+	if (bundle) {
+		bundle->finish();
+	}
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	report << "Licenses issued: " << issued << ", failed: " << failed << ", sections signed: " << signed_sections
+		   << ", unchanged: " << unchanged_sections << ", " << elapsed.count() << " s ("
+		   << (elapsed.count() > 0 ? issued / elapsed.count() : 0) << " licenses/s)" << endl;
+	if (output_fd >= 0) {
+		report << "bytes written: " << fd_sink.bytes_written() << endl;
+	} else if (bundle) {
+		report << "bundle: " << bundle_file << ", " << bundle->size() << " licenses" << endl;
+	} else {
+		file_writer.print_summary(report);
+		report << "directories: " << project.directories().size()
+			   << ", directory cache hits: " << project.directories().hits() << endl;
+	}
+	const HistogramSnapshot latency = Metrics::snapshot().since(metrics_start)[Histogram::LICENSE_LATENCY];
+	report << "license latency: p50 " << latency.quantile(0.5) / 1e6 << " ms, p99 " << latency.quantile(0.99) / 1e6
+		   << " ms, p999 " << latency.quantile(0.999) / 1e6 << " ms" << endl;
+	return failed == 0;
+}
+
+static bool listLicenses(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+						 const po::options_description &global) {
+	po::options_description license_desc("license list options");
+	string project_folder;
+	LicenseFilter filter;
+	bool reindex = false;
+	license_desc.add_options()  //
+		(PARAM_PROJECT_FOLDER ",p", po::value<string>(&project_folder)->default_value("."),
+		 "path to the project the licenses were issued for.")  //
+		("feature,f", po::value<string>(&filter.feature), "List the licenses that enable this feature.")  //
+		(PARAM_CLIENT_SIGNATURE ",s", po::value<string>(&filter.client_signature),
+		 "List the licenses linked to this hardware signature.")  //
+		("expires-after", po::value<string>(&filter.expires_after),
+		 "List the licenses expiring on this day or later. Format YYYYMMDD, or relative to today (eg. +30d).")  //
+		("expires-before", po::value<string>(&filter.expires_before),
+		 "List the licenses expiring on this day or before. Format YYYYMMDD, or relative to today (eg. +3m).")  //
+		(PARAM_LICENSES_FOLDER ",l", po::value<string>(),
+		 "With --reindex: folder of the licenses to add to the index.")  //
+		("reindex", po::bool_switch(&reindex),
+		 "Add to the index all the licenses of " PARAM_LICENSES_FOLDER ", eg. the ones issued before the index "
+		 "existed.")  //
+		("help", "Print this help.");  //
+	if (!rerunBoostPO(parsed, license_desc, vm, argv, "license list", global)) {
+		return true;
+	}
+	try {
+		const ProjectContext project(project_folder);
+		LicenseIndex &index = *project.license_index();
+		if (reindex) {
+			const unique_ptr<LicenseLayout> layout = open_layout(vm);
+			if (!layout) {
+				throw invalid_argument("--reindex requires " PARAM_LICENSES_FOLDER);
+			}
+			LicenseRecord record;
+			size_t indexed = 0;
+			for (const string &name : layout->list()) {
+				const string path = layout->find(name);
+				if (License::describe(path, record)) {
+					index.add(record);
+					indexed++;
+				} else {
+					cerr << "Not a license, skipped: " << path << endl;
+				}
+			}
+			index.compact();
+			cout << indexed << " licenses indexed" << endl;
+			return true;
+		}
+		const size_t found = index.query(filter, [](const LicenseRecord &record) {
+			cout << left << setw(10) << (record.valid_to.empty() ? "-" : record.valid_to) << "  " << setw(14)
+				 << (record.client_signature.empty() ? "-" : record.client_signature) << "  " << record.features
+				 << "  " << record.path << '\n';
+		});
+		cout << right << found << " licenses" << endl;
+	} catch (const invalid_argument &) {
+		throw;
+	} catch (const exception &e) {
+		cerr << "Error listing licenses: " << e.what() << endl;
+		return false;
+	}
+	return true;
+}
+
+static const char *status_name(SignatureStatus status) {
+	switch (status) {
+		case SignatureStatus::VALID:
+			return "valid";
+		case SignatureStatus::INVALID:
+			return "invalid";
+		default:
+			return "unsigned";
+	}
+}
+
+/**
+ * Verify a license file, returning its result as a JSON object on a single line.
+ * @param valid
+ * 			set to true if the file is a license and all its sections have a valid signature.
+ */
+static string verify_license_file(const string &license_file, const CryptoHelper &crypto, bool &valid) {
+	string result;
+	JsonWriter writer(result);
+	writer.begin_object().key("path").value(license_file);
+	valid = false;
+	vector<SectionVerification> sections;
+	try {
+		const MappedFile file(license_file);
+		if (!License::verify(file.data(), file.size(), crypto, sections)) {
+			writer.key("valid").value(false).key("error").value("not a license").end_object();
+			return result;
+		}
+	} catch (const exception &e) {
+		writer.key("valid").value(false).key("error").value(e.what()).end_object();
+		return result;
+	}
+	valid = true;
+	for (const SectionVerification &section : sections) {
+		valid = valid && section.status == SignatureStatus::VALID;
+	}
+	writer.key("valid").value(valid).key("sections").begin_array();
+	for (const SectionVerification &section : sections) {
+		writer.begin_object().key("feature").value(section.feature);
+		writer.key("signature").value(status_name(section.status)).end_object();
+	}
+	writer.end_array().end_object();
+	return result;
+}
+
+/**
+ * Verify the signatures of licenses already issued: all the licenses of a folder and/or the files listed in an
+ * input file. Each license is reported as a JSON object on its own line, in input order.
+ */
+static bool verifyLicenses(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+						   const po::options_description &global) {
+	static const size_t BLOCK_SIZE = 4096;
+	po::options_description verify_desc("license verify options");
+	string project_folder;
+	string list_file;
+	string output_file;
+	unsigned int jobs;
+	verify_desc.add_options()  //
+		(PARAM_PROJECT_FOLDER ",p", po::value<string>(&project_folder)->default_value("."),
+		 "path to the project the licenses were issued for.")  //
+		(PARAM_LICENSES_FOLDER ",l", po::value<string>(), "Verify all the licenses of this folder.")  //
+		("input,i", po::value<string>(&list_file), "Verify the license files listed in this file, one per line.")  //
+		("output,o", po::value<string>(&output_file)->default_value("cout"),
+		 "File where to write the results (JSON lines).")  //
+		("jobs,j", po::value<unsigned int>(&jobs)->default_value(default_jobs()),
+		 "Number of licenses verified in parallel.")  //
+		("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, verify_desc, vm, argv, "license verify", global)) {
+		return true;
+	}
+	const unique_ptr<LicenseLayout> layout = open_layout(vm);
+	if (!layout && list_file.empty()) {
+		throw invalid_argument("specify " PARAM_LICENSES_FOLDER " or --input");
+	}
+	const auto start = chrono::steady_clock::now();
+	const ProjectContext project(project_folder);
+	const shared_ptr<const CryptoHelper> crypto = project.crypto();
+	ofstream ofile;
+	if (output_file != "cout") {
+		ofile.open(output_file, ios::trunc);
+		if (!ofile.is_open()) {
+			throw logic_error("can't create [" + output_file + "]");
+		}
+	}
+	ostream &output = output_file == "cout" ? cout : ofile;
+	// licenses of the folder are resolved (shards, old locations) in parallel, listed ones are taken as they are
+	vector<string> license_names;
+	if (layout) {
+		license_names = layout->list();
+	}
+	const size_t folder_licenses = license_names.size();
+	if (!list_file.empty()) {
+		ifstream list(list_file);
+		if (!list.is_open()) {
+			throw runtime_error("Can not open [" + list_file + "]");
+		}
+		string line;
+		while (getline(list, line)) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (!line.empty() && line[0] != '#') license_names.push_back(line);
+		}
+	}
+	vector<string> results(min(BLOCK_SIZE, license_names.size()));
+	atomic<size_t> invalid(0);
+	for (size_t block = 0; block < license_names.size(); block += BLOCK_SIZE) {
+		const size_t count = min(BLOCK_SIZE, license_names.size() - block);
+		parallel_for(count, jobs, [&](size_t i) {
+			const size_t item = block + i;
+			const string path = item < folder_licenses ? layout->find(license_names[item]) : license_names[item];
+			bool valid;
+			results[i] = verify_license_file(path, *crypto, valid);
+			if (!valid) {
+				invalid++;
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			output << results[i] << '\n';
+		}
+	}
+	output.flush();
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	cerr << "Licenses verified: " << license_names.size() << ", not valid: " << invalid.load() << ", "
+		 << elapsed.count() << " s (" << (elapsed.count() > 0 ? license_names.size() / elapsed.count() : 0)
+		 << " licenses/s)" << endl;
+	return invalid.load() == 0;
+}
+
+/**
+ * Names of the licenses already re-signed with the key identified by fingerprint, sorted. The journal of a run made
+ * with another key is ignored.
+ */
+static vector<string> read_resign_journal(const string &journal_file, const string &fingerprint) {
+	vector<string> done;
+	ifstream journal(journal_file);
+	string line;
+	if (!journal.is_open() || !getline(journal, line) || line != "# key " + fingerprint) {
+		return done;
+	}
+	while (getline(journal, line)) {
+		if (!line.empty()) done.push_back(line);
+	}
+	sort(done.begin(), done.end());
+	return done;
+}
+
+/**
+ * Sign again all the licenses of a folder whose signatures are not valid for the current project key, after the key
+ * has been rotated. Licenses are loaded and signed on a pool of threads, in blocks: the licenses of a block are
+ * written atomically and committed together, then recorded in a journal. An interrupted run skips the licenses
+ * already in the journal; the journal is removed when all the licenses have been processed.
+ */
+static bool resignLicenses(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+						   const po::options_description &global) {
+	static const size_t BLOCK_SIZE = 1024;
+	po::options_description resign_desc("license resign options");
+	string project_folder;
+	string journal_file;
+	string previous_key_file;
+	bool retire_previous = false;
+	size_t commit_every;
+	unsigned int jobs;
+	resign_desc.add_options()  //
+		(PARAM_PROJECT_FOLDER ",p", po::value<string>(&project_folder)->default_value("."),
+		 "path to the project the licenses were issued for.")  //
+		("previous-key", po::value<string>(&previous_key_file),
+		 "Private key the licenses were signed with before the rotation. Only sections signed with it are signed "
+		 "again. Default: " PREVIOUS_PRIVATE_KEY_FNAME ", kept in the project folder by project init --force.")  //
+		("retire-previous-key", po::bool_switch(&retire_previous),
+		 "Remove the previous key if all the licenses are signed with the new one, allowing the next key rotation. "
+		 "Use it on the last licenses folder of the project.")  //
+		(PARAM_LICENSES_FOLDER ",l", po::value<string>()->required(), "Folder of the licenses to be signed again.")  //
+		("journal", po::value<string>(&journal_file),
+		 "File recording the licenses already signed, to resume an interrupted run. Default: " RESIGN_JOURNAL_FNAME
+		 " in the licenses folder.")  //
+		("commit-every", po::value<size_t>(&commit_every)->default_value(64),
+		 "Number of license files made durable together (group commit).")  //
+		("jobs,j", po::value<unsigned int>(&jobs)->default_value(default_jobs()),
+		 "Number of licenses signed in parallel.")  //
+		("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, resign_desc, vm, argv, "license resign", global)) {
+		return true;
+	}
+	const unique_ptr<LicenseLayout> layout = open_layout(vm);
+	if (journal_file.empty()) {
+		journal_file = (fs::path(layout->folder()) / RESIGN_JOURNAL_FNAME).string();
+	}
+	const auto start = chrono::steady_clock::now();
+	if (previous_key_file.empty()) {
+		previous_key_file = (fs::path(project_folder) / PREVIOUS_PRIVATE_KEY_FNAME).string();
+	}
+	if (!fs::exists(previous_key_file)) {
+		throw runtime_error("previous key [" + previous_key_file + "] not found: licenses are signed again only if " +
+							"they were signed with it");
+	}
+	const ProjectContext project(project_folder);
+	const shared_ptr<const CryptoHelper> crypto = project.crypto();
+	const string fingerprint = crypto->publicKeyFingerprint();
+	unique_ptr<CryptoHelper> previous_crypto(CryptoHelper::getInstance());
+	previous_crypto->loadPrivateKey_file(previous_key_file);
+
+	const vector<string> all_names = layout->list();
+	const vector<string> done = read_resign_journal(journal_file, fingerprint);
+	vector<string> names;
+	set_difference(all_names.begin(), all_names.end(), done.begin(), done.end(), back_inserter(names));
+	ofstream journal;
+	if (done.empty()) {
+		journal.open(journal_file, ios::trunc);
+		journal << "# key " << fingerprint << '\n';
+	} else {
+		journal.open(journal_file, ios::app);
+	}
+	if (!journal.is_open()) {
+		throw runtime_error("Can not write [" + journal_file + "]");
+	}
+
+	struct Resigned {
+		string path;
+		string license;
+		size_t sections;
+		string error;
+		vector<LedgerRecord> ledger_records;
+	};
+	vector<Resigned> results(min(BLOCK_SIZE, names.size()));
+	AtomicFileWriter file_writer(commit_every);
+	size_t resigned = 0, valid = 0, failed = 0, sections = 0;
+	for (size_t block = 0; block < names.size(); block += BLOCK_SIZE) {
+		const size_t count = min(BLOCK_SIZE, names.size() - block);
+		parallel_for(count, jobs, [&](size_t i) {
+			Resigned &result = results[i];
+			result.path = layout->find(names[block + i]);
+			result.sections = 0;
+			result.error.clear();
+			result.ledger_records.clear();
+			try {
+				const MappedFile file(result.path);
+				result.sections = License::resign(file.data(), file.size(), *crypto, *previous_crypto, result.license,
+												  &result.ledger_records);
+			} catch (const exception &e) {
+				result.error = e.what();
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			if (!results[i].error.empty()) {
+				failed++;
+				cerr << results[i].path << ": " << results[i].error << endl;
+			} else if (results[i].sections > 0) {
+				file_writer.write(results[i].path, results[i].license);
+				resigned++;
+				sections += results[i].sections;
+			} else {
+				valid++;
+			}
+		}
+		// licenses are recorded in the journal and in the ledger only once they are durable
+		file_writer.commit();
+		for (size_t i = 0; i < count; i++) {
+			if (results[i].error.empty()) {
+				journal << names[block + i] << '\n';
+			}
+			for (auto &record : results[i].ledger_records) {
+				record.output = results[i].path;
+				project.ledger()->add(record);
+			}
+		}
+		journal.flush();
+	}
+	journal.close();
+	if (failed == 0) {
+		fs::remove(journal_file);
+		if (retire_previous) {
+			fs::remove(previous_key_file);
+		}
+	}
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	cout << "Licenses signed again: " << resigned << ", already valid: " << valid << ", done before: "
+		 << all_names.size() - names.size() << ", failed: " << failed << ", sections signed: " << sections << ", "
+		 << elapsed.count() << " s (" << (elapsed.count() > 0 ? names.size() / elapsed.count() : 0)
+		 << " licenses/s)" << endl;
+	return failed == 0;
+}
+
+/**
+ * Convert a license between the INI, binary and JSON formats. Signatures are kept.
+ */
+static bool convertLicense(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
+						   const po::options_description &global) {
+	po::options_description convert_desc("license convert options");
+	string input_file;
+	string output_file;
+	string format_name;
+	convert_desc.add_options()  //
+		("input,i", po::value<string>(&input_file)->required(), "License to be converted.")  //
+		("output,o", po::value<string>(&output_file)->required(), "File where to write the converted license.")  //
+		("to", po::value<string>(&format_name)->default_value("binary"),
+		 "Format of the output: binary, json or ini.")  //
+		("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, convert_desc, vm, argv, "license convert", global)) {
+		return true;
+	}
+	const LicenseFormat format = license_format(format_name);
+	try {
+		string converted;
+		{
+			const MappedFile input(input_file);
+			License::convert(input.data(), input.size(), format, converted);
+		}
+		AtomicFileWriter().write(output_file, converted);
+		cout << "License converted (" << converted.size() << " bytes)" << endl;
+		return true;
+	} catch (const exception &e) {
+		cerr << "Error converting [" << input_file << "]: " << e.what() << endl;
+		return false;
+	}
+}
+
+// licenses of a bundle selected by name or client signature, all of them if neither is given
+static vector<size_t> select_bundle_entries(const LicenseBundle &bundle, const vector<string> &names,
+											const string &client_signature) {
+	vector<size_t> selected;
+	if (!client_signature.empty()) {
+		selected = bundle.find_client(client_signature);
+	}
+	for (const string &name : names) {
+		const size_t found = bundle.find(name);
+		if (found == LicenseBundle::NOT_FOUND) {
+			throw runtime_error("license [" + name + "] not found in the bundle");
+		}
+		selected.push_back(found);
+	}
+	if (names.empty() && client_signature.empty()) {
+		for (size_t i = 0; i < bundle.size(); i++) {
+			selected.push_back(i);
+		}
+	}
+	return selected;
+}
+
+/**
+ * List or extract the licenses of a bundle written by license batch --bundle.
+ */
+static bool bundleCommand(const string &command, const po::parsed_options &parsed, po::variables_map &vm,
+						  const char **argv, const po::options_description &global) {
+	po::options_description bundle_desc("bundle " + command + " options");
+	string bundle_file;
+	string output_folder;
+	vector<string> names;
+	string client_signature;
+	bundle_desc.add_options()  //
+		("input,i", po::value<string>(&bundle_file)->required(), "The bundle file.")  //
+		("name,n", po::value<vector<string>>(&names), "Name of a license (can be repeated).")  //
+		(PARAM_CLIENT_SIGNATURE ",s", po::value<string>(&client_signature),
+		 "Select the licenses linked to this hardware signature.");
+	if (command == "extract") {
+		bundle_desc.add_options()("output,o", po::value<string>(&output_folder)->required(),
+								  "Folder where to extract the licenses, the names are relative to it.");
+	}
+	bundle_desc.add_options()("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, bundle_desc, vm, argv, "bundle " + command, global)) {
+		return true;
+	}
+	try {
+		const LicenseBundle bundle(bundle_file);
+		const vector<size_t> selected = select_bundle_entries(bundle, names, client_signature);
+		if (command == "list") {
+			for (const size_t index : selected) {
+				const BundleEntry entry = bundle.entry(index);
+				cout << left << setw(14) << (entry.client_signature.empty() ? "-" : entry.client_signature) << "  "
+					 << setw(8) << entry.size << "  " << entry.name << '\n';
+			}
+			cout << right << selected.size() << " licenses" << endl;
+			return true;
+		}
+		AtomicFileWriter file_writer(64);
+		DirectoryCache directories;
+		for (const size_t index : selected) {
+			const BundleEntry entry = bundle.entry(index);
+			const fs::path name(entry.name);
+			// names come from the bundle: they must not escape the output folder
+			if (entry.name.empty() || name.has_root_path() ||
+				find(name.begin(), name.end(), fs::path("..")) != name.end()) {
+				throw runtime_error("unsafe license name in the bundle: " + entry.name);
+			}
+			const fs::path target = fs::path(output_folder) / name;
+			directories.create_directories(target.parent_path().string());
+			file_writer.write(target.string(), entry.data, entry.size);
+		}
+		file_writer.commit();
+		cout << selected.size() << " licenses extracted" << endl;
+		return true;
+	} catch (const exception &e) {
+		cerr << "Error reading bundle [" << bundle_file << "]: " << e.what() << endl;
+		return false;
+	}
+}
+
+static bool ledgerCommand(const string &command, const po::parsed_options &parsed, po::variables_map &vm,
+						  const char **argv, const po::options_description &global) {
+	po::options_description ledger_desc("ledger " + command + " options");
+	string project_folder;
+	string output;
+	string client_signature;
+	bool details = false;
+	bool drop_superseded = false;
+	ledger_desc.add_options()  //
+		(PARAM_PROJECT_FOLDER ",p", po::value<string>(&project_folder)->default_value("."),
+		 "path to the project the licenses were issued for.");
+	if (command == "find") {
+		ledger_desc.add_options()  //
+			(PARAM_LICENSE_OUTPUT ",o", po::value<string>(&output),
+			 "Find the sections issued in this license file (as it was given when issuing).")  //
+			(PARAM_CLIENT_SIGNATURE ",s", po::value<string>(&client_signature),
+			 "Find the sections issued for this hardware signature.")  //
+			("details", po::bool_switch(&details), "Print the signed values and the signature of each section.");
+	} else {
+		ledger_desc.add_options()  //
+			("drop-superseded", po::bool_switch(&drop_superseded),
+			 "Keep only the last issue of each section of each license file.");
+	}
+	ledger_desc.add_options()("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, ledger_desc, vm, argv, "ledger " + command, global)) {
+		return true;
+	}
+	if (command == "find" && output.empty() == client_signature.empty()) {
+		throw invalid_argument("ledger find requires either " PARAM_LICENSE_OUTPUT " or " PARAM_CLIENT_SIGNATURE);
+	}
+	try {
+		const ProjectContext project(project_folder);
+		LicenseLedger &ledger = *project.ledger();
+		if (command == "compact") {
+			const LedgerCompaction compaction = ledger.compact(drop_superseded);
+			cout << "Ledger records kept: " << compaction.records << ", superseded: " << compaction.superseded
+				 << ", damaged bytes dropped: " << compaction.damaged_bytes << endl;
+			return true;
+		}
+		const LedgerKey key = output.empty() ? LedgerKey::CLIENT_SIGNATURE : LedgerKey::OUTPUT;
+		const size_t found =
+			ledger.find(key, output.empty() ? client_signature : output, [details](const LedgerRecord &record) {
+				cout << manifest_timestamp((time_t)record.issued_at) << "  " << left << setw(14)
+					 << (record.client_signature.empty() ? "-" : record.client_signature) << "  " << setw(14)
+					 << record.feature << "  " << (record.output.empty() ? "-" : record.output) << right << '\n';
+				if (details) {
+					istringstream parameters(record.parameters);
+					string parameter;
+					while (getline(parameters, parameter)) {
+						cout << "    " << parameter << '\n';
+					}
+					cout << "    " LICENSE_SIGNATURE "=" << record.signature << '\n';
+				}
+			});
+		cout << found << " sections" << endl;
+	} catch (const invalid_argument &) {
+		throw;
+	} catch (const exception &e) {
+		cerr << "Error reading the license ledger: " << e.what() << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * keystore import: put the keys of many projects in a keystore. Keys already in the keystore are kept, unless their
+ * project is imported again.
+ * keystore export: write the keys of a keystore back to the project folders.
+ * keystore list: print the projects of a keystore.
+ */
+static bool keystoreCommand(const string &command, const po::parsed_options &parsed, po::variables_map &vm,
+							const char **argv, const po::options_description &global) {
+	po::options_description keystore_desc("keystore " + command + " options");
+	string keystore_file;
+	string projects_folder;
+	vector<string> names;
+	bool force = false;
+	keystore_desc.add_options()(PARAM_KEYSTORE ",k", po::value<string>(&keystore_file)->required(),
+								"The keystore file.");
+	if (command != "list") {
+		keystore_desc.add_options()  //
+			("projects-folder,p", po::value<string>(&projects_folder)->default_value("."),
+			 "path to where project configurations are stored.")  //
+			("project-name,n", po::value<vector<string>>(&names),
+			 "Name of a project (can be repeated). All the projects if not specified.");
+	}
+	if (command == "export") {
+		keystore_desc.add_options()("force", po::bool_switch(&force),
+									"Replace the key of a project folder when it differs from the one in the keystore.");
+	} else if (command == "import") {
+		keystore_desc.add_options()("force", po::bool_switch(&force),
+									"Write the keystore even if some keys can't be imported. The keys of those "
+									"projects already in the keystore are kept.");
+	}
+	keystore_desc.add_options()("help,h", "Print this help.");
+	if (!rerunBoostPO(parsed, keystore_desc, vm, argv, "keystore " + command, global)) {
+		return true;
+	}
+	try {
+		if (command == "import") {
+			if (names.empty()) {
+				for (const ProjectManifest &project : load_project_index(projects_folder)) {
+					names.push_back(project.name);
+				}
+			}
+			const set<string> imported_names(names.begin(), names.end());
+			KeystoreWriter writer(keystore_file);
+			size_t imported = 0, kept = 0, failed = 0;
+			for (const string &name : imported_names) {
+				try {
+					unique_ptr<CryptoHelper> key(CryptoHelper::getInstance());
+					key->loadPrivateKey_file((fs::path(projects_folder) / name / PRIVATE_KEY_FNAME).string());
+					writer.add(name, *key);
+					imported++;
+				} catch (const exception &e) {
+					cerr << "Key of project " << name << " not imported: " << e.what() << endl;
+					failed++;
+				}
+			}
+			if (failed > 0 && !force) {
+				cerr << "Keystore [" << keystore_file << "] not written: " << failed
+					 << " keys can't be imported (use --force to write it anyway)" << endl;
+				return false;
+			}
+			if (fs::exists(keystore_file)) {
+				// the previous key of a project is kept if its new key could not be imported
+				const Keystore previous(keystore_file);
+				for (size_t i = 0; i < previous.size(); i++) {
+					if (!writer.contains(previous.project_name(i))) {
+						writer.add(previous.project_name(i), *previous.key(i));
+						kept++;
+					}
+				}
+			}
+			writer.finish();
+			cout << "Keys imported: " << imported << ", kept from the keystore: " << kept << ", failed: " << failed
+				 << endl;
+			return failed == 0;
+		}
+		const Keystore keystore(keystore_file);
+		vector<size_t> selected;
+		for (const string &name : names) {
+			const size_t index = keystore.find(name);
+			if (index == Keystore::NOT_FOUND) {
+				throw runtime_error("project " + name + " is not in the keystore");
+			}
+			selected.push_back(index);
+		}
+		if (names.empty()) {
+			for (size_t i = 0; i < keystore.size(); i++) {
+				selected.push_back(i);
+			}
+		}
+		if (command == "list") {
+			for (const size_t index : selected) {
+				cout << keystore.fingerprint(index).substr(0, 16) << "  " << keystore.project_name(index) << '\n';
+			}
+			cout << selected.size() << " keys" << endl;
+			return true;
+		}
+		AtomicFileWriter file_writer(64);
+		size_t exported = 0, unchanged = 0, failed = 0;
+		for (const size_t index : selected) {
+			const string name = keystore.project_name(index);
+			const fs::path project_folder = fs::path(projects_folder) / name;
+			const string key_file = (project_folder / PRIVATE_KEY_FNAME).string();
+			if (fs::exists(key_file)) {
+				unique_ptr<CryptoHelper> existing(CryptoHelper::getInstance());
+				existing->loadPrivateKey_file(key_file);
+				if (existing->publicKeyFingerprint() == keystore.fingerprint(index)) {
+					unchanged++;
+					continue;
+				}
+				if (!force) {
+					cerr << "Project " << name << " has a different key, not replaced (use --force)" << endl;
+					failed++;
+					continue;
+				}
+			}
+			fs::create_directories(project_folder);
+			file_writer.write(key_file, keystore.key(index)->exportPrivateKey());
+			exported++;
+		}
+		file_writer.commit();
+		cout << "Keys exported: " << exported << ", unchanged: " << unchanged << ", failed: " << failed << endl;
+		return failed == 0;
+	} catch (const exception &e) {
+		cerr << "Error with keystore [" << keystore_file << "]: " << e.what() << endl;
+		return false;
+	}
+}
+
+/**
+ * Read the next payload to be signed.
+ * @param length_prefixed
+ * 			payloads are preceded by their length, 4 bytes big endian, instead of being terminated by a new line.
+ * @return false at the end of the input
+ */
+static bool read_payload(istream &input, bool length_prefixed, string &payload) {
+	if (!length_prefixed) {
+		if (!getline(input, payload)) {
+			return false;
+		}
+		if (!payload.empty() && payload.back() == '\r') payload.pop_back();
+		return true;
+	}
+	unsigned char prefix[4];
+	if (!input.read(reinterpret_cast<char *>(prefix), sizeof(prefix))) {
+		if (input.gcount() != 0) {
+			throw runtime_error("truncated payload length");
+		}
+		return false;
+	}
+	const uint32_t length = ((uint32_t)prefix[0] << 24) | ((uint32_t)prefix[1] << 16) | ((uint32_t)prefix[2] << 8) |
+							(uint32_t)prefix[3];
+	// the length is not trusted: the payload grows with the bytes read, a damaged prefix can't allocate gigabytes
+	static const size_t CHUNK_SIZE = 1 << 16;
+	payload.clear();
+	while (payload.size() < length) {
+		const size_t offset = payload.size();
+		const size_t chunk = min<size_t>(length - offset, CHUNK_SIZE);
+		payload.resize(offset + chunk);
+		if (!input.read(&payload[offset], chunk)) {
+			throw runtime_error("truncated payload, expected " + to_string(length) + " bytes");
+		}
+	}
+	return true;
+}
+
+/**
+ * Sign all the payloads of a file with the same key, writing one signature per line in input order. Payloads are
+ * signed in blocks, each block split among the threads, so that the memory used doesn't depend on the input size.
+ * Every thread has its own copy of the key, parsed from the key file read once.
+ */
+static void sign_payloads(const string &private_key_file, const string &input_file, bool length_prefixed,
+						  unsigned int jobs, ostream &output, ostream &report) {
+	static const size_t BLOCK_SIZE = 4096;
+	ifstream input(input_file, ios::binary);
+	if (!input.is_open()) {
+		throw runtime_error("Can not open [" + input_file + "]");
+	}
+	const auto start = chrono::steady_clock::now();
+	vector<unique_ptr<CryptoHelper>> signers;
+	{
+		StageTimer key_timer(Stage::KEY_LOAD);
+		ifstream key_stream(private_key_file, ios::binary);
+		if (!key_stream.is_open()) {
+			throw logic_error("can't read [" + private_key_file + "]");
+		}
+		const string private_key((istreambuf_iterator<char>(key_stream)), istreambuf_iterator<char>());
+		for (unsigned int i = 0; i < max(jobs, 1u); i++) {
+			signers.push_back(CryptoHelper::getInstance());
+			signers.back()->loadPrivateKey(private_key);
+		}
+	}
+	vector<string> payloads(BLOCK_SIZE), signatures(BLOCK_SIZE);
+	size_t signed_count = 0, signed_bytes = 0;
+	bool more = true;
+	while (more) {
+		size_t count = 0;
+		while (count < BLOCK_SIZE && (more = read_payload(input, length_prefixed, payloads[count]))) {
+			signed_bytes += payloads[count].size();
+			count++;
+		}
+		const size_t slice = (count + signers.size() - 1) / signers.size();
+		parallel_for(signers.size(), (unsigned int)signers.size(), [&](size_t thread) {
+			const size_t end = min(count, (thread + 1) * slice);
+			for (size_t i = thread * slice; i < end; i++) {
+				StageTimer sign_timer(Stage::SIGNING);
+				signatures[i] = signers[thread]->signString(payloads[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			output << signatures[i] << '\n';
+		}
+		signed_count += count;
+	}
+	output.flush();
+	if (!output) {
+		throw runtime_error("error writing the signatures");
+	}
+	const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	report << "Payloads signed: " << signed_count << " (" << signed_bytes << " bytes), " << elapsed.count() << " s ("
+		   << (elapsed.count() > 0 ? signed_count / elapsed.count() : 0) << " signatures/s)" << endl;
+}
+
 /** method used in tests for have a quick signature of a piece of data */
 
 static void test_sign(const po::parsed_options &parsed, po::variables_map &vm, const char **argv,
 					  const po::options_description &global) {
-	po::options_description license_desc("license issue options");
+	po::options_description license_desc("test sign options");
 	string private_key_file;
 	string data;
+	string input_file;
 	string outputFile;
+	bool length_prefixed = false;
+	unsigned int jobs;
 	license_desc.add_options()  //
-		("data,d", po::value<string>(&data)->required(), "Data to be signed")  //
+		("data,d", po::value<string>(&data), "Data to be signed")  //
+		("input,i", po::value<string>(&input_file),
+		 "File of payloads to be signed, one per line. The signatures are written one per line, in the same "
+		 "order.")  //
+		("length-prefixed", po::bool_switch(&length_prefixed),
+		 "Payloads in the input file are binary, each one preceded by its length (4 bytes, big endian).")  //
+		("jobs,j", po::value<unsigned int>(&jobs)->default_value(1), "Number of threads signing the input file.")  //
 		(PARAM_PRIMARY_KEY ",p", po::value<string>(&private_key_file)->required(), "Primary key location")  //
 		("output,o", po::value<string>(&outputFile)->required(), "file where to write output");
-	rerunBoostPO(parsed, license_desc, vm, argv, "license issue", global);
+	rerunBoostPO(parsed, license_desc, vm, argv, "test sign", global);
+	// empty data can be signed
+	if ((vm.count("data") > 0) == (vm.count("input") > 0)) {
+		throw invalid_argument("specify either --data or --input");
+	}
+	if (vm.count("input") > 0) {
+		if (outputFile == "cout") {
+			sign_payloads(private_key_file, input_file, length_prefixed, jobs, cout, cerr);
+		} else {
+			ofstream ofile(outputFile, ios::trunc | ios::binary);
+			if (!ofile.is_open()) {
+				throw logic_error("can't create [" + outputFile + "]");
+			}
+			sign_payloads(private_key_file, input_file, length_prefixed, jobs, ofile, cout);
+		}
+		return;
+	}
 	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
 	crypto->loadPrivateKey_file(private_key_file);
 	string signedData(crypto->signString(data));
@@ -214,8 +1439,32 @@ int CommandLineParser::parseCommandLine(int argc, const char **argv) {
 		return 0;
 	}
 	int result = 0;
+	// profiling starts before the options are parsed, to time their parsing too
+	bool profile = false;
+	for (int i = 1; i < argc && !profile; i++) {
+		profile = string("--profile") == argv[i];
+	}
+	Profiler::enable(profile);
+	// the profile is printed however the command ends
+	struct ProfileReport {
+		~ProfileReport() {
+			if (Profiler::enabled()) {
+				Profiler::print_json(cerr);
+				Profiler::enable(false);
+			}
+		}
+	} profile_report;
+	struct MetricsReport {
+		~MetricsReport() { metrics_reporter.reset(); }
+	} metrics_report;
+	StageTimer parse_timer(Stage::OPTION_PARSING);
 	po::options_description global("Global options");
-	global.add_options()("verbose,v", "Turn on verbose output");
+	global.add_options()("verbose,v", "Turn on verbose output")  //
+		("profile", "Print the time spent in each stage of the command (JSON, on the standard error)")  //
+		("metrics-file", po::value<string>(),
+		 "Write throughput and latency metrics to this file in OpenMetrics text format, periodically and when the "
+		 "command ends.")  //
+		("metrics-interval", po::value<unsigned int>()->default_value(10), "Seconds between two metrics snapshots.");
 	po::options_description hidden("Hidden options");
 	hidden.add_options()("command", po::value<std::vector<std::string>>(),
 						 "command to execute: project init, project list, license list, license issue")(
@@ -229,6 +1478,7 @@ int CommandLineParser::parseCommandLine(int argc, const char **argv) {
 	po::parsed_options parsed =
 		po::command_line_parser(argc, argv).options(global).options(hidden).positional(pos).allow_unregistered().run();
 	po::store(parsed, vm);
+	parse_timer.stop();
 	std::vector<std::string> cmds = vm["command"].as<std::vector<std::string>>();
 	if (cmds.size() == 0 || cmds.size() == 1) {
 		printBasicHelp(argv[0]);
@@ -237,16 +1487,12 @@ int CommandLineParser::parseCommandLine(int argc, const char **argv) {
 	bool verbose = vm.count("verbose") > 0;
 	try {
 		if (cmds[0] == "project") {
-			if (cmds[1].substr(0, 4) == "init") {
+			if (cmds[1] == "init-batch") {
+				result = initializeProjectBatch(parsed, vm, argv, global) ? 0 : 1;
+			} else if (cmds[1].substr(0, 4) == "init") {
 				initializeProject(parsed, vm, argv, global);
 			} else if (cmds[1] == "list") {
-				po::options_description project_desc("project " + cmds[1] + " options");
-				boost::optional<string> project_folder;
-				project_desc.add_options()  //
-					("projects-folder,p", po::value<boost::optional<string>>(&project_folder),
-					 "path to where project configurations are stored.")  //
-					("help", "Print this help.");  //
-
+				result = listProjects(parsed, vm, argv, global) ? 0 : 1;
 			} else {
 				std::cerr << endl << "command " << cmds[0] << " " << cmds[1] << " not recognized.";
 				printBasicHelp(argv[0]);
@@ -255,6 +1501,37 @@ int CommandLineParser::parseCommandLine(int argc, const char **argv) {
 		} else if (cmds[0] == "license") {
 			if (cmds[1] == "issue") {
 				issueLicense(parsed, vm, argv, global);
+			} else if (cmds[1] == "batch") {
+				result = issueLicenseBatch(parsed, vm, argv, global) ? 0 : 1;
+			} else if (cmds[1] == "list") {
+				result = listLicenses(parsed, vm, argv, global) ? 0 : 1;
+			} else if (cmds[1] == "verify") {
+				result = verifyLicenses(parsed, vm, argv, global) ? 0 : 1;
+			} else if (cmds[1] == "resign") {
+				result = resignLicenses(parsed, vm, argv, global) ? 0 : 1;
+			} else if (cmds[1] == "convert") {
+				result = convertLicense(parsed, vm, argv, global) ? 0 : 1;
+			} else {
+				printBasicHelp(argv[0]);
+				result = 1;
+			}
+		} else if (cmds[0] == "bundle") {
+			if (cmds[1] == "list" || cmds[1] == "extract") {
+				result = bundleCommand(cmds[1], parsed, vm, argv, global) ? 0 : 1;
+			} else {
+				printBasicHelp(argv[0]);
+				result = 1;
+			}
+		} else if (cmds[0] == "ledger") {
+			if (cmds[1] == "find" || cmds[1] == "compact") {
+				result = ledgerCommand(cmds[1], parsed, vm, argv, global) ? 0 : 1;
+			} else {
+				printBasicHelp(argv[0]);
+				result = 1;
+			}
+		} else if (cmds[0] == "keystore") {
+			if (cmds[1] == "import" || cmds[1] == "export" || cmds[1] == "list") {
+				result = keystoreCommand(cmds[1], parsed, vm, argv, global) ? 0 : 1;
 			} else {
 				printBasicHelp(argv[0]);
 				result = 1;
@@ -274,6 +1551,10 @@ int CommandLineParser::parseCommandLine(int argc, const char **argv) {
 		printBasicHelp(argv[0]);
 		cout << endl << "Parameter error: " << e.what() << endl;
 		result = 1;
+	} catch (const exception &e) {
+		// files that can't be read or written, corrupted inputs...
+		cerr << "Error: " << e.what() << endl;
+		result = 1;
 	}
 	return result;
 }
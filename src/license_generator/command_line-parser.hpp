@@ -30,6 +30,8 @@ public:
 	 * <ul>
 	 * <li>project init</li>
 	 * <li>project list</li>
+	 * <li>license issue</li>
+	 * <li>license batch</li>
 	 *
 	 * <ul>
 	 * @param argc
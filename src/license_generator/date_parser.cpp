@@ -0,0 +1,172 @@
+/*
+ * date_parser.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <ctime>
+#include <stdexcept>
+
+#include "date_parser.hpp"
+
+namespace license {
+using namespace std;
+
+static inline bool is_leap(unsigned int year) { return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0; }
+
+static inline unsigned int days_in_month(unsigned int year, unsigned int month) {
+	static const unsigned char DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	return month == 2 && is_leap(year) ? 29 : DAYS[month - 1];
+}
+
+// days since 1970-01-01 of a proleptic gregorian date (H. Hinnant's days_from_civil)
+static long days_from_civil(long y, unsigned int m, unsigned int d) {
+	y -= m <= 2;
+	const long era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned int yoe = (unsigned int)(y - era * 400);
+	const unsigned int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (long)doe - 719468;
+}
+
+static void civil_from_days(long z, long &y, unsigned int &m, unsigned int &d) {
+	z += 719468;
+	const long era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned int doe = (unsigned int)(z - era * 146097);
+	const unsigned int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned int mp = (5 * doy + 2) / 153;
+	d = doy - (153 * mp + 2) / 5 + 1;
+	m = mp < 10 ? mp + 3 : mp - 9;
+	y = (long)yoe + era * 400 + (m <= 2);
+}
+
+RunClock::RunClock() {
+	const time_t now = time(nullptr);
+	struct tm local;
+#ifdef _WIN32
+	localtime_s(&local, &now);
+#else
+	localtime_r(&now, &local);
+#endif
+	m_today = days_from_civil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+RunClock::RunClock(unsigned int year, unsigned int month, unsigned int day)
+	: m_today(days_from_civil(year, month, day)) {}
+
+const RunClock &RunClock::current() {
+	static const RunClock clock;
+	return clock;
+}
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// parse up to max_digits digits, at least min_digits.
+static bool parse_number(const char *&cur, const char *end, size_t min_digits, size_t max_digits,
+						 unsigned long &value) {
+	value = 0;
+	size_t digits = 0;
+	while (cur < end && digits < max_digits && is_digit(*cur)) {
+		value = value * 10 + (unsigned long)(*cur - '0');
+		cur++;
+		digits++;
+	}
+	return digits >= min_digits;
+}
+
+static inline void write_digits(char *out, unsigned int value, size_t digits) {
+	for (size_t i = digits; i > 0; i--) {
+		out[i - 1] = (char)('0' + value % 10);
+		value /= 10;
+	}
+}
+
+static void format_date(long year, unsigned int month, unsigned int day, char (&out)[DATE_LENGTH]) {
+	write_digits(out, (unsigned int)year, 4);
+	out[4] = '-';
+	write_digits(out + 5, month, 2);
+	out[7] = '-';
+	write_digits(out + 8, day, 2);
+}
+
+static void resolve_relative(const char *cur, const char *end, const std::string &date, const RunClock &clock,
+							 char (&out)[DATE_LENGTH]) {
+	const bool negative = *cur == '-';
+	cur++;
+	unsigned long amount;
+	if (!parse_number(cur, end, 1, 6, amount) || cur + 1 != end) {
+		throw invalid_argument("Date [" + date + "] is not a valid relative date. try +365d or +12m");
+	}
+	const long signed_amount = negative ? -(long)amount : (long)amount;
+	long year;
+	unsigned int month, day;
+	switch (*cur) {
+		case 'd':
+		case 'D':
+			civil_from_days(clock.today() + signed_amount, year, month, day);
+			break;
+		case 'w':
+		case 'W':
+			civil_from_days(clock.today() + signed_amount * 7, year, month, day);
+			break;
+		case 'm':
+		case 'M':
+		case 'y':
+		case 'Y': {
+			civil_from_days(clock.today(), year, month, day);
+			const long months = (*cur == 'm' || *cur == 'M') ? signed_amount : signed_amount * 12;
+			long month_index = year * 12 + (month - 1) + months;
+			year = month_index / 12;
+			month = (unsigned int)(month_index % 12) + 1;
+			if (year > 0 && day > days_in_month((unsigned int)year, month)) {
+				day = days_in_month((unsigned int)year, month);
+			}
+			break;
+		}
+		default:
+			throw invalid_argument("Date [" + date + "] has an unknown unit. Use d, w, m or y");
+	}
+	if (year < 1 || year > 9999) {
+		throw invalid_argument("Date [" + date + "] is out of range");
+	}
+	format_date(year, month, day, out);
+}
+
+void normalize_date(const char *date, size_t length, const RunClock &clock, char (&out)[DATE_LENGTH]) {
+	const char *cur = date;
+	const char *end = date + length;
+	while (cur < end && (*cur == ' ' || *cur == '\t')) cur++;
+	while (end > cur && (*(end - 1) == ' ' || *(end - 1) == '\t')) end--;
+	if (cur < end && (*cur == '+' || *cur == '-')) {
+		resolve_relative(cur, end, string(date, length), clock, out);
+		return;
+	}
+	if (end - cur < 8) {
+		throw invalid_argument("Date string too small for known formats");
+	}
+	unsigned long year, month, day;
+	bool matched = parse_number(cur, end, 4, 4, year);
+	if (matched && (*cur == '-' || *cur == '/')) {
+		const char separator = *cur++;
+		matched = parse_number(cur, end, 1, 2, month) && cur < end && *cur++ == separator &&
+				  parse_number(cur, end, 1, 2, day);
+	} else if (matched) {
+		matched = parse_number(cur, end, 2, 2, month) && parse_number(cur, end, 2, 2, day);
+	}
+	if (!matched || cur != end) {
+		throw invalid_argument("Date [" + string(date, length) + "] did not match a known format. try YYYY-MM-DD");
+	}
+	if (year == 0 || month == 0 || month > 12 || day == 0 || day > days_in_month(year, month)) {
+		throw invalid_argument("Date [" + string(date, length) + "] is not a valid calendar date");
+	}
+	format_date(year, month, day, out);
+}
+
+const std::string normalize_date(const std::string &date) {
+	char out[DATE_LENGTH];
+	normalize_date(date.data(), date.size(), RunClock::current(), out);
+	return string(out, DATE_LENGTH);
+}
+
+} /* namespace license */
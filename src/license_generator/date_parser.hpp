@@ -0,0 +1,63 @@
+/*
+ * date_parser.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_DATE_PARSER_HPP_
+#define SRC_LICENSE_GENERATOR_DATE_PARSER_HPP_
+
+#include <cstddef>
+#include <string>
+
+namespace license {
+
+/**
+ * Length of a normalized date: YYYY-MM-DD
+ */
+constexpr size_t DATE_LENGTH = 10;
+
+/**
+ * Day relative dates are resolved against.
+ *
+ * <p>The current date is captured once per run (see #current()), so that all the licenses issued by the same run
+ * use the same "today" even if the run crosses midnight.</p>
+ */
+class RunClock {
+private:
+	// days since 1970-01-01
+	long m_today;
+
+public:
+	// captures the current local date
+	RunClock();
+	RunClock(unsigned int year, unsigned int month, unsigned int day);
+	inline long today() const { return m_today; }
+	/**
+	 * The clock of this run, initialized the first time it's used.
+	 */
+	static const RunClock &current();
+};
+
+/**
+ * Parse a date and write it normalized as YYYY-MM-DD in <code>out</code> (not null terminated).
+ *
+ * Accepted formats:
+ * <ul>
+ * <li>YYYY-MM-DD, YYYY/MM/DD (month and day may have one digit)</li>
+ * <li>YYYYMMDD</li>
+ * <li>relative to the clock: +N or -N followed by d (days), w (weeks), m (months) or y (years), eg. +365d, +12m.
+ * Adding months or years to a day that doesn't exist in the target month gives the last day of the month.</li>
+ * </ul>
+ * @throws invalid_argument if the format is not recognized or the date does not exist (eg. 2019-02-29).
+ */
+void normalize_date(const char *date, size_t length, const RunClock &clock, char (&out)[DATE_LENGTH]);
+
+/**
+ * Normalize a date resolving relative dates against RunClock::current().
+ */
+const std::string normalize_date(const std::string &date);
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_DATE_PARSER_HPP_ */
@@ -0,0 +1,61 @@
+/*
+ * file_lock.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "file_lock.hpp"
+
+namespace license {
+using namespace std;
+
+FileLock::FileLock(const std::string &file_name) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ | GENERIC_WRITE,
+							  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+							  FILE_ATTRIBUTE_NORMAL, nullptr);
+	OVERLAPPED overlapped = {};
+	if (file == INVALID_HANDLE_VALUE ||
+		!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		throw runtime_error("Can not lock [" + file_name + "]");
+	}
+	m_file = file;
+#else
+	m_fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+	if (m_fd < 0) {
+		throw runtime_error("Can not open [" + file_name + "]: " + strerror(errno));
+	}
+	int result;
+	while ((result = flock(m_fd, LOCK_EX)) != 0 && errno == EINTR) {
+	}
+	if (result != 0) {
+		const string error(strerror(errno));
+		close(m_fd);
+		throw runtime_error("Can not lock [" + file_name + "]: " + error);
+	}
+#endif
+}
+
+FileLock::~FileLock() {
+#ifdef _WIN32
+	CloseHandle((HANDLE)m_file);
+#else
+	close(m_fd);
+#endif
+}
+
+} /* namespace license */
@@ -0,0 +1,40 @@
+/*
+ * file_lock.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_FILE_LOCK_HPP_
+#define SRC_LICENSE_GENERATOR_FILE_LOCK_HPP_
+
+#include <string>
+
+namespace license {
+
+/**
+ * Exclusive lock on a file, held until destruction. It excludes other processes and other threads. The file is
+ * created if it doesn't exist, and it is never removed: lock files must not be replaced while they are in use.
+ */
+class FileLock {
+private:
+#ifdef _WIN32
+	void *m_file;
+#else
+	int m_fd;
+#endif
+
+public:
+	/**
+	 * Wait until the lock is acquired.
+	 * @throws runtime_error if the file can't be opened or locked.
+	 */
+	explicit FileLock(const std::string &file_name);
+	FileLock(const FileLock &) = delete;
+	FileLock &operator=(const FileLock &) = delete;
+	// closing the file releases the lock
+	~FileLock();
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_FILE_LOCK_HPP_ */
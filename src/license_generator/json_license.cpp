@@ -0,0 +1,148 @@
+/*
+ * json_license.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <stdexcept>
+
+#include "../inja/nlohmann/json.hpp"
+#include "json_license.hpp"
+#include "json_writer.hpp"
+
+namespace license {
+using namespace std;
+using json = nlohmann::json;
+
+bool is_json_license(const char *data, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		if (data[i] != ' ' && data[i] != '\t' && data[i] != '\r' && data[i] != '\n') {
+			return data[i] == '{';
+		}
+	}
+	return false;
+}
+
+void encode_json_license(const std::vector<LicenseSection> &sections, std::string &out) {
+	out.clear();
+	JsonWriter writer(out);
+	writer.begin_object().key("format").value(JSON_LICENSE_FORMAT).key("version").number(JSON_LICENSE_VERSION);
+	writer.key("sections").begin_array();
+	for (const LicenseSection &section : sections) {
+		writer.begin_object().key("name").value(section.name).key("fields").begin_object();
+		for (const LicenseField &field : section.fields) {
+			writer.key(field.key).value(field.value);
+		}
+		writer.end_object().end_object();
+	}
+	writer.end_array().end_object();
+	out.push_back('\n');
+}
+
+/**
+ * Decodes the license while it is parsed: the sections are filled in document order, without building the JSON
+ * document.
+ */
+class LicenseSaxHandler : public json::json_sax_t {
+private:
+	enum class State { START, LICENSE, SECTIONS, SECTION, FIELDS, END };
+	vector<LicenseSection> &m_sections;
+	State m_state;
+	std::string m_key;
+	bool m_format_found;
+
+	bool fail(const std::string &message) {
+		error = message;
+		return false;
+	}
+	bool unexpected(const char *what) { return fail(std::string("unexpected ") + what + " for [" + m_key + "]"); }
+
+public:
+	std::string error;
+	explicit LicenseSaxHandler(vector<LicenseSection> &sections)
+		: m_sections(sections), m_state(State::START), m_format_found(false) {}
+
+	bool null() override { return unexpected("null"); }
+	bool boolean(bool) override { return unexpected("boolean"); }
+	bool number_integer(number_integer_t) override { return unexpected("number"); }
+	bool number_unsigned(number_unsigned_t val) override {
+		if (m_state == State::LICENSE && m_key == "version") {
+			return val == JSON_LICENSE_VERSION || fail("JSON license version " + to_string(val) + " not supported");
+		}
+		return unexpected("number");
+	}
+	bool number_float(number_float_t, const string_t &) override { return unexpected("number"); }
+	bool string(string_t &val) override {
+		if (m_state == State::LICENSE && m_key == "format") {
+			m_format_found = val == JSON_LICENSE_FORMAT;
+			return m_format_found || fail("not a license: format [" + val + "]");
+		} else if (m_state == State::SECTION && m_key == "name") {
+			m_sections.back().name = move(val);
+			return true;
+		} else if (m_state == State::FIELDS) {
+			const LicenseField field = {m_key, val};
+			m_sections.back().fields.push_back(field);
+			return true;
+		}
+		return unexpected("string");
+	}
+	bool start_object(std::size_t) override {
+		if (m_state == State::START) {
+			m_state = State::LICENSE;
+		} else if (m_state == State::SECTIONS) {
+			m_sections.emplace_back();
+			m_state = State::SECTION;
+		} else if (m_state == State::SECTION && m_key == "fields") {
+			m_state = State::FIELDS;
+		} else {
+			return unexpected("object");
+		}
+		return true;
+	}
+	bool key(string_t &val) override {
+		m_key = move(val);
+		if (m_state == State::LICENSE && m_key != "format" && m_key != "version" && m_key != "sections") {
+			return fail("unknown member [" + m_key + "]");
+		}
+		if (m_state == State::SECTION && m_key != "name" && m_key != "fields") {
+			return fail("unknown member of a section [" + m_key + "]");
+		}
+		return true;
+	}
+	bool end_object() override {
+		if (m_state == State::FIELDS) {
+			m_state = State::SECTION;
+		} else if (m_state == State::SECTION) {
+			m_state = State::SECTIONS;
+		} else if (!m_format_found) {
+			return fail("not a license: format missing");
+		} else {
+			m_state = State::END;
+		}
+		return true;
+	}
+	bool start_array(std::size_t) override {
+		if (m_state != State::LICENSE || m_key != "sections") {
+			return unexpected("array");
+		}
+		m_state = State::SECTIONS;
+		return true;
+	}
+	bool end_array() override {
+		m_state = State::LICENSE;
+		return true;
+	}
+	bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &) override {
+		return fail("malformed JSON at byte " + to_string(position));
+	}
+};
+
+void decode_json_license(const char *data, size_t size, std::vector<LicenseSection> &sections) {
+	sections.clear();
+	LicenseSaxHandler handler(sections);
+	if (!json::sax_parse(nlohmann::detail::input_adapter(data, size), &handler)) {
+		throw runtime_error("invalid JSON license: " + handler.error);
+	}
+}
+
+} /* namespace license */
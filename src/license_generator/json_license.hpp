@@ -0,0 +1,53 @@
+/*
+ * json_license.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_JSON_LICENSE_HPP_
+#define SRC_LICENSE_GENERATOR_JSON_LICENSE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "binary_license.hpp"
+
+namespace license {
+
+/**
+ * Value of the "format" member of a JSON license.
+ */
+#define JSON_LICENSE_FORMAT "lcc-license"
+#define JSON_LICENSE_VERSION 1
+
+/**
+ * JSON encoding of a license, for programs that consume licenses (the clients read the INI format only).
+ *
+ * <p>The license is a single object, written on one line:
+ * <pre>
+ * {"format": "lcc-license", "version": 1, "sections": [{"name": "F1", "fields": {"lic_ver": "200", "sig": "..."}}]}
+ * </pre>
+ * Sections and fields keep the order of the INI license. Every value is a JSON string holding the same text the INI
+ * format stores: numbers and dates are not converted, so the values can be signed as they are.</p>
+ *
+ * <p>Canonicalization. The signature (field "sig") of a section is the signature of the UTF-8 text made of, without
+ * any separator:
+ * <ol>
+ * <li>the section name in upper case;</li>
+ * <li>for each field except "sig", in ascending order of the keys compared case-insensitively (ASCII), the key and
+ * then the value, both without leading and trailing white space.</li>
+ * </ol>
+ * The text depends neither on the order of the fields nor on the white space of the JSON document, and it is the text
+ * signed in the INI and in the binary formats: a license keeps its signatures when it is converted.</p>
+ */
+bool is_json_license(const char *data, size_t size);
+void encode_json_license(const std::vector<LicenseSection> &sections, std::string &out);
+/**
+ * @throws runtime_error if the data is not a well formed JSON license.
+ */
+void decode_json_license(const char *data, size_t size, std::vector<LicenseSection> &sections);
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_JSON_LICENSE_HPP_ */
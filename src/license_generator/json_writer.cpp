@@ -0,0 +1,152 @@
+/*
+ * json_writer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "json_writer.hpp"
+
+namespace license {
+using namespace std;
+
+JsonWriter::JsonWriter(std::string &out) : m_out(out), m_after_key(false) {}
+
+void JsonWriter::separate() {
+	if (m_after_key) {
+		m_after_key = false;
+		return;
+	}
+	if (!m_empty.empty()) {
+		if (!m_empty.back()) {
+			m_out.append(", ");
+		}
+		m_empty.back() = false;
+	}
+}
+
+JsonWriter &JsonWriter::begin_object() {
+	separate();
+	m_out.push_back('{');
+	m_empty.push_back(true);
+	return *this;
+}
+
+JsonWriter &JsonWriter::end_object() {
+	if (m_empty.empty() || m_after_key) {
+		throw logic_error("JSON object closed without being opened");
+	}
+	m_empty.pop_back();
+	m_out.push_back('}');
+	return *this;
+}
+
+JsonWriter &JsonWriter::begin_array() {
+	separate();
+	m_out.push_back('[');
+	m_empty.push_back(true);
+	return *this;
+}
+
+JsonWriter &JsonWriter::end_array() {
+	if (m_empty.empty() || m_after_key) {
+		throw logic_error("JSON array closed without being opened");
+	}
+	m_empty.pop_back();
+	m_out.push_back(']');
+	return *this;
+}
+
+JsonWriter &JsonWriter::key(const std::string &name) {
+	if (m_after_key) {
+		throw logic_error("JSON key [" + name + "] written without a value for the previous one");
+	}
+	separate();
+	write_string(m_out, name.data(), name.size());
+	m_out.append(": ");
+	m_after_key = true;
+	return *this;
+}
+
+JsonWriter &JsonWriter::value(const std::string &value) {
+	separate();
+	write_string(m_out, value.data(), value.size());
+	return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *value) {
+	separate();
+	write_string(m_out, value, strlen(value));
+	return *this;
+}
+
+JsonWriter &JsonWriter::value(bool value) {
+	separate();
+	m_out.append(value ? "true" : "false");
+	return *this;
+}
+
+JsonWriter &JsonWriter::number(uint64_t value) {
+	separate();
+	m_out.append(to_string(value));
+	return *this;
+}
+
+JsonWriter &JsonWriter::real(double value) {
+	if (!std::isfinite(value)) {
+		return null();
+	}
+	separate();
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.6g", value);
+	m_out.append(buffer);
+	return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+	separate();
+	m_out.append("null");
+	return *this;
+}
+
+void JsonWriter::write_string(std::string &out, const char *data, size_t size) {
+	static const char HEX[] = "0123456789abcdef";
+	out.push_back('"');
+	size_t plain_start = 0;
+	for (size_t i = 0; i < size; i++) {
+		const unsigned char c = (unsigned char)data[i];
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+		out.append(data + plain_start, i - plain_start);
+		plain_start = i + 1;
+		switch (c) {
+			case '"':
+				out.append("\\\"");
+				break;
+			case '\\':
+				out.append("\\\\");
+				break;
+			case '\n':
+				out.append("\\n");
+				break;
+			case '\r':
+				out.append("\\r");
+				break;
+			case '\t':
+				out.append("\\t");
+				break;
+			default:
+				out.append("\\u00").push_back(HEX[c >> 4]);
+				out.push_back(HEX[c & 0xf]);
+		}
+	}
+	out.append(data + plain_start, size - plain_start);
+	out.push_back('"');
+}
+
+} /* namespace license */
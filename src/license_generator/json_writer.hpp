@@ -0,0 +1,64 @@
+/*
+ * json_writer.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_JSON_WRITER_HPP_
+#define SRC_LICENSE_GENERATOR_JSON_WRITER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace license {
+
+/**
+ * Streaming JSON serializer: values are appended to a string as they are given, without building a document first.
+ * Commas and colons are placed by the writer, the caller only opens and closes objects and arrays. The output is on a
+ * single line, with a space after commas and colons as the other JSON printed by lccgen: an object written alone is a
+ * valid JSON lines record.
+ *
+ * <p>Strings are written as they are (UTF-8): only quotes, backslashes and control characters are escaped.</p>
+ */
+class JsonWriter {
+private:
+	std::string &m_out;
+	// one entry per open object or array: true until its first element is written
+	std::vector<bool> m_empty;
+	// a key has been written, its value comes next
+	bool m_after_key;
+	void separate();
+
+public:
+	/**
+	 * @param out
+	 * 			the JSON is appended to it.
+	 */
+	explicit JsonWriter(std::string &out);
+	JsonWriter(const JsonWriter &) = delete;
+	JsonWriter &operator=(const JsonWriter &) = delete;
+	JsonWriter &begin_object();
+	JsonWriter &end_object();
+	JsonWriter &begin_array();
+	JsonWriter &end_array();
+	JsonWriter &key(const std::string &name);
+	JsonWriter &value(const std::string &value);
+	JsonWriter &value(const char *value);
+	JsonWriter &value(bool value);
+	JsonWriter &number(uint64_t value);
+	// six significant digits, null if the value is not finite
+	JsonWriter &real(double value);
+	JsonWriter &null();
+	// true when every object and array opened has been closed
+	inline bool complete() const { return m_empty.empty() && !m_after_key; }
+	/**
+	 * Append a string literal, quotes included.
+	 */
+	static void write_string(std::string &out, const char *data, size_t size);
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_JSON_WRITER_HPP_ */
@@ -0,0 +1,151 @@
+/*
+ * keystore.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "keystore.hpp"
+#include "profiler.hpp"
+
+namespace license {
+using namespace std;
+
+static const char KEYSTORE_MAGIC[8] = {'L', 'C', 'C', 'K', 'E', 'Y', 'S', '\0'};
+static const uint32_t KEYSTORE_VERSION = 1;
+static const size_t FINGERPRINT_SIZE = 32;
+static const char *const KEYSTORE_KIND = "keystore";
+
+// a key of the keystore. Names are in the heap, offsets of the keys are relative to the keys section.
+struct KeystoreRecord {
+	uint32_t name_offset;
+	uint32_t name_size;
+	unsigned char fingerprint[FINGERPRINT_SIZE];
+	uint64_t key_offset;
+	uint32_t key_size;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(KeystoreRecord) == 56, "keystore record layout");
+
+// raw bytes of a hex fingerprint, empty if it is not a SHA-256 fingerprint
+static const string parse_fingerprint(const string &hex) {
+	string raw;
+	if (hex.size() != FINGERPRINT_SIZE * 2) {
+		return raw;
+	}
+	for (size_t i = 0; i < hex.size(); i += 2) {
+		const string byte = hex.substr(i, 2);
+		if (byte.find_first_not_of("0123456789abcdefABCDEF") != string::npos) {
+			return string();
+		}
+		raw.push_back((char)stoul(byte, nullptr, 16));
+	}
+	return raw;
+}
+
+const size_t Keystore::NOT_FOUND;
+
+KeystoreWriter::KeystoreWriter(const std::string &file_name) : m_file_name(file_name) {}
+
+void KeystoreWriter::add(const std::string &project_name, const CryptoHelper &private_key) {
+	if (!m_names.insert(project_name).second) {
+		throw invalid_argument("project [" + project_name + "] is already in the keystore");
+	}
+	const vector<unsigned char> der = private_key.exportPrivateKeyDer();
+	const Entry entry = {project_name, parse_fingerprint(private_key.publicKeyFingerprint()), m_keys.size(),
+						 der.size()};
+	if (entry.fingerprint.empty()) {
+		throw logic_error("unexpected fingerprint of the key of project [" + project_name + "]");
+	}
+	m_entries.push_back(entry);
+	m_keys.append(der.begin(), der.end());
+}
+
+void KeystoreWriter::finish() {
+	SortedTableWriter table(KEYSTORE_MAGIC, KEYSTORE_VERSION, KEYSTORE_KIND);
+	sort(m_entries.begin(), m_entries.end(),
+		 [](const Entry &a, const Entry &b) { return a.project_name < b.project_name; });
+	const vector<uint32_t> by_fingerprint = table.sorted_index(m_entries.size(), [this](uint32_t a, uint32_t b) {
+		return m_entries[a].fingerprint < m_entries[b].fingerprint;
+	});
+	vector<KeystoreRecord> records(m_entries.size());
+	for (size_t i = 0; i < m_entries.size(); i++) {
+		const Entry &entry = m_entries[i];
+		KeystoreRecord &record = records[i];
+		record.name_offset = table.add_string(entry.project_name);
+		record.name_size = (uint32_t)entry.project_name.size();
+		memcpy(record.fingerprint, entry.fingerprint.data(), FINGERPRINT_SIZE);
+		record.key_offset = entry.offset;
+		record.key_size = (uint32_t)entry.size;
+		record.reserved = 0;
+	}
+	table.write(m_file_name, records.data(), sizeof(KeystoreRecord), records.size(), by_fingerprint, m_keys);
+}
+
+static bool valid_record(const SortedTable &table, size_t index) {
+	const KeystoreRecord &record = *static_cast<const KeystoreRecord *>(table.record(index));
+	return table.has_string(record.name_offset, record.name_size) && table.has_data(record.key_offset, record.key_size);
+}
+
+Keystore::Keystore(const std::string &file_name)
+	: m_table(file_name, KEYSTORE_MAGIC, KEYSTORE_VERSION, sizeof(KeystoreRecord), KEYSTORE_KIND, valid_record) {
+	m_loaded.resize(m_table.size());
+}
+
+const KeystoreRecord &Keystore::record(size_t index) const {
+	return *static_cast<const KeystoreRecord *>(m_table.record(index));
+}
+
+const std::string Keystore::project_name(size_t index) const {
+	const KeystoreRecord &record = this->record(index);
+	return string(m_table.strings() + record.name_offset, record.name_size);
+}
+
+const std::string Keystore::fingerprint(size_t index) const {
+	static const char HEX[] = "0123456789abcdef";
+	const KeystoreRecord &record = this->record(index);
+	string hex(FINGERPRINT_SIZE * 2, '0');
+	for (size_t i = 0; i < FINGERPRINT_SIZE; i++) {
+		hex[i * 2] = HEX[record.fingerprint[i] >> 4];
+		hex[i * 2 + 1] = HEX[record.fingerprint[i] & 0xf];
+	}
+	return hex;
+}
+
+size_t Keystore::find(const std::string &project_name) const {
+	return m_table.find([this, &project_name](size_t index) {
+		const KeystoreRecord &record = this->record(index);
+		return m_table.compare_string(record.name_offset, record.name_size, project_name);
+	});
+}
+
+size_t Keystore::find_fingerprint(const std::string &fingerprint) const {
+	const string raw = parse_fingerprint(fingerprint);
+	if (raw.empty()) {
+		return NOT_FOUND;
+	}
+	const size_t position = m_table.find([this, &raw](size_t position) {
+		return memcmp(record(m_table.indexed(position)).fingerprint, raw.data(), FINGERPRINT_SIZE);
+	});
+	return position == NOT_FOUND ? NOT_FOUND : m_table.indexed(position);
+}
+
+std::shared_ptr<const CryptoHelper> Keystore::key(size_t index) const {
+	lock_guard<mutex> guard(m_mutex);
+	if (m_loaded[index]) {
+		return m_loaded[index];
+	}
+	StageTimer timer(Stage::KEY_LOAD);
+	const KeystoreRecord &record = this->record(index);
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKeyDer(reinterpret_cast<const unsigned char *>(m_table.data()) + record.key_offset,
+							  record.key_size);
+	m_loaded[index] = shared_ptr<const CryptoHelper>(crypto.release());
+	return m_loaded[index];
+}
+
+} /* namespace license */
@@ -0,0 +1,106 @@
+/*
+ * keystore.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_KEYSTORE_HPP_
+#define SRC_LICENSE_GENERATOR_KEYSTORE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../base_lib/crypto_helper.hpp"
+#include "mapped_file.hpp"
+
+namespace license {
+
+struct KeystoreRecord;
+
+/**
+ * Writes the private keys of many projects in a single keystore file.
+ *
+ * <p>The keystore is a SortedTable of the keys sorted by project name, with an index of the same keys sorted by
+ * fingerprint. Project names are stored in the string heap, the keys in the data section in pkcs#1 DER format. The
+ * file is written atomically by finish().</p>
+ */
+class KeystoreWriter {
+private:
+	struct Entry {
+		std::string project_name;
+		// SHA-256 of the public key
+		std::string fingerprint;
+		uint64_t offset;
+		uint64_t size;
+	};
+	const std::string m_file_name;
+	std::vector<Entry> m_entries;
+	std::unordered_set<std::string> m_names;
+	std::string m_keys;
+
+public:
+	explicit KeystoreWriter(const std::string &file_name);
+	KeystoreWriter(const KeystoreWriter &) = delete;
+	KeystoreWriter &operator=(const KeystoreWriter &) = delete;
+	/**
+	 * @throws invalid_argument if the project is already in the keystore.
+	 */
+	void add(const std::string &project_name, const CryptoHelper &private_key);
+	inline bool contains(const std::string &project_name) const { return m_names.count(project_name) > 0; }
+	inline size_t size() const { return m_entries.size(); }
+	/**
+	 * Sort the indexes and write the keystore file.
+	 */
+	void finish();
+};
+
+/**
+ * A keystore file, mapped in memory. Keys are found by binary search on the indexes and parsed only when they are
+ * requested, then cached: opening a keystore of thousands of projects to sign with a few of them reads only the pages
+ * of those keys. It's safe to use the same keystore from multiple threads.
+ */
+class Keystore {
+private:
+	// records sorted by project name, indexed by fingerprint
+	const SortedTable m_table;
+	mutable std::mutex m_mutex;
+	mutable std::vector<std::shared_ptr<const CryptoHelper>> m_loaded;
+	const KeystoreRecord &record(size_t index) const;
+
+public:
+	static const size_t NOT_FOUND = SortedTable::NOT_FOUND;
+	/**
+	 * @throws runtime_error if the file can't be mapped or is not a valid keystore.
+	 */
+	explicit Keystore(const std::string &file_name);
+	Keystore(const Keystore &) = delete;
+	Keystore &operator=(const Keystore &) = delete;
+	inline size_t size() const { return m_table.size(); }
+	// keys are numbered in project name order
+	const std::string project_name(size_t index) const;
+	// hex encoded, as CryptoHelper::publicKeyFingerprint()
+	const std::string fingerprint(size_t index) const;
+	/**
+	 * @return the number of the key of a project, NOT_FOUND if the project isn't in the keystore.
+	 */
+	size_t find(const std::string &project_name) const;
+	/**
+	 * @param fingerprint
+	 * 			hex encoded SHA-256 of the public key, as CryptoHelper::publicKeyFingerprint().
+	 * @return the number of the key, NOT_FOUND if it isn't in the keystore.
+	 */
+	size_t find_fingerprint(const std::string &fingerprint) const;
+	/**
+	 * The private key, loaded the first time it is requested.
+	 */
+	std::shared_ptr<const CryptoHelper> key(size_t index) const;
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_KEYSTORE_HPP_ */
@@ -6,11 +6,13 @@
  */
 #define SI_SUPPORT_IOSTREAMS
 
-#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <iterator>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
-#include <unordered_set>
 #include <stdexcept>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
@@ -18,166 +20,608 @@
 #include "../ini/SimpleIni.h"
 #include "../base_lib/crypto_helper.hpp"
 #include "../base_lib/base.h"
+#include "binary_license.hpp"
+#include "date_parser.hpp"
+#include "json_license.hpp"
 #include "license.hpp"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
+#include "parameter_schema.hpp"
+#include "profiler.hpp"
 
 namespace license {
 using namespace std;
 namespace fs = boost::filesystem;
 
-static const unordered_set<string> NO_OUTPUT_PARAM = {
-	PARAM_BASE64,		  PARAM_LICENSE_OUTPUT, PARAM_FEATURE_NAMES,
-	PARAM_PROJECT_FOLDER, PARAM_PRIMARY_KEY,	PARAM_MAGIC_NUMBER,
-};
-
-const std::string formats[] = {"%4u-%2u-%2u", "%4u/%2u/%2u", "%4u%2u%2u"};
-const size_t formats_n = 3;
-
-static const string normalize_date(const std::string &sDate) {
-	if (sDate.size() < 8) throw invalid_argument("Date string too small for known formats");
-	unsigned int year, month, day;
-	bool found = false;
-	for (size_t i = 0; i < formats_n && !found; ++i) {
-		const int chread = sscanf(sDate.c_str(), formats[i].c_str(), &year, &month, &day);
-		if (chread == 3) {
-			found = true;
+// append value without its leading and trailing spaces, as boost::algorithm::trim_copy would
+static void append_trimmed(string &buf, const char *value) {
+	const auto is_space = boost::algorithm::is_space();
+	const char *begin = value;
+	const char *end = value + strlen(value);
+	while (begin != end && is_space(*begin)) {
+		begin++;
+	}
+	while (end != begin && is_space(*(end - 1))) {
+		end--;
+	}
+	buf.append(begin, end);
+}
+
+/**
+ * The text signed for a section: the upper case feature name followed by the trimmed keys and values. It is built in
+ * a single string sized upfront, it runs for every section signed or verified.
+ */
+static const string print_for_sign(const string &feature_name, const CSimpleIniA::TKeyVal *section) {
+	StageTimer timer(Stage::CANONICALIZATION);
+	size_t size = feature_name.size();
+	for (const auto &it : *section) {
+		size += strlen(it.first.pItem) + strlen(it.second);
+	}
+	string buf;
+	buf.reserve(size);
+	buf.append(feature_name);
+	boost::to_upper(buf);
+	for (const auto &it : *section) {
+		if (strcmp(it.first.pItem, LICENSE_SIGNATURE) != 0) {
+			append_trimmed(buf, it.first.pItem);
+			append_trimmed(buf, it.second);
+		}
+	}
+	return buf;
+}
+
+License::License(const std::string *licenseName, const std::string &project_folder, bool base64,
+				 AtomicFileWriter *file_writer)
+	: m_base64(base64),
+	  m_license_fname(licenseName),
+	  m_owned_project(new ProjectContext(project_folder)),
+	  m_project(m_owned_project.get()),
+	  m_file_writer(file_writer),
+	  m_sink(nullptr),
+	  m_format(LicenseFormat::INI) {
+	reset(licenseName);
+}
+
+License::License(const ProjectContext &project, const std::string *licenseName, bool base64,
+				 AtomicFileWriter *file_writer)
+	: m_base64(base64),
+	  m_license_fname(licenseName),
+	  m_project(&project),
+	  m_file_writer(file_writer),
+	  m_sink(nullptr),
+	  m_format(LicenseFormat::INI) {
+	reset(licenseName);
+}
+
+void License::reset(const std::string *licenseName) {
+	m_license_fname = licenseName;
+	m_feature_names = m_project->default_features();
+	m_private_key = m_project->private_key_file();
+	values_map.clear();
+	m_signed_sections = 0;
+	m_unchanged_sections = 0;
+}
+
+/**
+ * Add the parameters to the license sections and sign them. Sections whose content did not change keep their
+ * signature if it's valid.
+ */
+static void sign_sections(CSimpleIniA &ini, const string &feature_names, const map<string, string> &values_map,
+						  const CryptoHelper &crypto, vector<string> &signed_features, size_t &unchanged_count) {
+	const string features = boost::to_upper_copy(feature_names);
+	vector<string> feature_v;
+	boost::algorithm::split(feature_v, features, boost::is_any_of(","));
+
+	signed_features.clear();
+	unchanged_count = 0;
+	for (const string &feature : feature_v) {
+		// signed content of the section already on disk (if any)
+		const char *stored_signature = ini.GetValue(feature.c_str(), LICENSE_SIGNATURE, nullptr);
+		const bool signed_before = stored_signature != nullptr;
+		const string previous_signature(signed_before ? stored_signature : "");
+		string previous_for_sign;
+		if (signed_before) {
+			previous_for_sign = print_for_sign(feature, ini.GetSection(feature.c_str()));
+		}
+		ini.SetLongValue(feature.c_str(), "lic_ver", LICENSE_FILE_VERSION);
+		for (const auto &it : values_map) {
+			ini.SetValue(feature.c_str(), it.first.c_str(), it.second.c_str());
+		}
+		const CSimpleIniA::TKeyVal *section = ini.GetSection(feature.c_str());
+		string license_for_sign = print_for_sign(feature, section);
+		// verification only needs the public key and is much cheaper than signing. It also catches
+		// signatures made with a key that has been rotated since.
+		StageTimer timer(Stage::SIGNING);
+		if (signed_before && license_for_sign == previous_for_sign &&
+			crypto.verifySignature(license_for_sign, previous_signature)) {
+			Metrics::add(Counter::SIGNATURES_VERIFIED);
+			unchanged_count++;
+			continue;
+		}
+		const auto sign_start = chrono::steady_clock::now();
+		const string signature = crypto.signString(license_for_sign);
+		Metrics::observe(Histogram::SIGNATURE_LATENCY,
+						 (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - sign_start)
+							 .count());
+		Metrics::add(Counter::SECTIONS_SIGNED);
+		timer.stop();
+		ini.SetValue(feature.c_str(), LICENSE_SIGNATURE, signature.c_str());
+		signed_features.push_back(feature);
+	}
+}
+
+// comments are kept by SimpleIni but they can't be read back, licenses with comments are saved by SimpleIni itself
+static bool has_comments(const string &license) {
+	size_t line = 0;
+	while (line < license.size()) {
+		const size_t first = license.find_first_not_of(" \t\r", line);
+		if (first != string::npos && (license[first] == ';' || license[first] == '#')) {
+			return true;
+		}
+		const size_t end = license.find('\n', line);
+		line = end == string::npos ? license.size() : end + 1;
+	}
+	return false;
+}
+
+static bool load_order(const CSimpleIniA::Entry &a, const CSimpleIniA::Entry &b) { return a.nOrder < b.nOrder; }
+
+/**
+ * Serialize the license in the same format of CSimpleIniA::Save, without going through its streams.
+ * Section headers, keys and values are collected in scratch, while signatures are referenced directly from the ini,
+ * so a license with n sections is made of about 2n+1 segments.
+ */
+static void serialize_license(const CSimpleIniA &ini, bool comments, string &scratch, vector<Segment> &segments) {
+	StageTimer timer(Stage::SERIALIZATION);
+	scratch.clear();
+	segments.clear();
+	if (comments) {
+		ini.Save(scratch, true);
+		const Segment segment = {scratch.data(), scratch.size()};
+		segments.push_back(segment);
+		return;
+	}
+	// scratch may be reallocated while it grows: its segments are recorded as offsets and resolved at the end
+	const Segment scratch_marker = {nullptr, 0};
+	size_t scratch_start = 0;
+	vector<size_t> scratch_offsets;
+	auto close_scratch = [&]() {
+		if (scratch.size() > scratch_start) {
+			Segment segment = scratch_marker;
+			segment.size = scratch.size() - scratch_start;
+			segments.push_back(segment);
+			scratch_offsets.push_back(scratch_start);
+			scratch_start = scratch.size();
+		}
+	};
+
+	CSimpleIniA::TNamesDepend sections;
+	ini.GetAllSections(sections);
+	sections.sort(CSimpleIniA::Entry::LoadOrder());
+	vector<CSimpleIniA::Entry> keys;
+	bool need_new_line = false;
+	for (const auto &section : sections) {
+		if (need_new_line) {
+			scratch.append(SI_NEWLINE_A SI_NEWLINE_A);
+		}
+		if (*section.pItem) {
+			scratch.append("[").append(section.pItem).append("]" SI_NEWLINE_A);
+		}
+		const CSimpleIniA::TKeyVal *values = ini.GetSection(section.pItem);
+		keys.clear();
+		for (const auto &it : *values) {
+			keys.push_back(it.first);
+		}
+		sort(keys.begin(), keys.end(), load_order);
+		for (const auto &key : keys) {
+			const char *value = values->find(key)->second;
+			scratch.append(key.pItem).append(" = ");
+			if (strcmp(key.pItem, LICENSE_SIGNATURE) == 0) {
+				close_scratch();
+				const Segment segment = {value, strlen(value)};
+				segments.push_back(segment);
+			} else {
+				scratch.append(value);
+			}
+			scratch.append(SI_NEWLINE_A);
+		}
+		need_new_line = true;
+	}
+	scratch.append(SI_NEWLINE_A);
+	close_scratch();
+
+	size_t next_offset = 0;
+	for (auto &segment : segments) {
+		if (segment.data == nullptr) {
+			segment.data = scratch.data() + scratch_offsets[next_offset++];
+		}
+	}
+}
+
+// format of a license, INI if it is neither binary nor JSON
+static LicenseFormat detect_format(const char *data, size_t size) {
+	if (is_binary_license(data, size)) {
+		return LicenseFormat::BINARY;
+	}
+	return is_json_license(data, size) ? LicenseFormat::JSON : LicenseFormat::INI;
+}
+
+/**
+ * Load a license in any format.
+ * @return false if the data is not a valid INI license.
+ * @throws runtime_error if the data is a corrupted binary or JSON license.
+ */
+static bool load_license(const char *data, size_t size, CSimpleIniA &ini) {
+	vector<LicenseSection> sections;
+	switch (detect_format(data, size)) {
+		case LicenseFormat::BINARY:
+			decode_binary_license(data, size, sections);
+			break;
+		case LicenseFormat::JSON:
+			decode_json_license(data, size, sections);
 			break;
+		default:
+			return size > 0 && ini.LoadData(data, size) == SI_Error::SI_OK;
+	}
+	for (const auto &section : sections) {
+		for (const auto &field : section.fields) {
+			ini.SetValue(section.name.c_str(), field.key.c_str(), field.value.c_str());
 		}
 	}
-	if (!found) throw invalid_argument("Date [" + sDate + "] did not match a known format. try YYYY-MM-DD");
-	ostringstream oss;
-	oss << year << "-" << setfill('0') << std::setw(2) << month << "-" << setfill('0') << std::setw(2) << day;
-	return oss.str();
+	return true;
 }
 
-static const string normalize_project_path(const string &project_path) {
-	const fs::path rproject_path(project_path);
-	if (!fs::exists(rproject_path) || !fs::is_directory(rproject_path)) {
-		throw logic_error("Path " + project_path + " doesn't exist or is not a directory.");
+/**
+ * Serialize the license in the requested format. Binary and JSON licenses are made of a single segment, built in
+ * scratch.
+ */
+static void serialize_license(const CSimpleIniA &ini, bool comments, LicenseFormat format, string &scratch,
+							  vector<Segment> &segments) {
+	if (format == LicenseFormat::INI) {
+		serialize_license(ini, comments, scratch, segments);
+		return;
+	}
+	StageTimer timer(Stage::SERIALIZATION);
+	CSimpleIniA::TNamesDepend section_names;
+	ini.GetAllSections(section_names);
+	section_names.sort(CSimpleIniA::Entry::LoadOrder());
+	vector<LicenseSection> sections(section_names.size());
+	vector<CSimpleIniA::Entry> keys;
+	size_t s = 0;
+	for (const auto &name : section_names) {
+		sections[s].name = name.pItem;
+		const CSimpleIniA::TKeyVal *values = ini.GetSection(name.pItem);
+		keys.clear();
+		for (const auto &it : *values) {
+			keys.push_back(it.first);
+		}
+		sort(keys.begin(), keys.end(), load_order);
+		for (const auto &key : keys) {
+			const LicenseField field = {key.pItem, values->find(key)->second};
+			sections[s].fields.push_back(field);
+		}
+		s++;
 	}
-	fs::path normalized;
-	const string rproject_path_str = rproject_path.string();
-	if (rproject_path.string() == ".") {
-		normalized = fs::current_path();
-		// sometimes is_relative fails under wine: a linux path is taken for a relative path.
-		normalized = fs::canonical(fs::current_path() / rproject_path);
+	if (format == LicenseFormat::BINARY) {
+		encode_binary_license(sections, scratch);
 	} else {
-		normalized = fs::canonical(rproject_path);
+		encode_json_license(sections, scratch);
 	}
-	return normalized.string();
+	segments.clear();
+	const Segment segment = {scratch.data(), scratch.size()};
+	segments.push_back(segment);
 }
 
-static void create_license_path(const string &license_file_name) {
-	const fs::path license_name(license_file_name);
-	fs::path parentPath = license_name.parent_path();
-	if (!parentPath.empty()) {
-		if (!fs::exists(parentPath)) {
-			if (!fs::create_directories(parentPath)) {
-				throw runtime_error("Cannot create licenses directory [" + parentPath.string() + "]");
-			}
-		} else if (fs::is_regular_file(parentPath)) {
-			throw runtime_error("trying to create folder [" + parentPath.string() +
-								"] but there is a file with the same name. ");
+/**
+ * Describe a license for the license index. Values are taken from the section of the given feature.
+ */
+static void describe_license(const CSimpleIniA &ini, const string &feature, const string &license_file,
+							 LicenseRecord &record) {
+	record.path = fs::absolute(license_file).lexically_normal().string();
+	CSimpleIniA::TNamesDepend sections;
+	ini.GetAllSections(sections);
+	sections.sort(CSimpleIniA::Entry::LoadOrder());
+	record.features.clear();
+	for (const auto &section : sections) {
+		if (!record.features.empty()) record.features.push_back(',');
+		record.features.append(section.pItem);
+	}
+	const char *section = feature.c_str();
+	record.valid_from = ini.GetValue(section, PARAM_BEGIN_DATE, "");
+	record.valid_to = ini.GetValue(section, PARAM_EXPIRY_DATE, "");
+	record.client_signature = ini.GetValue(section, PARAM_CLIENT_SIGNATURE, "");
+	record.version_from = ini.GetValue(section, PARAM_VERSION_FROM, "");
+	record.version_to = ini.GetValue(section, PARAM_VERSION_TO, "");
+}
+
+bool License::describe(const std::string &license_file, LicenseRecord &record) {
+	CSimpleIniA ini;
+	try {
+		const MappedFile file(license_file);
+		if (!load_license(file.data(), file.size(), ini)) {
+			return false;
 		}
+	} catch (const runtime_error &) {
+		return false;
+	}
+	CSimpleIniA::TNamesDepend sections;
+	ini.GetAllSections(sections);
+	if (sections.empty()) {
+		return false;
 	}
+	sections.sort(CSimpleIniA::Entry::LoadOrder());
+	describe_license(ini, sections.front().pItem, license_file, record);
+	return true;
 }
 
-static const string print_for_sign(const string &feature_name, const CSimpleIniA::TKeyVal *section) {
-	stringstream buf;
-	buf << boost::to_upper_copy(feature_name);
+bool License::verify(const char *data, size_t size, const CryptoHelper &crypto,
+					 std::vector<SectionVerification> &sections) {
+	sections.clear();
+	CSimpleIniA ini;
+	if (!load_license(data, size, ini)) {
+		return false;
+	}
+	CSimpleIniA::TNamesDepend names;
+	ini.GetAllSections(names);
+	if (names.empty()) {
+		return false;
+	}
+	names.sort(CSimpleIniA::Entry::LoadOrder());
+	for (const auto &name : names) {
+		SectionVerification section;
+		section.feature = name.pItem;
+		const char *signature = ini.GetValue(name.pItem, LICENSE_SIGNATURE, nullptr);
+		if (signature == nullptr) {
+			section.status = SignatureStatus::UNSIGNED;
+		} else {
+			const string license_for_sign = print_for_sign(section.feature, ini.GetSection(name.pItem));
+			StageTimer timer(Stage::SIGNING);
+			section.status =
+				crypto.verifySignature(license_for_sign, signature) ? SignatureStatus::VALID : SignatureStatus::INVALID;
+		}
+		sections.push_back(section);
+	}
+	return true;
+}
+
+// ledger record of a section of a license
+static void ledger_record(const CSimpleIniA &ini, const string &feature, LedgerRecord &record) {
+	record.feature = feature;
+	record.client_signature = ini.GetValue(feature.c_str(), PARAM_CLIENT_SIGNATURE, "");
+	record.signature = ini.GetValue(feature.c_str(), LICENSE_SIGNATURE, "");
+	record.parameters.clear();
+	const CSimpleIniA::TKeyVal *section = ini.GetSection(feature.c_str());
 	for (auto it = section->begin(); it != section->end(); it++) {
-		string key(it->first.pItem);
-		if (key != LICENSE_SIGNATURE) {
-			buf << boost::algorithm::trim_copy(key) << boost::algorithm::trim_copy(string(it->second));
+		if (strcmp(it->first.pItem, LICENSE_SIGNATURE) != 0) {
+			record.parameters.append(it->first.pItem).append("=").append(it->second).append("\n");
+		}
+	}
+}
+
+// one ledger record for each section signed
+static void record_issued(const ProjectContext &project, const string *license_file, const CSimpleIniA &ini,
+						  const vector<string> &signed_features) {
+	LicenseLedger *const ledger = project.ledger();
+	if (ledger == nullptr) {
+		return;
+	}
+	LedgerRecord record;
+	record.issued_at = (uint64_t)time(nullptr);
+	record.output = license_file == nullptr ? string() : *license_file;
+	for (const string &feature : signed_features) {
+		ledger_record(ini, feature, record);
+		ledger->add(record);
+	}
+}
+
+size_t License::resign(const char *data, size_t size, const CryptoHelper &crypto,
+					   const CryptoHelper &previous_crypto, std::string &license_buffer,
+					   std::vector<LedgerRecord> *ledger_records) {
+	const string license(data, size);
+	CSimpleIniA ini;
+	if (!load_license(data, size, ini)) {
+		throw runtime_error("not a license");
+	}
+	CSimpleIniA::TNamesDepend names;
+	ini.GetAllSections(names);
+	if (names.empty()) {
+		throw runtime_error("not a license");
+	}
+	size_t signed_count = 0;
+	for (const auto &name : names) {
+		const string license_for_sign = print_for_sign(name.pItem, ini.GetSection(name.pItem));
+		const char *signature = ini.GetValue(name.pItem, LICENSE_SIGNATURE, nullptr);
+		StageTimer timer(Stage::SIGNING);
+		if (signature != nullptr && crypto.verifySignature(license_for_sign, signature)) {
+			continue;
 		}
+		if (signature == nullptr || !previous_crypto.verifySignature(license_for_sign, signature)) {
+			throw runtime_error(string("section [") + name.pItem + "] is not signed with the previous key");
+		}
+		const string new_signature = crypto.signString(license_for_sign);
+		Metrics::add(Counter::SECTIONS_SIGNED);
+		timer.stop();
+		ini.SetValue(name.pItem, LICENSE_SIGNATURE, new_signature.c_str());
+		signed_count++;
+		if (ledger_records != nullptr) {
+			LedgerRecord record;
+			record.issued_at = (uint64_t)time(nullptr);
+			ledger_record(ini, name.pItem, record);
+			ledger_records->push_back(record);
+		}
+	}
+	if (signed_count > 0) {
+		string scratch;
+		vector<Segment> segments;
+		const LicenseFormat format = detect_format(data, size);
+		serialize_license(ini, format == LicenseFormat::INI && has_comments(license), format, scratch, segments);
+		license_buffer.clear();
+		BufferSink(license_buffer).write(nullptr, segments.data(), segments.size());
+	}
+	return signed_count;
+}
+
+void License::convert(const char *data, size_t size, LicenseFormat format, std::string &out) {
+	CSimpleIniA ini;
+	if (!load_license(data, size, ini)) {
+		throw runtime_error("not a license");
+	}
+	if (detect_format(data, size) == format) {
+		out.assign(data, size);
+		return;
 	}
-	return buf.str();
+	string scratch;
+	vector<Segment> segments;
+	serialize_license(ini, false, format, scratch, segments);
+	out.clear();
+	BufferSink(out).write(nullptr, segments.data(), segments.size());
 }
 
-License::License(const std::string *licenseName, const std::string &project_folder, bool base64)
-	: m_base64(base64), m_license_fname(licenseName), m_project_folder(normalize_project_path(project_folder)) {
-	fs::path proj_folder(m_project_folder);
-	// default feature = project name
-	m_feature_names = proj_folder.filename().string();
-	m_private_key = (proj_folder / PRIVATE_KEY_FNAME).string();
+// record a license written in its file in the index of the project
+static void index_license(const ProjectContext &project, const string &feature_names, const string &license_file,
+						  const CSimpleIniA &ini) {
+	LicenseIndex *const index = project.license_index();
+	if (index == nullptr) {
+		return;
+	}
+	const string features = boost::to_upper_copy(feature_names);
+	LicenseRecord record;
+	describe_license(ini, features.substr(0, features.find(',')), license_file, record);
+	index->add(record);
+}
+
+// bytes of a serialized license
+static size_t license_size(const vector<Segment> &segments) {
+	size_t size = 0;
+	for (const auto &segment : segments) {
+		size += segment.size;
+	}
+	return size;
+}
+
+void License::write_license(std::string &license_buffer, const std::string *previous_license) {
+	const LatencyTimer latency(Histogram::LICENSE_LATENCY);
+	CSimpleIniA ini;
+	StageTimer load_timer(Stage::PREVIOUS_LICENSE_LOAD);
+	if (previous_license != nullptr && !load_license(previous_license->data(), previous_license->size(), ini)) {
+		throw runtime_error("Previous license can't be loaded. Is it a license file?");
+	}
+	load_timer.stop();
+	sign_sections(ini, m_feature_names, values_map, *m_project->crypto(m_private_key), m_signed_features,
+				  m_unchanged_sections);
+	m_signed_sections = m_signed_features.size();
+	const bool comments = previous_license != nullptr &&
+						  detect_format(previous_license->data(), previous_license->size()) == LicenseFormat::INI &&
+						  has_comments(*previous_license);
+	serialize_license(ini, comments, m_format, m_scratch, m_segments);
+	license_buffer.clear();
+	BufferSink(license_buffer).write(m_license_fname, m_segments.data(), m_segments.size());
+	Metrics::add(Counter::LICENSES_ISSUED);
+	Metrics::add(Counter::LICENSE_BYTES, license_buffer.size());
 }
 
 void License::write_license() {
-	ofstream license_stream;
-	ostream *output_license;
+	const LatencyTimer latency(Histogram::LICENSE_LATENCY);
 	CSimpleIniA ini;
-	if (m_license_fname == nullptr) {
-		output_license = &cout;
-	} else {
-		ifstream previous_license(*m_license_fname);
+	bool comments = false;
+	LicenseFormat previous_format = m_format;
+	// with a sink the license name is only a label: files with the same name are unrelated
+	if (m_license_fname != nullptr && m_sink == nullptr) {
+		if (m_file_writer != nullptr && m_file_writer->is_pending(*m_license_fname)) {
+			// a previous version of this license is waiting for its commit.
+			m_file_writer->commit();
+		}
+		StageTimer load_timer(Stage::PREVIOUS_LICENSE_LOAD);
+		ifstream previous_license(*m_license_fname, ios::binary);
 		if (previous_license.is_open()) {
-			SI_Error error = ini.LoadData(previous_license);
-			if (error != SI_Error::SI_OK) {
+			const string previous((istreambuf_iterator<char>(previous_license)), istreambuf_iterator<char>());
+			if (!load_license(previous.data(), previous.size(), ini)) {
 				throw runtime_error(
 					"License file existing, but there were errors in loading it. Is it a license file?");
 			}
+			previous_format = detect_format(previous.data(), previous.size());
+			comments = previous_format == LicenseFormat::INI && has_comments(previous);
 		} else {
+			load_timer.stop();
 			// new license
-			create_license_path(*m_license_fname);
-		}
-		output_license = &license_stream;
-		license_stream.open(*m_license_fname, ios::trunc | ios::binary);
-		if (!license_stream.is_open()) {
-			throw runtime_error("Can not create file [" + *m_license_fname + "].");
+			m_project->directories().create_directories(fs::path(*m_license_fname).parent_path().string());
 		}
 	}
 
-	const string features = boost::to_upper_copy(m_feature_names);
-	vector<string> feature_v;
-	boost::algorithm::split(feature_v, features, boost::is_any_of(","));
-	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
-	crypto->loadPrivateKey_file(m_private_key);
-
-	for (const string feature : feature_v) {
-		ini.SetLongValue(feature.c_str(), "lic_ver", LICENSE_FILE_VERSION);
-		for (auto it : values_map) {
-			ini.SetValue(feature.c_str(), it.first.c_str(), it.second.c_str());
-		}
-		const CSimpleIniA::TKeyVal *section = ini.GetSection(feature.c_str());
-		string license_for_sign = print_for_sign(feature, section);
-		const string signature = crypto->signString(license_for_sign);
-		ini.SetValue(feature.c_str(), LICENSE_SIGNATURE, signature.c_str());
+	sign_sections(ini, m_feature_names, values_map, *m_project->crypto(m_private_key), m_signed_features,
+				  m_unchanged_sections);
+	m_signed_sections = m_signed_features.size();
+	if (m_sink == nullptr && m_license_fname != nullptr && m_signed_sections == 0 && previous_format == m_format &&
+		fs::exists(*m_license_fname)) {
+		// the license on disk is already up to date, nothing to write.
+		index_license(*m_project, m_feature_names, *m_license_fname, ini);
+		return;
+	}
+	serialize_license(ini, comments, m_format, m_scratch, m_segments);
+	StageTimer write_timer(Stage::FILE_WRITE);
+	if (m_sink != nullptr) {
+		m_sink->write(m_license_fname, m_segments.data(), m_segments.size());
+	} else if (m_license_fname == nullptr) {
+		StreamSink(cout).write(m_license_fname, m_segments.data(), m_segments.size());
+	} else if (m_file_writer == nullptr) {
+		AtomicFileWriter file_writer;
+		FileSink(file_writer).write(m_license_fname, m_segments.data(), m_segments.size());
+	} else {
+		FileSink(*m_file_writer).write(m_license_fname, m_segments.data(), m_segments.size());
+	}
+	write_timer.stop();
+	record_issued(*m_project, m_license_fname, ini, m_signed_features);
+	Metrics::add(Counter::LICENSES_ISSUED);
+	Metrics::add(Counter::LICENSE_BYTES, license_size(m_segments));
+	if (m_sink == nullptr && m_license_fname != nullptr) {
+		index_license(*m_project, m_feature_names, *m_license_fname, ini);
 	}
-	ini.Save(*output_license, true);
 }
 
-// TODO better validation on the input parameters
-// TODO, split this code in multiple classes
 void License::add_parameter(const std::string &param_name, const std::string &param_value) {
-	if (NO_OUTPUT_PARAM.find(param_name) == NO_OUTPUT_PARAM.end()) {
-		if (param_name.find("date") != std::string::npos || param_name.find(PARAM_EXPIRY_DATE) != std::string::npos ||
-			param_name.find(PARAM_BEGIN_DATE) != std::string::npos) {
-			values_map[param_name] = normalize_date(param_value);
-		} else if (param_name.find("version") != std::string::npos) {
-			if (param_value != "0") {
-				values_map[param_name] = param_value;
+	const ParameterSchema *schema = find_parameter(param_name);
+	if (schema == nullptr) {
+		// custom parameter, copied as is in the license.
+		values_map[param_name] = param_value;
+		return;
+	}
+	string value;
+	switch (schema->kind) {
+		case ParamKind::STRING:
+			value = param_value;
+			break;
+		case ParamKind::DATE:
+			value = normalize_date(param_value);
+			break;
+		case ParamKind::VERSION:
+			if (param_value == "0") {
+				return;
 			}
-		} else {
-			values_map[param_name] = param_value;
-		}
-	} else if (PARAM_FEATURE_NAMES == param_name) {
-		m_feature_names = param_value;
-		if (m_feature_names.find('[') != std::string::npos || m_feature_names.find(']') != std::string::npos ||
-			m_feature_names.find('/') != std::string::npos || m_feature_names.find('\\') != std::string::npos) {
-			throw invalid_argument(
-				string("feature name should not contain any of '[ ] / \' characters. Parameter " PARAM_FEATURE_NAMES
-					   "value :") +
-				param_name);
-		}
-	} else if (PARAM_PRIMARY_KEY == param_name) {
-		if (!fs::exists(param_value)) {
-			cerr << "Primary key " << param_value << " not found." << endl;
-			throw logic_error("Primary key [" + param_value + "] not found");
-		}
-		m_private_key = param_value;
-	} else if (PARAM_LICENSE_OUTPUT == param_name || PARAM_PROJECT_FOLDER == param_name) {
-		// just ignore
-	} else {
-		throw logic_error(param_name + " not recognized");
+			value = param_value;
+			break;
+		case ParamKind::FEATURE_NAMES:
+			if (param_value.find_first_of("[]/\\") != std::string::npos) {
+				throw invalid_argument(
+					string("feature name should not contain any of '[ ] / \\' characters. Parameter " PARAM_FEATURE_NAMES
+						   " value :") +
+					param_value);
+			}
+			m_feature_names = param_value;
+			return;
+		case ParamKind::PRIMARY_KEY:
+			if (!fs::exists(param_value)) {
+				cerr << "Primary key " << param_value << " not found." << endl;
+				throw logic_error("Primary key [" + param_value + "] not found");
+			}
+			m_private_key = param_value;
+			return;
+		case ParamKind::IGNORED:
+			return;
+		default:
+			throw logic_error(param_name + " not recognized");
+	}
+	if (schema->serialized) {
+		values_map[param_name] = value;
 	}
 }
 } /* namespace license */
@@ -9,10 +9,34 @@
 #define SRC_LICENSE_GENERATOR_LICENSE_HPP_
 #include <boost/optional.hpp>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 #include <iostream>
 
+#include "atomic_file.hpp"
+#include "output_sink.hpp"
+#include "project_context.hpp"
+
 namespace license {
+
+enum class SignatureStatus { VALID, INVALID, UNSIGNED };
+
+enum class LicenseFormat {
+	// INI text, the format read by all the clients
+	INI,
+	// compact binary container, see binary_license.hpp
+	BINARY,
+	// for programs consuming licenses, see json_license.hpp
+	JSON
+};
+
+// result of the verification of a section of a license
+struct SectionVerification {
+	std::string feature;
+	SignatureStatus status;
+};
+
 class License {
 private:
 	std::string m_private_key;
@@ -20,15 +44,121 @@ private:
 
 	const bool m_base64;
 	const std::string *m_license_fname;
-	const std::string m_project_folder;
+	// set only when the license resolves its own project
+	std::unique_ptr<ProjectContext> m_owned_project;
+	const ProjectContext *m_project;
 	std::map<std::string, std::string> values_map;
+	// when null every license is written (and synchronized) on its own
+	AtomicFileWriter *const m_file_writer;
+	size_t m_signed_sections;
+	std::vector<std::string> m_signed_features;
+	size_t m_unchanged_sections;
+	// when null licenses go to the standard output or to their file
+	OutputSink *m_sink;
+	// serialization buffers, kept among licenses to reuse their capacity
+	std::string m_scratch;
+	std::vector<Segment> m_segments;
+	LicenseFormat m_format;
 
 	void print_as_ini(std::istream *previous_license, std::ostream &a_ostream) const;
 
 public:
-	License(const std::string *license_fname, const std::string &project_folder, bool base64 = false);
+	/**
+	 * @param file_writer
+	 * 		optional writer shared among many licenses to group their commits. If null the license file is
+	 * 		written atomically and made durable before write_license() returns.
+	 */
+	License(const std::string *license_fname, const std::string &project_folder, bool base64 = false,
+			AtomicFileWriter *file_writer = nullptr);
+	/**
+	 * Build a license for a project that has already been resolved. The project context is borrowed: it must
+	 * outlive the license.
+	 */
+	License(const ProjectContext &project, const std::string *license_fname, bool base64 = false,
+			AtomicFileWriter *file_writer = nullptr);
+	License(const License &) = delete;
+	License &operator=(const License &) = delete;
+	/**
+	 * Prepare the license object for a new license of the same project: all the parameters are cleared.
+	 * @param license_fname
+	 * 			the output file name of the next license, nullptr for standard output.
+	 */
+	void reset(const std::string *license_fname);
 	void add_parameter(const std::string &param_name, const std::string &param_value);
+	/**
+	 * Send the licenses issued by write_license() to a custom destination (a file descriptor, a pipe, a buffer...)
+	 * instead of the standard output or the license file. The license file name is then only passed to the sink as a
+	 * label: no existing license is read or extended. The sink is borrowed and it is kept by reset().
+	 * @param sink
+	 * 			the destination, nullptr to restore the default one.
+	 */
+	inline void set_sink(OutputSink *sink) { m_sink = sink; }
+	/**
+	 * Format of the licenses issued by write_license(), INI by default. It is kept by reset(). An existing license
+	 * in the other format is converted when it is written again.
+	 */
+	inline void set_format(LicenseFormat format) { m_format = format; }
+	/**
+	 * Write the license. When the license file already exists, sections whose signed content didn't change
+	 * keep their signature (if it is still valid for the current key) and are not signed again. Licenses written in
+	 * a file are recorded in the license index of the project.
+	 */
 	void write_license();
+	/**
+	 * Issue the license in memory, without touching the file system or the standard output. The license is not
+	 * recorded in the ledger of the project: the caller decides if and where it is delivered.
+	 * @param license_buffer
+	 * 			receives the signed license. It is cleared but its capacity is kept, so reusing the same buffer
+	 * 			for many licenses avoids reallocating it.
+	 * @param previous_license
+	 * 			optional content of an existing license to be extended.
+	 */
+	void write_license(std::string &license_buffer, const std::string *previous_license = nullptr);
+	/**
+	 * Describe an existing license file for the license index. Values are taken from its first section.
+	 * @return false if the file can't be loaded as a license.
+	 */
+	static bool describe(const std::string &license_file, LicenseRecord &record);
+	/**
+	 * Verify the signature of every section of a license. The signed text is rebuilt as write_license() builds it.
+	 * @param crypto
+	 * 			key of the project, only its public part is used.
+	 * @param sections
+	 * 			receives the sections in the order they appear in the license.
+	 * @return false if the data can't be parsed as a license.
+	 * @throws runtime_error if the data is a corrupted binary license.
+	 */
+	static bool verify(const char *data, size_t size, const CryptoHelper &crypto,
+					   std::vector<SectionVerification> &sections);
+	/**
+	 * Sign again, after a key rotation, the sections of a license that were signed with the previous key. Content
+	 * and order of the sections are kept.
+	 * @param crypto
+	 * 			the current key of the project.
+	 * @param previous_crypto
+	 * 			the key replaced by the rotation, only its public part is used.
+	 * @param license_buffer
+	 * 			receives the new license. It is not modified if all the signatures are already valid.
+	 * @param ledger_records
+	 * 			optional, receives a ledger record for each section signed again (the output is left empty). They
+	 * 			are meant to be added to the ledger once the license is written.
+	 * @return the number of sections signed again, 0 if the license is already valid.
+	 * @throws runtime_error if the data can't be parsed as a license or if a section is signed by neither key: the
+	 * 			license is not authentic and it is not signed again.
+	 */
+	static size_t resign(const char *data, size_t size, const CryptoHelper &crypto,
+						 const CryptoHelper &previous_crypto, std::string &license_buffer,
+						 std::vector<LedgerRecord> *ledger_records = nullptr);
+	/**
+	 * Convert a license (in any format) to the given format. Signatures are kept: they don't depend on the
+	 * format. Comments of INI licenses are not kept.
+	 * @throws runtime_error if the data can't be parsed as a license.
+	 */
+	static void convert(const char *data, size_t size, LicenseFormat format, std::string &out);
+	// sections signed by the last write_license() call
+	inline size_t signed_sections() const { return m_signed_sections; }
+	// sections of an existing license that were already up to date in the last write_license() call
+	inline size_t unchanged_sections() const { return m_unchanged_sections; }
 	inline virtual ~License() {}
 };
 
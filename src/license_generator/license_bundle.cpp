@@ -0,0 +1,112 @@
+/*
+ * license_bundle.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "license_bundle.hpp"
+
+namespace license {
+using namespace std;
+
+static const char BUNDLE_MAGIC[8] = {'L', 'C', 'C', 'B', 'N', 'D', 'L', '\0'};
+static const uint32_t BUNDLE_VERSION = 1;
+static const char *const BUNDLE_KIND = "license bundle";
+
+// a license of the bundle. Strings are in the heap, offsets of the data are relative to the data section.
+struct BundleRecord {
+	uint32_t name_offset;
+	uint32_t name_size;
+	uint32_t signature_offset;
+	uint32_t signature_size;
+	uint64_t data_offset;
+	uint64_t data_size;
+};
+
+static_assert(sizeof(BundleRecord) == 32, "bundle record layout");
+
+const size_t LicenseBundle::NOT_FOUND;
+
+BundleWriter::BundleWriter(const std::string &file_name) : m_file_name(file_name) {}
+
+void BundleWriter::add(const std::string &name, const std::string &client_signature, const std::string &license) {
+	if (!m_names.insert(name).second) {
+		throw invalid_argument("license [" + name + "] is already in the bundle");
+	}
+	const Entry entry = {name, client_signature, m_data.size(), license.size()};
+	m_entries.push_back(entry);
+	m_data.append(license);
+}
+
+void BundleWriter::finish() {
+	SortedTableWriter table(BUNDLE_MAGIC, BUNDLE_VERSION, BUNDLE_KIND);
+	sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) { return a.name < b.name; });
+	// licenses of the same client stay in name order
+	const vector<uint32_t> by_signature = table.sorted_index(m_entries.size(), [this](uint32_t a, uint32_t b) {
+		return m_entries[a].client_signature < m_entries[b].client_signature;
+	});
+	vector<BundleRecord> records(m_entries.size());
+	for (size_t i = 0; i < m_entries.size(); i++) {
+		const Entry &entry = m_entries[i];
+		BundleRecord &record = records[i];
+		record.name_offset = table.add_string(entry.name);
+		record.name_size = (uint32_t)entry.name.size();
+		record.signature_offset = table.add_string(entry.client_signature);
+		record.signature_size = (uint32_t)entry.client_signature.size();
+		record.data_offset = entry.offset;
+		record.data_size = entry.size;
+	}
+	table.write(m_file_name, records.data(), sizeof(BundleRecord), records.size(), by_signature, m_data);
+}
+
+static bool valid_record(const SortedTable &table, size_t index) {
+	const BundleRecord &record = *static_cast<const BundleRecord *>(table.record(index));
+	return table.has_string(record.name_offset, record.name_size) &&
+		   table.has_string(record.signature_offset, record.signature_size) &&
+		   table.has_data(record.data_offset, record.data_size);
+}
+
+LicenseBundle::LicenseBundle(const std::string &file_name)
+	: m_table(file_name, BUNDLE_MAGIC, BUNDLE_VERSION, sizeof(BundleRecord), BUNDLE_KIND, valid_record) {}
+
+const BundleRecord &LicenseBundle::record(size_t index) const {
+	return *static_cast<const BundleRecord *>(m_table.record(index));
+}
+
+BundleEntry LicenseBundle::entry(size_t index) const {
+	const BundleRecord &record = this->record(index);
+	BundleEntry entry;
+	entry.name.assign(m_table.strings() + record.name_offset, record.name_size);
+	entry.client_signature.assign(m_table.strings() + record.signature_offset, record.signature_size);
+	entry.data = m_table.data() + record.data_offset;
+	entry.size = (size_t)record.data_size;
+	return entry;
+}
+
+int LicenseBundle::compare_signature(size_t index, const std::string &client_signature) const {
+	const BundleRecord &record = this->record(index);
+	return m_table.compare_string(record.signature_offset, record.signature_size, client_signature);
+}
+
+size_t LicenseBundle::find(const std::string &name) const {
+	return m_table.find([this, &name](size_t index) {
+		const BundleRecord &record = this->record(index);
+		return m_table.compare_string(record.name_offset, record.name_size, name);
+	});
+}
+
+std::vector<size_t> LicenseBundle::find_client(const std::string &client_signature) const {
+	const auto compare = [this, &client_signature](size_t position) {
+		return compare_signature(m_table.indexed(position), client_signature);
+	};
+	vector<size_t> found;
+	for (size_t i = m_table.lower_bound(compare); i < m_table.size() && compare(i) == 0; i++) {
+		found.push_back(m_table.indexed(i));
+	}
+	return found;
+}
+
+} /* namespace license */
@@ -0,0 +1,104 @@
+/*
+ * license_bundle.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_LICENSE_BUNDLE_HPP_
+#define SRC_LICENSE_GENERATOR_LICENSE_BUNDLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace license {
+
+struct BundleRecord;
+
+/**
+ * Collects many licenses and writes them in a single bundle file, to ship them together.
+ *
+ * <p>The bundle is a SortedTable of the licenses sorted by name, with an index of the same licenses sorted by client
+ * signature. Names and signatures are stored in the string heap, license contents in the data section. The file is
+ * written atomically by finish().</p>
+ */
+class BundleWriter {
+private:
+	struct Entry {
+		std::string name;
+		std::string client_signature;
+		uint64_t offset;
+		uint64_t size;
+	};
+	const std::string m_file_name;
+	std::vector<Entry> m_entries;
+	std::unordered_set<std::string> m_names;
+	std::string m_data;
+
+public:
+	explicit BundleWriter(const std::string &file_name);
+	BundleWriter(const BundleWriter &) = delete;
+	BundleWriter &operator=(const BundleWriter &) = delete;
+	/**
+	 * Add a license to the bundle.
+	 * @param name
+	 * 			name of the license, eg. its relative path. It must be unique in the bundle.
+	 * @param client_signature
+	 * 			hardware signature the license is linked to, empty if none.
+	 * @throws invalid_argument if a license with the same name is already in the bundle.
+	 */
+	void add(const std::string &name, const std::string &client_signature, const std::string &license);
+	inline bool contains(const std::string &name) const { return m_names.count(name) > 0; }
+	inline size_t size() const { return m_entries.size(); }
+	/**
+	 * Sort the indexes and write the bundle file.
+	 */
+	void finish();
+};
+
+struct BundleEntry {
+	std::string name;
+	std::string client_signature;
+	const char *data;
+	size_t size;
+};
+
+/**
+ * A bundle file, mapped in memory. Licenses are found by binary search on the indexes: only the pages of the
+ * index and of the licenses actually read are loaded.
+ */
+class LicenseBundle {
+private:
+	// records sorted by name, indexed by client signature
+	const SortedTable m_table;
+	const BundleRecord &record(size_t index) const;
+	int compare_signature(size_t index, const std::string &client_signature) const;
+
+public:
+	static const size_t NOT_FOUND = SortedTable::NOT_FOUND;
+	/**
+	 * @throws runtime_error if the file can't be mapped or is not a valid bundle.
+	 */
+	explicit LicenseBundle(const std::string &file_name);
+	LicenseBundle(const LicenseBundle &) = delete;
+	LicenseBundle &operator=(const LicenseBundle &) = delete;
+	inline size_t size() const { return m_table.size(); }
+	// licenses are numbered in name order
+	BundleEntry entry(size_t index) const;
+	/**
+	 * @return the number of the license with the given name, NOT_FOUND if it isn't in the bundle.
+	 */
+	size_t find(const std::string &name) const;
+	/**
+	 * Numbers of the licenses linked to a client signature, in name order.
+	 */
+	std::vector<size_t> find_client(const std::string &client_signature) const;
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_LICENSE_BUNDLE_HPP_ */
@@ -0,0 +1,467 @@
+/*
+ * license_index.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include "atomic_file.hpp"
+#include "date_parser.hpp"
+#include "file_lock.hpp"
+#include "license_index.hpp"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
+#include "output_sink.hpp"
+
+namespace license {
+using namespace std;
+namespace fs = boost::filesystem;
+
+static const char INDEX_MAGIC[8] = {'L', 'C', 'C', 'L', 'I', 'X', '\0', '\0'};
+static const uint32_t INDEX_VERSION = 1;
+// the journal is merged when it's larger than this and than a fraction of the index
+static const uint64_t MIN_COMPACT_SIZE = 1024 * 1024;
+static const uint64_t COMPACT_FRACTION = 4;
+static const size_t JOURNAL_FIELDS = 7;
+
+struct IndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint64_t record_count;
+	uint64_t heap_size;
+};
+
+// a string in the heap that follows the records
+struct IndexString {
+	uint32_t offset;
+	uint32_t size;
+};
+
+struct IndexRecord {
+	uint64_t path_hash;
+	// dates as YYYYMMDD, 0 if not set
+	uint32_t valid_from;
+	uint32_t valid_to;
+	IndexString path;
+	IndexString features;
+	IndexString client_signature;
+	IndexString version_from;
+	IndexString version_to;
+};
+
+static_assert(sizeof(IndexHeader) == 32, "index header layout");
+static_assert(sizeof(IndexRecord) == 56, "index record layout");
+
+static uint64_t path_hash(const char *path, size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ (unsigned char)path[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint32_t pack_date(const string &date) {
+	if (date.size() != DATE_LENGTH || date[4] != '-' || date[7] != '-') {
+		return 0;
+	}
+	uint32_t packed = 0;
+	for (const char c : date) {
+		if (c != '-') {
+			if (c < '0' || c > '9') return 0;
+			packed = packed * 10 + (uint32_t)(c - '0');
+		}
+	}
+	return packed;
+}
+
+static const string unpack_date(uint32_t date) {
+	if (date == 0) {
+		return string();
+	}
+	// room for any uint32_t: a damaged record is shown as it is, not cut
+	char buffer[sizeof("429496-99-99")];
+	snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u", date / 10000, (date / 100) % 100, date % 100);
+	return buffer;
+}
+
+// tabs and new lines would break the journal, they can't appear in paths and signatures issued by lccgen anyway
+static void append_field(string &line, const string &value) {
+	const size_t start = line.size();
+	line.append(value);
+	replace_if(line.begin() + start, line.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+}
+
+/**
+ * The parts of a license the filters look at, taken either from the mapped records or from the journal.
+ */
+struct Candidate {
+	uint32_t valid_to;
+	const char *features;
+	size_t features_size;
+	const char *client_signature;
+	size_t client_signature_size;
+};
+
+class CompiledFilter {
+private:
+	const string m_feature;
+	const string m_client_signature;
+	uint32_t m_expires_after;
+	uint32_t m_expires_before;
+
+public:
+	explicit CompiledFilter(const LicenseFilter &filter)
+		: m_feature(boost::to_upper_copy(filter.feature)),
+		  m_client_signature(filter.client_signature),
+		  m_expires_after(filter.expires_after.empty() ? 0 : pack_date(normalize_date(filter.expires_after))),
+		  m_expires_before(filter.expires_before.empty() ? 0 : pack_date(normalize_date(filter.expires_before))) {}
+
+	bool matches(const Candidate &candidate) const {
+		if (m_expires_after != 0 || m_expires_before != 0) {
+			if (candidate.valid_to == 0 || candidate.valid_to < m_expires_after ||
+				(m_expires_before != 0 && candidate.valid_to > m_expires_before)) {
+				return false;
+			}
+		}
+		if (!m_client_signature.empty() &&
+			(candidate.client_signature_size != m_client_signature.size() ||
+			 memcmp(candidate.client_signature, m_client_signature.data(), m_client_signature.size()) != 0)) {
+			return false;
+		}
+		if (!m_feature.empty()) {
+			const char *token = candidate.features;
+			const char *const end = candidate.features + candidate.features_size;
+			while (token < end) {
+				const char *token_end = (const char *)memchr(token, ',', end - token);
+				if (token_end == nullptr) token_end = end;
+				if ((size_t)(token_end - token) == m_feature.size() &&
+					memcmp(token, m_feature.data(), m_feature.size()) == 0) {
+					return true;
+				}
+				token = token_end + 1;
+			}
+			return false;
+		}
+		return true;
+	}
+};
+
+static Candidate candidate(const LicenseRecord &record) {
+	const Candidate result = {pack_date(record.valid_to), record.features.data(), record.features.size(),
+							  record.client_signature.data(), record.client_signature.size()};
+	return result;
+}
+
+/**
+ * The mapped records of the index, empty if the index doesn't exist yet.
+ */
+class IndexView {
+private:
+	unique_ptr<MappedFile> m_file;
+	const IndexRecord *m_records;
+	size_t m_count;
+	const char *m_heap;
+
+public:
+	explicit IndexView(const string &index_file) : m_records(nullptr), m_count(0), m_heap(nullptr) {
+		if (!fs::exists(index_file)) {
+			return;
+		}
+		m_file.reset(new MappedFile(index_file));
+		IndexHeader header;
+		if (m_file->size() < sizeof(header)) {
+			throw runtime_error("[" + index_file + "] is not a license index");
+		}
+		memcpy(&header, m_file->data(), sizeof(header));
+		if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION ||
+			header.record_size != sizeof(IndexRecord) ||
+			m_file->size() < sizeof(header) + header.record_count * sizeof(IndexRecord) + header.heap_size) {
+			throw runtime_error("[" + index_file + "] is not a license index or it is damaged");
+		}
+		// the header keeps the records 8 bytes aligned
+		m_records = reinterpret_cast<const IndexRecord *>(m_file->data() + sizeof(header));
+		m_count = (size_t)header.record_count;
+		m_heap = m_file->data() + sizeof(header) + m_count * sizeof(IndexRecord);
+	}
+	inline size_t size() const { return m_count; }
+	inline const IndexRecord &operator[](size_t i) const { return m_records[i]; }
+	inline const char *data(const IndexString &str) const { return m_heap + str.offset; }
+	inline const string str(const IndexString &str) const { return string(m_heap + str.offset, str.size); }
+	inline int compare_path(size_t i, const string &path) const {
+		const IndexString &own = m_records[i].path;
+		const int cmp = memcmp(m_heap + own.offset, path.data(), min((size_t)own.size, path.size()));
+		return cmp != 0 ? cmp : (own.size < path.size() ? -1 : (own.size > path.size() ? 1 : 0));
+	}
+	Candidate candidate(size_t i) const {
+		const IndexRecord &record = m_records[i];
+		const Candidate result = {record.valid_to, data(record.features), record.features.size,
+								  data(record.client_signature), record.client_signature.size};
+		return result;
+	}
+	LicenseRecord record(size_t i) const {
+		const IndexRecord &indexed = m_records[i];
+		LicenseRecord record;
+		record.path = str(indexed.path);
+		record.features = str(indexed.features);
+		record.valid_from = unpack_date(indexed.valid_from);
+		record.valid_to = unpack_date(indexed.valid_to);
+		record.client_signature = str(indexed.client_signature);
+		record.version_from = str(indexed.version_from);
+		record.version_to = str(indexed.version_to);
+		return record;
+	}
+};
+
+/**
+ * Journal entries by path: a license written more than once keeps the last entry. Incomplete lines (the process was
+ * interrupted while writing) are skipped.
+ */
+static map<string, LicenseRecord> read_journal(const string &journal_file) {
+	map<string, LicenseRecord> journal;
+	ifstream journal_stream(journal_file, ios::binary);
+	if (!journal_stream.is_open()) {
+		return journal;
+	}
+	const string content((istreambuf_iterator<char>(journal_stream)), istreambuf_iterator<char>());
+	size_t line = 0;
+	while (line < content.size()) {
+		const size_t end = content.find('\n', line);
+		if (end == string::npos) {
+			break;
+		}
+		LicenseRecord record;
+		string *const fields[JOURNAL_FIELDS] = {&record.path,			  &record.features,		&record.valid_from,
+												&record.valid_to,		  &record.client_signature, &record.version_from,
+												&record.version_to};
+		size_t field_start = line, field = 0;
+		for (; field < JOURNAL_FIELDS && field_start <= end; field++) {
+			size_t field_end = content.find('\t', field_start);
+			if (field_end == string::npos || field_end > end) field_end = end;
+			fields[field]->assign(content, field_start, field_end - field_start);
+			field_start = field_end + 1;
+		}
+		if (field == JOURNAL_FIELDS && !record.path.empty()) {
+			journal[record.path] = record;
+		}
+		line = end + 1;
+	}
+	return journal;
+}
+
+/**
+ * Walk the records of the index and of the journal together, in path order. Records of the index replaced in the
+ * journal are skipped.
+ */
+template <typename IndexVisitor, typename JournalVisitor>
+static void merge(const IndexView &index, const map<string, LicenseRecord> &journal, IndexVisitor on_index,
+				  JournalVisitor on_journal) {
+	unordered_set<uint64_t> journal_hashes;
+	journal_hashes.reserve(journal.size());
+	for (const auto &it : journal) {
+		journal_hashes.insert(path_hash(it.first.data(), it.first.size()));
+	}
+	auto next_journal = journal.begin();
+	for (size_t i = 0; i < index.size(); i++) {
+		while (next_journal != journal.end() && index.compare_path(i, next_journal->first) > 0) {
+			on_journal(next_journal->second);
+			++next_journal;
+		}
+		if (next_journal != journal.end() && journal_hashes.count(index[i].path_hash) > 0 &&
+			journal.count(index.str(index[i].path)) > 0) {
+			continue;
+		}
+		on_index(i);
+	}
+	for (; next_journal != journal.end(); ++next_journal) {
+		on_journal(next_journal->second);
+	}
+}
+
+/**
+ * Builds the heap of a new index. Paths are unique, the other values repeat a lot and are stored once.
+ */
+class HeapBuilder {
+private:
+	string m_heap;
+	unordered_map<string, IndexString> m_interned;
+
+public:
+	IndexString add(const char *data, size_t size) {
+		if (m_heap.size() + size > UINT32_MAX) {
+			throw runtime_error("License index too large");
+		}
+		const IndexString result = {(uint32_t)m_heap.size(), (uint32_t)size};
+		m_heap.append(data, size);
+		return result;
+	}
+	IndexString intern(const char *data, size_t size) {
+		const string value(data, size);
+		const auto it = m_interned.find(value);
+		if (it != m_interned.end()) {
+			return it->second;
+		}
+		const IndexString result = add(data, size);
+		m_interned[value] = result;
+		return result;
+	}
+	inline const string &heap() const { return m_heap; }
+};
+
+LicenseIndex::LicenseIndex(const std::string &project_folder)
+	: m_project_folder(project_folder), m_pending_count(0) {}
+
+void LicenseIndex::add(const LicenseRecord &record) {
+	lock_guard<mutex> guard(m_mutex);
+	const string *const fields[JOURNAL_FIELDS] = {&record.path,			   &record.features,	 &record.valid_from,
+												  &record.valid_to,		   &record.client_signature, &record.version_from,
+												  &record.version_to};
+	for (size_t i = 0; i < JOURNAL_FIELDS; i++) {
+		if (i > 0) m_pending.push_back('\t');
+		append_field(m_pending, *fields[i]);
+	}
+	m_pending.push_back('\n');
+	Metrics::add(Gauge::PENDING_INDEX_RECORDS, 1);
+	if (++m_pending_count >= MAX_PENDING) {
+		flush_locked(false);
+	}
+}
+
+void LicenseIndex::flush() {
+	lock_guard<mutex> guard(m_mutex);
+	flush_locked(false);
+}
+
+void LicenseIndex::flush_locked(bool compact) {
+	if (m_pending.empty() && !compact) {
+		return;
+	}
+	// other processes append to the journal too: it can't change between its merge and its removal
+	FileLock lock((fs::path(m_project_folder) / LICENSE_INDEX_LOCK_FNAME).string());
+	const string journal_file = (fs::path(m_project_folder) / LICENSE_JOURNAL_FNAME).string();
+	if (!m_pending.empty()) {
+		ofstream journal(journal_file, ios::binary | ios::app);
+		journal.write(m_pending.data(), m_pending.size());
+		journal.close();
+		if (journal.fail()) {
+			throw runtime_error("Can not write the license index journal [" + journal_file + "]");
+		}
+		m_pending.clear();
+		Metrics::add(Gauge::PENDING_INDEX_RECORDS, -(int64_t)m_pending_count);
+		m_pending_count = 0;
+	}
+	const string index_file = (fs::path(m_project_folder) / LICENSE_INDEX_FNAME).string();
+	const uint64_t index_size = fs::exists(index_file) ? fs::file_size(index_file) : 0;
+	const uint64_t journal_size = fs::exists(journal_file) ? fs::file_size(journal_file) : 0;
+	if (compact || journal_size > max(MIN_COMPACT_SIZE, index_size / COMPACT_FRACTION)) {
+		compact_locked();
+	}
+}
+
+void LicenseIndex::compact() {
+	lock_guard<mutex> guard(m_mutex);
+	flush_locked(true);
+}
+
+void LicenseIndex::compact_locked() {
+	const string index_file = (fs::path(m_project_folder) / LICENSE_INDEX_FNAME).string();
+	const string journal_file = (fs::path(m_project_folder) / LICENSE_JOURNAL_FNAME).string();
+	const map<string, LicenseRecord> journal = read_journal(journal_file);
+	if (journal.empty()) {
+		return;
+	}
+	vector<IndexRecord> records;
+	HeapBuilder heap;
+	{
+		const IndexView index(index_file);
+		records.reserve(index.size() + journal.size());
+		merge(
+			index, journal,
+			[&](size_t i) {
+				const IndexRecord &old = index[i];
+				IndexRecord record = old;
+				record.path = heap.add(index.data(old.path), old.path.size);
+				record.features = heap.intern(index.data(old.features), old.features.size);
+				record.client_signature = heap.intern(index.data(old.client_signature), old.client_signature.size);
+				record.version_from = heap.intern(index.data(old.version_from), old.version_from.size);
+				record.version_to = heap.intern(index.data(old.version_to), old.version_to.size);
+				records.push_back(record);
+			},
+			[&](const LicenseRecord &added) {
+				IndexRecord record;
+				record.path_hash = path_hash(added.path.data(), added.path.size());
+				record.valid_from = pack_date(added.valid_from);
+				record.valid_to = pack_date(added.valid_to);
+				record.path = heap.add(added.path.data(), added.path.size());
+				record.features = heap.intern(added.features.data(), added.features.size());
+				record.client_signature = heap.intern(added.client_signature.data(), added.client_signature.size());
+				record.version_from = heap.intern(added.version_from.data(), added.version_from.size());
+				record.version_to = heap.intern(added.version_to.data(), added.version_to.size());
+				records.push_back(record);
+			});
+	}
+	IndexHeader header;
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.version = INDEX_VERSION;
+	header.record_size = sizeof(IndexRecord);
+	header.record_count = records.size();
+	header.heap_size = heap.heap().size();
+	const Segment segments[] = {{(const char *)&header, sizeof(header)},
+								{(const char *)records.data(), records.size() * sizeof(IndexRecord)},
+								{heap.heap().data(), heap.heap().size()}};
+	{
+		AtomicFileWriter file_writer;
+		file_writer.write(index_file, segments, sizeof(segments) / sizeof(segments[0]));
+	}
+	// if the process stops before this the journal is merged again next time, with the same result
+	fs::remove(journal_file);
+}
+
+size_t LicenseIndex::query(const LicenseFilter &filter, const std::function<void(const LicenseRecord &)> &found) {
+	const CompiledFilter compiled(filter);
+	map<string, LicenseRecord> journal;
+	{
+		lock_guard<mutex> guard(m_mutex);
+		flush_locked(false);
+		journal = read_journal((fs::path(m_project_folder) / LICENSE_JOURNAL_FNAME).string());
+	}
+	const IndexView index((fs::path(m_project_folder) / LICENSE_INDEX_FNAME).string());
+	size_t count = 0;
+	merge(
+		index, journal,
+		[&](size_t i) {
+			if (compiled.matches(index.candidate(i))) {
+				count++;
+				found(index.record(i));
+			}
+		},
+		[&](const LicenseRecord &record) {
+			if (compiled.matches(candidate(record))) {
+				count++;
+				found(record);
+			}
+		});
+	return count;
+}
+
+LicenseIndex::~LicenseIndex() {
+	try {
+		flush();
+	} catch (const exception &e) {
+		cerr << "Error updating the license index: " << e.what() << endl;
+	}
+}
+
+} /* namespace license */
@@ -0,0 +1,114 @@
+/*
+ * license_index.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_LICENSE_INDEX_HPP_
+#define SRC_LICENSE_GENERATOR_LICENSE_INDEX_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace license {
+
+/**
+ * Index of the licenses issued for a project, in the project folder.
+ */
+#define LICENSE_INDEX_FNAME ".lcc_licenses"
+/**
+ * Licenses issued since the index was last compacted.
+ */
+#define LICENSE_JOURNAL_FNAME ".lcc_licenses.journal"
+/**
+ * Locked by the processes writing the journal or compacting the index. It is never replaced.
+ */
+#define LICENSE_INDEX_LOCK_FNAME ".lcc_licenses.lock"
+
+/**
+ * What the index knows about a license. Values are the ones of the first feature issued.
+ */
+struct LicenseRecord {
+	// absolute path of the license file
+	std::string path;
+	// comma separated sections of the license
+	std::string features;
+	// YYYY-MM-DD, empty if the license has no limit
+	std::string valid_from;
+	std::string valid_to;
+	std::string client_signature;
+	std::string version_from;
+	std::string version_to;
+};
+
+/**
+ * Conditions a license must satisfy to be listed. Empty conditions match every license.
+ */
+struct LicenseFilter {
+	// one of the sections of the license (case insensitive)
+	std::string feature;
+	std::string client_signature;
+	// YYYY-MM-DD: licenses expiring on this day or later. Licenses without expiry never match expiry conditions.
+	std::string expires_after;
+	// YYYY-MM-DD: licenses expiring on this day or before.
+	std::string expires_before;
+};
+
+/**
+ * Index of the licenses of a project, updated by License::write_license and queried by `license list`.
+ *
+ * <p>The index is made of two files. LICENSE_INDEX_FNAME holds fixed size records sorted by path followed by a heap
+ * of strings: it is memory mapped and scanned without parsing, filters on dates and signatures are comparisons of
+ * integers and of strings in place. New licenses are appended to a text journal (LICENSE_JOURNAL_FNAME) that is
+ * merged in the records when it grows past a fraction of them, so that issuing a license doesn't rewrite the index.
+ * A license written again replaces its previous record.</p>
+ *
+ * <p>Additions are buffered in memory and written by flush() (or by the destructor). The index is safe to use from
+ * multiple threads of a process. The journal is appended and the index compacted holding an exclusive lock on
+ * LICENSE_INDEX_LOCK_FNAME, so that several processes can issue licenses for the same project at the same time.
+ * Queries don't lock.</p>
+ */
+class LicenseIndex {
+private:
+	const std::string m_project_folder;
+	std::mutex m_mutex;
+	// journal lines waiting to be written
+	std::string m_pending;
+	size_t m_pending_count;
+	// compact: merge the journal even if it is small
+	void flush_locked(bool compact);
+	void compact_locked();
+
+public:
+	// additions kept in memory at most, before they are written in the journal
+	static const size_t MAX_PENDING = 65536;
+	explicit LicenseIndex(const std::string &project_folder);
+	LicenseIndex(const LicenseIndex &) = delete;
+	LicenseIndex &operator=(const LicenseIndex &) = delete;
+	/**
+	 * Record a license that has been written. If the same path was recorded before it is replaced.
+	 */
+	void add(const LicenseRecord &record);
+	/**
+	 * Write the pending additions to the journal, compacting the index if the journal has grown too large.
+	 */
+	void flush();
+	/**
+	 * Merge the journal in the records.
+	 */
+	void compact();
+	/**
+	 * Find the licenses matching a filter, in path order.
+	 * @return the number of licenses found.
+	 * @throws invalid_argument if a date of the filter is not valid.
+	 */
+	size_t query(const LicenseFilter &filter, const std::function<void(const LicenseRecord &)> &found);
+	virtual ~LicenseIndex();
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_LICENSE_INDEX_HPP_ */
@@ -0,0 +1,194 @@
+/*
+ * license_layout.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#include "atomic_file.hpp"
+#include "license_layout.hpp"
+
+namespace license {
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define LAYOUT_FANOUT_KEY "shard-fanout = "
+
+void DirectoryCache::create_directories(const std::string &directory) {
+	if (directory.empty()) {
+		return;
+	}
+	{
+		lock_guard<mutex> guard(m_mutex);
+		if (m_known.find(directory) != m_known.end()) {
+			m_hits++;
+			return;
+		}
+	}
+	const fs::path dir_path(directory);
+	if (!fs::exists(dir_path)) {
+		boost::system::error_code ec;
+		// another thread or process may be creating the same folder.
+		fs::create_directories(dir_path, ec);
+		if (ec && !fs::is_directory(dir_path)) {
+			throw runtime_error("Cannot create licenses directory [" + directory + "]");
+		}
+	} else if (!fs::is_directory(dir_path)) {
+		throw runtime_error("trying to create folder [" + directory + "] but there is a file with the same name. ");
+	}
+	lock_guard<mutex> guard(m_mutex);
+	m_known.insert(directory);
+}
+
+size_t DirectoryCache::size() {
+	lock_guard<mutex> guard(m_mutex);
+	return m_known.size();
+}
+
+size_t DirectoryCache::hits() {
+	lock_guard<mutex> guard(m_mutex);
+	return m_hits;
+}
+
+static size_t hex_digits(unsigned int value) {
+	size_t digits = 1;
+	while (value >>= 4) {
+		digits++;
+	}
+	return digits;
+}
+
+LicenseLayout::LicenseLayout(const std::string &folder, unsigned int fanout)
+	: m_folder(folder), m_fanout(fanout), m_shard_digits(fanout == 0 ? 0 : max<size_t>(2, hex_digits(fanout - 1))) {}
+
+LicenseLayout LicenseLayout::open(const std::string &folder) {
+	ifstream layout_file((fs::path(folder) / LICENSE_LAYOUT_FNAME).string());
+	if (!layout_file.is_open()) {
+		return LicenseLayout(folder, 0);
+	}
+	string line;
+	unsigned long fanout = 0;
+	const string key(LAYOUT_FANOUT_KEY);
+	while (getline(layout_file, line)) {
+		if (line.compare(0, key.size(), key) == 0) {
+			fanout = strtoul(line.c_str() + key.size(), nullptr, 10);
+		}
+	}
+	if (fanout == 0 || fanout > MAX_FANOUT) {
+		throw runtime_error("Licenses folder [" + folder + "] has an invalid layout file " LICENSE_LAYOUT_FNAME);
+	}
+	return LicenseLayout(folder, (unsigned int)fanout);
+}
+
+LicenseLayout LicenseLayout::open(const std::string &folder, unsigned int fanout) {
+	if (fanout > MAX_FANOUT) {
+		throw invalid_argument("Shard fan-out must be at most " + to_string(MAX_FANOUT));
+	}
+	const LicenseLayout layout = open(folder);
+	if (layout.fanout() == fanout) {
+		return layout;
+	}
+	if (layout.fanout() != 0) {
+		throw invalid_argument("Licenses folder [" + folder + "] is already sharded with fan-out " +
+							   to_string(layout.fanout()) + ", it can't be changed to " + to_string(fanout));
+	}
+	// licenses already in the flat folder are still found (see find()), no need to move them.
+	fs::create_directories(folder);
+	AtomicFileWriter file_writer;
+	file_writer.write((fs::path(folder) / LICENSE_LAYOUT_FNAME).string(),
+					  string(LAYOUT_FANOUT_KEY) + to_string(fanout) + "\n");
+	return LicenseLayout(folder, fanout);
+}
+
+const std::string LicenseLayout::path(const std::string &license_name) const {
+	if (m_fanout == 0) {
+		return (fs::path(m_folder) / license_name).string();
+	}
+	// FNV-1a of the name, with the same separator on every platform
+	uint32_t hash = 2166136261u;
+	for (const char c : license_name) {
+		hash = (hash ^ (uint32_t)(unsigned char)(c == '\\' ? '/' : c)) * 16777619u;
+	}
+	static const char HEX[] = "0123456789abcdef";
+	unsigned int shard = hash % m_fanout;
+	string shard_name(m_shard_digits, '0');
+	for (size_t i = m_shard_digits; i > 0 && shard > 0; i--, shard >>= 4) {
+		shard_name[i - 1] = HEX[shard & 0xf];
+	}
+	return (fs::path(m_folder) / shard_name / license_name).string();
+}
+
+const std::string LicenseLayout::find(const std::string &license_name) const {
+	const string license_path = path(license_name);
+	if (fs::is_regular_file(license_path)) {
+		return license_path;
+	}
+	if (m_fanout != 0) {
+		const fs::path flat_path(fs::path(m_folder) / license_name);
+		if (fs::is_regular_file(flat_path)) {
+			return flat_path.string();
+		}
+	}
+	return string();
+}
+
+bool LicenseLayout::is_shard(const std::string &name) const {
+	if (m_fanout == 0 || name.size() != m_shard_digits) {
+		return false;
+	}
+	unsigned long value = 0;
+	for (const char c : name) {
+		if (c >= '0' && c <= '9') {
+			value = value * 16 + (c - '0');
+		} else if (c >= 'a' && c <= 'f') {
+			value = value * 16 + (c - 'a' + 10);
+		} else {
+			return false;
+		}
+	}
+	return value < m_fanout;
+}
+
+std::vector<std::string> LicenseLayout::list() const {
+	vector<string> names;
+	fs::path root(m_folder);
+	if (!fs::is_directory(root)) {
+		return names;
+	}
+	// a trailing separator iterates as a "." component, not in the paths of the files
+	while (root.filename_is_dot() && root.has_parent_path()) {
+		root.remove_filename();
+	}
+	const size_t root_length = distance(root.begin(), root.end());
+	for (fs::recursive_directory_iterator it(root); it != fs::recursive_directory_iterator(); ++it) {
+		const string file_name = it->path().filename().string();
+		// hidden files: the layout and the temporary files of licenses being written
+		if (!fs::is_regular_file(it->status()) || file_name.empty() || file_name[0] == '.') {
+			continue;
+		}
+		const size_t depth = distance(it->path().begin(), it->path().end());
+		fs::path name;
+		size_t component = 0;
+		for (const auto &part : it->path()) {
+			if (component == root_length && component + 1 < depth && is_shard(part.string())) {
+				// shard folder, not part of the license name
+			} else if (component >= root_length) {
+				name /= part;
+			}
+			component++;
+		}
+		names.push_back(name.generic_string());
+	}
+	sort(names.begin(), names.end());
+	names.erase(unique(names.begin(), names.end()), names.end());
+	return names;
+}
+
+} /* namespace license */
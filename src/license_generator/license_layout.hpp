@@ -0,0 +1,110 @@
+/*
+ * license_layout.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_LICENSE_LAYOUT_HPP_
+#define SRC_LICENSE_GENERATOR_LICENSE_LAYOUT_HPP_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace license {
+
+/**
+ * Name of the file that records the layout of a licenses folder.
+ */
+#define LICENSE_LAYOUT_FNAME ".lcc_layout"
+
+/**
+ * Name of the file, in a licenses folder, that records the licenses already re-signed by an interrupted
+ * <code>license resign</code>.
+ */
+#define RESIGN_JOURNAL_FNAME ".lcc_resign.journal"
+
+/**
+ * Directories known to exist, so that writing many licenses in the same folders doesn't query the file system for
+ * each license. It is meant to live as long as a run: directories removed by someone else in the meanwhile are not
+ * noticed. Safe to use from multiple threads.
+ */
+class DirectoryCache {
+private:
+	std::mutex m_mutex;
+	std::unordered_set<std::string> m_known;
+	size_t m_hits;
+
+public:
+	DirectoryCache() : m_hits(0) {}
+	DirectoryCache(const DirectoryCache &) = delete;
+	DirectoryCache &operator=(const DirectoryCache &) = delete;
+	/**
+	 * Make sure the folder exists, creating it with all its parents if needed.
+	 * @throws runtime_error if the folder can't be created or a file with the same name is in the way.
+	 */
+	void create_directories(const std::string &directory);
+	// folders the cache knows about
+	size_t size();
+	// calls of create_directories() that didn't reach the file system
+	size_t hits();
+};
+
+/**
+ * How license files are placed in a licenses folder.
+ *
+ * <p>By default a license named <code>customer/site/host.lic</code> is stored in
+ * <code>folder/customer/site/host.lic</code>. With a sharded layout licenses are spread among <code>fanout</code>
+ * hash-prefixed subfolders (<code>folder/3a/customer/site/host.lic</code>), so that no directory grows too large.
+ * The fan-out is stored in the LICENSE_LAYOUT_FNAME file of the folder, commands that find or list licenses read it
+ * and resolve the sharded paths transparently.</p>
+ */
+class LicenseLayout {
+private:
+	std::string m_folder;
+	unsigned int m_fanout;
+	// number of hex digits of the shard folders
+	size_t m_shard_digits;
+
+	LicenseLayout(const std::string &folder, unsigned int fanout);
+	bool is_shard(const std::string &name) const;
+
+public:
+	static const unsigned int MAX_FANOUT = 65536;
+	/**
+	 * Open the layout of a licenses folder. If the folder doesn't record a layout it is a flat one.
+	 */
+	static LicenseLayout open(const std::string &folder);
+	/**
+	 * Open the layout of a licenses folder, initializing it with the given fan-out the first time.
+	 * @param fanout
+	 * 			number of shard folders, 0 for a flat layout.
+	 * @throws invalid_argument if the folder already has a different layout: moving the licenses is not supported.
+	 */
+	static LicenseLayout open(const std::string &folder, unsigned int fanout);
+
+	inline const std::string &folder() const { return m_folder; }
+	// 0 for a flat layout
+	inline unsigned int fanout() const { return m_fanout; }
+	/**
+	 * Path where a license is stored.
+	 * @param license_name
+	 * 			name of the license, relative to the licenses folder (eg. customer/host.lic).
+	 */
+	const std::string path(const std::string &license_name) const;
+	/**
+	 * Path of an existing license. Licenses written before the folder was sharded are found too.
+	 * @return the path or an empty string if the license doesn't exist.
+	 */
+	const std::string find(const std::string &license_name) const;
+	/**
+	 * Names (relative to the folder, shard removed) of all the licenses in the folder, sorted.
+	 */
+	std::vector<std::string> list() const;
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_LICENSE_LAYOUT_HPP_ */
@@ -0,0 +1,537 @@
+/*
+ * license_ledger.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "atomic_file.hpp"
+#include "file_lock.hpp"
+#include "license_ledger.hpp"
+#include "mapped_file.hpp"
+#include "output_sink.hpp"
+
+namespace license {
+using namespace std;
+namespace fs = boost::filesystem;
+
+static const char LEDGER_MAGIC[8] = {'L', 'C', 'C', 'L', 'E', 'D', 'G', '\0'};
+static const char LEDGER_INDEX_MAGIC[8] = {'L', 'C', 'C', 'L', 'G', 'I', 'X', '\0'};
+static const uint32_t LEDGER_INDEX_VERSION = 1;
+// "LREC": start of every record, searched to resume reading after a damaged record
+static const uint32_t RECORD_MARKER = 0x4345524cu;
+static const size_t LEDGER_FIELDS = 5;
+// fields of the record used as keys of the index, in the order of LedgerKey
+static const size_t KEY_FIELDS[] = {0, 2};
+static const size_t INDEX_TABLES = sizeof(KEY_FIELDS) / sizeof(KEY_FIELDS[0]);
+// the index is rebuilt when the records it doesn't cover are more than this and than a fraction of the ledger
+static const uint64_t MIN_REINDEX_SIZE = 1024 * 1024;
+static const uint64_t REINDEX_FRACTION = 4;
+
+struct LedgerHeader {
+	char magic[8];
+	uint64_t generation;
+};
+
+struct RecordHeader {
+	uint32_t marker;
+	// bytes of the payload that follows: the issue time, then the fields each preceded by its size
+	uint32_t size;
+	// CRC-32 of the payload
+	uint32_t crc;
+};
+
+struct LedgerIndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t bucket_count;
+	uint64_t generation;
+	// bytes of the ledger covered by the index
+	uint64_t indexed_size;
+	// entries of each table
+	uint64_t entries[INDEX_TABLES];
+};
+
+struct LedgerIndexEntry {
+	uint64_t hash;
+	uint64_t offset;
+};
+
+static_assert(sizeof(LedgerHeader) == 16, "ledger header layout");
+static_assert(sizeof(RecordHeader) == 12, "ledger record layout");
+static_assert(sizeof(LedgerIndexHeader) == 48, "ledger index header layout");
+static_assert(sizeof(LedgerIndexEntry) == 16, "ledger index entry layout");
+
+#ifdef _WIN32
+static int open_append(const string &fname) {
+	return _open(fname.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+static int close_fd(int fd) { return _close(fd); }
+#else
+static int open_append(const string &fname) {
+	return open(fname.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+}
+static int close_fd(int fd) { return close(fd); }
+#endif
+
+namespace {
+// a record in place in the ledger
+struct RecordView {
+	uint64_t issued_at;
+	const char *fields[LEDGER_FIELDS];
+	uint32_t sizes[LEDGER_FIELDS];
+};
+}  // namespace
+
+static uint32_t crc32(const char *data, size_t size) {
+	boost::crc_32_type crc;
+	crc.process_bytes(data, size);
+	return crc.checksum();
+}
+
+static uint64_t key_hash(const char *key, size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ (unsigned char)key[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t new_generation() {
+	random_device device;
+	return ((uint64_t)device() << 32) ^ device() ^ (uint64_t)chrono::system_clock::now().time_since_epoch().count();
+}
+
+static void append_record(string &out, const LedgerRecord &record) {
+	const string *const fields[LEDGER_FIELDS] = {&record.output, &record.feature, &record.client_signature,
+												 &record.parameters, &record.signature};
+	const size_t start = out.size();
+	out.append(sizeof(RecordHeader), '\0');
+	out.append(reinterpret_cast<const char *>(&record.issued_at), sizeof(record.issued_at));
+	for (const string *field : fields) {
+		const uint32_t size = (uint32_t)field->size();
+		out.append(reinterpret_cast<const char *>(&size), sizeof(size));
+		out.append(*field);
+	}
+	const size_t payload = out.size() - start - sizeof(RecordHeader);
+	if (payload > UINT32_MAX) {
+		out.resize(start);
+		throw invalid_argument("License too large for the ledger: " + record.output);
+	}
+	const RecordHeader header = {RECORD_MARKER, (uint32_t)payload,
+								 crc32(out.data() + start + sizeof(RecordHeader), payload)};
+	memcpy(&out[start], &header, sizeof(header));
+}
+
+/**
+ * @return the size of the record at data, 0 if there isn't a valid record there.
+ */
+static size_t read_record(const char *data, size_t available, RecordView &view) {
+	RecordHeader header;
+	if (available < sizeof(header)) {
+		return 0;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (header.marker != RECORD_MARKER || header.size > available - sizeof(header) ||
+		header.size < sizeof(uint64_t) + LEDGER_FIELDS * sizeof(uint32_t)) {
+		return 0;
+	}
+	const char *const payload = data + sizeof(header);
+	if (crc32(payload, header.size) != header.crc) {
+		return 0;
+	}
+	memcpy(&view.issued_at, payload, sizeof(view.issued_at));
+	const char *position = payload + sizeof(view.issued_at);
+	const char *const end = payload + header.size;
+	for (size_t i = 0; i < LEDGER_FIELDS; i++) {
+		if ((size_t)(end - position) < sizeof(uint32_t)) {
+			return 0;
+		}
+		memcpy(&view.sizes[i], position, sizeof(uint32_t));
+		position += sizeof(uint32_t);
+		if (view.sizes[i] > (size_t)(end - position)) {
+			return 0;
+		}
+		view.fields[i] = position;
+		position += view.sizes[i];
+	}
+	return position == end ? sizeof(header) + header.size : 0;
+}
+
+static void to_record(const RecordView &view, LedgerRecord &record) {
+	string *const fields[LEDGER_FIELDS] = {&record.output, &record.feature, &record.client_signature,
+										   &record.parameters, &record.signature};
+	record.issued_at = view.issued_at;
+	for (size_t i = 0; i < LEDGER_FIELDS; i++) {
+		fields[i]->assign(view.fields[i], view.sizes[i]);
+	}
+}
+
+/**
+ * Visit the valid records between begin and end. Damaged bytes are skipped up to the next record marker.
+ * @return the number of bytes skipped.
+ */
+template <typename Visitor>
+static uint64_t scan(const char *data, size_t begin, size_t end, Visitor visit) {
+	uint64_t damaged = 0;
+	RecordView view;
+	size_t position = begin;
+	while (position < end) {
+		const size_t size = read_record(data + position, end - position, view);
+		if (size > 0) {
+			visit(position, size, view);
+			position += size;
+			continue;
+		}
+		size_t next = position + 1;
+		while (next < end && (end - next < sizeof(RECORD_MARKER) ||
+							  memcmp(data + next, &RECORD_MARKER, sizeof(RECORD_MARKER)) != 0)) {
+			next++;
+		}
+		damaged += next - position;
+		position = next;
+	}
+	return damaged;
+}
+
+/**
+ * Generation of a ledger, 0 if the ledger is still empty.
+ */
+static uint64_t ledger_generation(const char *data, size_t size, const string &ledger_file) {
+	if (size < sizeof(LedgerHeader)) {
+		return 0;
+	}
+	LedgerHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, LEDGER_MAGIC, sizeof(LEDGER_MAGIC)) != 0) {
+		throw runtime_error("[" + ledger_file + "] is not a license ledger");
+	}
+	return header.generation;
+}
+
+/**
+ * Hash tables of the records, one for each key. The entries of each table are grouped by bucket: the entries of
+ * bucket b go from starts[b] to starts[b + 1]. Records with an empty key are not indexed.
+ */
+static string build_index(const char *ledger, size_t size, uint64_t generation) {
+	vector<LedgerIndexEntry> entries[INDEX_TABLES];
+	scan(ledger, sizeof(LedgerHeader), size, [&](size_t offset, size_t, const RecordView &view) {
+		for (size_t table = 0; table < INDEX_TABLES; table++) {
+			const size_t field = KEY_FIELDS[table];
+			if (view.sizes[field] > 0) {
+				const LedgerIndexEntry entry = {key_hash(view.fields[field], view.sizes[field]), offset};
+				entries[table].push_back(entry);
+			}
+		}
+	});
+	uint32_t bucket_count = 16;
+	for (const auto &table : entries) {
+		while (bucket_count < table.size() && bucket_count < (1u << 31)) {
+			bucket_count *= 2;
+		}
+	}
+	LedgerIndexHeader header;
+	memcpy(header.magic, LEDGER_INDEX_MAGIC, sizeof(LEDGER_INDEX_MAGIC));
+	header.version = LEDGER_INDEX_VERSION;
+	header.bucket_count = bucket_count;
+	header.generation = generation;
+	header.indexed_size = size;
+	for (size_t table = 0; table < INDEX_TABLES; table++) {
+		header.entries[table] = entries[table].size();
+	}
+	string index(reinterpret_cast<const char *>(&header), sizeof(header));
+	vector<uint64_t> starts;
+	vector<LedgerIndexEntry> grouped;
+	for (const auto &table : entries) {
+		starts.assign(bucket_count + 1, 0);
+		for (const LedgerIndexEntry &entry : table) {
+			starts[(entry.hash & (bucket_count - 1)) + 1]++;
+		}
+		for (size_t bucket = 0; bucket < bucket_count; bucket++) {
+			starts[bucket + 1] += starts[bucket];
+		}
+		// entries are in ledger order, and stay so in each bucket
+		vector<uint64_t> next(starts.begin(), starts.end() - 1);
+		grouped.resize(table.size());
+		for (const LedgerIndexEntry &entry : table) {
+			grouped[next[entry.hash & (bucket_count - 1)]++] = entry;
+		}
+		index.append(reinterpret_cast<const char *>(starts.data()), starts.size() * sizeof(uint64_t));
+		index.append(reinterpret_cast<const char *>(grouped.data()), grouped.size() * sizeof(LedgerIndexEntry));
+	}
+	return index;
+}
+
+namespace {
+/**
+ * The mapped index of a ledger. It is not usable if it doesn't exist or if it belongs to another generation of the
+ * ledger.
+ */
+class LedgerIndexView {
+private:
+	unique_ptr<MappedFile> m_file;
+	LedgerIndexHeader m_header;
+	const uint64_t *m_starts[INDEX_TABLES];
+	const LedgerIndexEntry *m_entries[INDEX_TABLES];
+	bool m_usable;
+
+public:
+	LedgerIndexView(const string &index_file, uint64_t generation, size_t ledger_size) : m_usable(false) {
+		if (!fs::exists(index_file)) {
+			return;
+		}
+		m_file.reset(new MappedFile(index_file));
+		if (m_file->size() < sizeof(m_header)) {
+			throw runtime_error("[" + index_file + "] is not a ledger index");
+		}
+		memcpy(&m_header, m_file->data(), sizeof(m_header));
+		if (memcmp(m_header.magic, LEDGER_INDEX_MAGIC, sizeof(LEDGER_INDEX_MAGIC)) != 0 ||
+			m_header.version != LEDGER_INDEX_VERSION) {
+			throw runtime_error("[" + index_file + "] is not a ledger index");
+		}
+		if (m_header.generation != generation || m_header.indexed_size > ledger_size) {
+			return;
+		}
+		uint64_t expected_size = sizeof(m_header);
+		for (size_t table = 0; table < INDEX_TABLES; table++) {
+			expected_size += (m_header.bucket_count + 1ull) * sizeof(uint64_t) +
+							 m_header.entries[table] * sizeof(LedgerIndexEntry);
+		}
+		if (m_header.bucket_count == 0 || (m_header.bucket_count & (m_header.bucket_count - 1)) != 0 ||
+			expected_size != m_file->size()) {
+			throw runtime_error("[" + index_file + "] is a damaged ledger index");
+		}
+		const char *position = m_file->data() + sizeof(m_header);
+		for (size_t table = 0; table < INDEX_TABLES; table++) {
+			m_starts[table] = reinterpret_cast<const uint64_t *>(position);
+			position += (m_header.bucket_count + 1ull) * sizeof(uint64_t);
+			m_entries[table] = reinterpret_cast<const LedgerIndexEntry *>(position);
+			position += m_header.entries[table] * sizeof(LedgerIndexEntry);
+		}
+		m_usable = true;
+	}
+	inline bool usable() const { return m_usable; }
+	inline uint64_t indexed_size() const { return m_header.indexed_size; }
+	// offsets of the records whose key has the given hash, in ledger order
+	template <typename Visitor>
+	void lookup(size_t table, uint64_t hash, Visitor visit) const {
+		const uint64_t bucket = hash & (m_header.bucket_count - 1);
+		const uint64_t end = min(m_starts[table][bucket + 1], m_header.entries[table]);
+		for (uint64_t i = m_starts[table][bucket]; i < end; i++) {
+			if (m_entries[table][i].hash == hash) {
+				visit(m_entries[table][i].offset);
+			}
+		}
+	}
+};
+}  // namespace
+
+LicenseLedger::LicenseLedger(const std::string &project_folder)
+	: m_project_folder(project_folder), m_pending_count(0) {}
+
+const std::string LicenseLedger::file(const char *name) const { return (fs::path(m_project_folder) / name).string(); }
+
+void LicenseLedger::add(const LedgerRecord &record) {
+	lock_guard<mutex> guard(m_mutex);
+	append_record(m_pending, record);
+	if (++m_pending_count >= MAX_PENDING) {
+		flush_locked();
+	}
+}
+
+void LicenseLedger::flush() {
+	lock_guard<mutex> guard(m_mutex);
+	flush_locked();
+}
+
+static void write_index(const string &ledger_file, const string &index_file) {
+	string index;
+	{
+		const MappedFile ledger(ledger_file);
+		index = build_index(ledger.data(), ledger.size(), ledger_generation(ledger.data(), ledger.size(), ledger_file));
+	}
+	AtomicFileWriter().write(index_file, index);
+}
+
+// false if the file doesn't exist or is shorter than the header
+template <typename Header>
+static bool read_header(const string &fname, Header &header) {
+	ifstream file(fname, ios::binary);
+	return file.read(reinterpret_cast<char *>(&header), sizeof(header)).good();
+}
+
+void LicenseLedger::flush_locked() {
+	if (m_pending.empty()) {
+		return;
+	}
+	const string ledger_file = file(LICENSE_LEDGER_FNAME);
+	const string index_file = file(LICENSE_LEDGER_INDEX_FNAME);
+	const FileLock lock(file(LICENSE_LEDGER_LOCK_FNAME));
+	LedgerHeader ledger_header;
+	string created;
+	if (!read_header(ledger_file, ledger_header)) {
+		// a new ledger, or one whose creation was interrupted
+		if (fs::exists(ledger_file)) {
+			fs::remove(ledger_file);
+		}
+		memcpy(ledger_header.magic, LEDGER_MAGIC, sizeof(LEDGER_MAGIC));
+		ledger_header.generation = new_generation();
+		created.assign(reinterpret_cast<const char *>(&ledger_header), sizeof(ledger_header));
+	}
+	const int fd = open_append(ledger_file);
+	if (fd < 0) {
+		throw runtime_error("Can not open the license ledger [" + ledger_file + "]: " + strerror(errno));
+	}
+	const Segment segments[] = {{created.data(), created.size()}, {m_pending.data(), m_pending.size()}};
+	try {
+		FdSink(fd).write(&ledger_file, segments, sizeof(segments) / sizeof(segments[0]));
+	} catch (const exception &) {
+		close_fd(fd);
+		throw;
+	}
+	close_fd(fd);
+	m_pending.clear();
+	m_pending_count = 0;
+	const uint64_t ledger_size = fs::file_size(ledger_file);
+	LedgerIndexHeader index_header;
+	const uint64_t indexed_size =
+		read_header(index_file, index_header) && index_header.generation == ledger_header.generation
+			? min(index_header.indexed_size, ledger_size)
+			: 0;
+	if (ledger_size - indexed_size > max(MIN_REINDEX_SIZE, ledger_size / REINDEX_FRACTION)) {
+		write_index(ledger_file, index_file);
+	}
+}
+
+size_t LicenseLedger::find(LedgerKey key, const std::string &value,
+						   const std::function<void(const LedgerRecord &)> &found) {
+	if (value.empty()) {
+		throw invalid_argument("the ledger can't be searched for an empty value");
+	}
+	flush();
+	const string ledger_file = file(LICENSE_LEDGER_FNAME);
+	if (!fs::exists(ledger_file)) {
+		return 0;
+	}
+	const MappedFile ledger(ledger_file);
+	const uint64_t generation = ledger_generation(ledger.data(), ledger.size(), ledger_file);
+	if (generation == 0) {
+		return 0;
+	}
+	const size_t table = static_cast<size_t>(key);
+	const size_t field = KEY_FIELDS[table];
+	size_t count = 0;
+	LedgerRecord record;
+	const auto report = [&](const RecordView &view) {
+		if (view.sizes[field] == value.size() && memcmp(view.fields[field], value.data(), value.size()) == 0) {
+			to_record(view, record);
+			found(record);
+			count++;
+		}
+	};
+	const LedgerIndexView index(file(LICENSE_LEDGER_INDEX_FNAME), generation, ledger.size());
+	size_t scan_from = sizeof(LedgerHeader);
+	if (index.usable()) {
+		RecordView view;
+		index.lookup(table, key_hash(value.data(), value.size()), [&](uint64_t offset) {
+			if (offset >= sizeof(LedgerHeader) && offset < index.indexed_size() &&
+				read_record(ledger.data() + offset, ledger.size() - offset, view) > 0) {
+				report(view);
+			}
+		});
+		scan_from = (size_t)index.indexed_size();
+	}
+	scan(ledger.data(), scan_from, ledger.size(), [&](size_t, size_t, const RecordView &view) { report(view); });
+	return count;
+}
+
+LedgerCompaction LicenseLedger::compact(bool drop_superseded) {
+	lock_guard<mutex> guard(m_mutex);
+	flush_locked();
+	LedgerCompaction result = {0, 0, 0};
+	const string ledger_file = file(LICENSE_LEDGER_FNAME);
+	if (!fs::exists(ledger_file)) {
+		return result;
+	}
+	const FileLock lock(file(LICENSE_LEDGER_LOCK_FNAME));
+	LedgerHeader header;
+	memcpy(header.magic, LEDGER_MAGIC, sizeof(LEDGER_MAGIC));
+	header.generation = new_generation();
+	string compacted(reinterpret_cast<const char *>(&header), sizeof(header));
+	{
+		const MappedFile ledger(ledger_file);
+		if (ledger_generation(ledger.data(), ledger.size(), ledger_file) == 0) {
+			result.damaged_bytes = ledger.size();
+		} else {
+			struct Kept {
+				size_t offset;
+				size_t size;
+				RecordView view;
+			};
+			vector<Kept> records;
+			result.damaged_bytes = scan(ledger.data(), sizeof(LedgerHeader), ledger.size(),
+										[&](size_t offset, size_t size, const RecordView &view) {
+											const Kept kept = {offset, size, view};
+											records.push_back(kept);
+										});
+			vector<bool> keep(records.size(), true);
+			if (drop_superseded) {
+				// licenses printed on the standard output have no name, each one is kept
+				unordered_set<string> issued;
+				for (size_t i = records.size(); i-- > 0;) {
+					const RecordView &view = records[i].view;
+					const string section = string(view.fields[0], view.sizes[0]) + '\n' +
+										   string(view.fields[1], view.sizes[1]);
+					if (view.sizes[0] > 0 && !issued.insert(section).second) {
+						keep[i] = false;
+						result.superseded++;
+					}
+				}
+			}
+			for (size_t i = 0; i < records.size(); i++) {
+				if (keep[i]) {
+					compacted.append(ledger.data() + records[i].offset, records[i].size);
+					result.records++;
+				}
+			}
+		}
+	}
+	AtomicFileWriter file_writer;
+	file_writer.write(ledger_file, compacted.data(), compacted.size());
+	const string index = build_index(compacted.data(), compacted.size(), header.generation);
+	file_writer.write(file(LICENSE_LEDGER_INDEX_FNAME), index.data(), index.size());
+	return result;
+}
+
+LicenseLedger::~LicenseLedger() {
+	try {
+		flush();
+	} catch (const exception &e) {
+		cerr << "Error updating the license ledger: " << e.what() << endl;
+	}
+}
+
+} /* namespace license */
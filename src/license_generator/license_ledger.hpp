@@ -0,0 +1,106 @@
+/*
+ * license_ledger.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_LICENSE_LEDGER_HPP_
+#define SRC_LICENSE_GENERATOR_LICENSE_LEDGER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace license {
+
+/**
+ * Record of every section issued for a project, in the project folder.
+ */
+#define LICENSE_LEDGER_FNAME ".lcc_ledger"
+/**
+ * Hash index of the ledger.
+ */
+#define LICENSE_LEDGER_INDEX_FNAME ".lcc_ledger.idx"
+/**
+ * Locked by the processes writing the ledger. It is never replaced, so it can be locked across compactions.
+ */
+#define LICENSE_LEDGER_LOCK_FNAME ".lcc_ledger.lock"
+
+/**
+ * A section issued.
+ */
+struct LedgerRecord {
+	// seconds since the epoch
+	uint64_t issued_at;
+	// license file as given to lccgen, empty if the license was printed on the standard output
+	std::string output;
+	std::string feature;
+	std::string client_signature;
+	// the signed values of the section, one key=value per line
+	std::string parameters;
+	std::string signature;
+};
+
+enum class LedgerKey { OUTPUT, CLIENT_SIGNATURE };
+
+struct LedgerCompaction {
+	size_t records;
+	// records dropped because the same section of the same license was issued again later
+	size_t superseded;
+	// bytes of incomplete or corrupted records dropped
+	uint64_t damaged_bytes;
+};
+
+/**
+ * Append only ledger of the sections issued for a project, updated by License::write_license.
+ *
+ * <p>Each record is checksummed (CRC-32). A record torn by a crash or damaged on disk is skipped: readers resume from
+ * the next valid record. Records are appended with a single write, holding an exclusive lock on
+ * LICENSE_LEDGER_LOCK_FNAME, so that several processes can issue licenses for the same project at the same time.
+ * Readers don't lock.</p>
+ *
+ * <p>LICENSE_LEDGER_INDEX_FNAME is a hash index of the ledger by license file and by client signature. It is memory
+ * mapped and covers the ledger up to a given size: lookups read the index buckets, then scan the records appended
+ * after it. The index is rebuilt when the records it doesn't cover grow past a fraction of the ledger. Each ledger
+ * has a random generation number, stored in its index as well: an index left behind by a compaction is ignored.</p>
+ *
+ * <p>Additions are buffered in memory and written by flush() (or by the destructor).</p>
+ */
+class LicenseLedger {
+private:
+	const std::string m_project_folder;
+	std::mutex m_mutex;
+	// records waiting to be written
+	std::string m_pending;
+	size_t m_pending_count;
+	void flush_locked();
+	const std::string file(const char *name) const;
+
+public:
+	// additions kept in memory at most, before they are written
+	static const size_t MAX_PENDING = 4096;
+	explicit LicenseLedger(const std::string &project_folder);
+	LicenseLedger(const LicenseLedger &) = delete;
+	LicenseLedger &operator=(const LicenseLedger &) = delete;
+	void add(const LedgerRecord &record);
+	void flush();
+	/**
+	 * Find the records of a license file or of a client signature, oldest first.
+	 * @return the number of records found.
+	 * @throws runtime_error if the ledger or its index are not valid.
+	 */
+	size_t find(LedgerKey key, const std::string &value, const std::function<void(const LedgerRecord &)> &found);
+	/**
+	 * Rewrite the ledger without the damaged records and rebuild its index.
+	 * @param drop_superseded
+	 * 			keep only the last record of each section of each license file.
+	 */
+	LedgerCompaction compact(bool drop_superseded);
+	virtual ~LicenseLedger();
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_LICENSE_LEDGER_HPP_ */
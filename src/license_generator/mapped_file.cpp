@@ -0,0 +1,215 @@
+/*
+ * mapped_file.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "atomic_file.hpp"
+#include "mapped_file.hpp"
+#include "output_sink.hpp"
+
+namespace license {
+using namespace std;
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &file_name)
+	: m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {
+	m_file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+						 FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		throw runtime_error("Can not open file [" + file_name + "]");
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size)) {
+		CloseHandle(m_file);
+		throw runtime_error("Can not read the size of [" + file_name + "]");
+	}
+	m_size = (size_t)size.QuadPart;
+	if (m_size == 0) {
+		return;
+	}
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr) {
+		m_data = (const char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (m_data == nullptr) {
+		if (m_mapping != nullptr) CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		throw runtime_error("Can not map file [" + file_name + "]");
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (m_data != nullptr) UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr) CloseHandle(m_mapping);
+	CloseHandle(m_file);
+}
+#else
+MappedFile::MappedFile(const std::string &file_name) : m_data(nullptr), m_size(0) {
+	const int fd = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw runtime_error("Can not open file [" + file_name + "]: " + strerror(errno));
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0) {
+		const string error(strerror(errno));
+		close(fd);
+		throw runtime_error("Can not read the size of [" + file_name + "]: " + error);
+	}
+	m_size = (size_t)file_stat.st_size;
+	if (m_size > 0) {
+		void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			const string error(strerror(errno));
+			close(fd);
+			throw runtime_error("Can not map file [" + file_name + "]: " + error);
+		}
+		m_data = (const char *)data;
+	}
+	// the mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (m_data != nullptr) munmap((void *)m_data, m_size);
+}
+#endif
+
+struct SortedTableHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+	uint64_t strings_size;
+	uint64_t data_size;
+};
+
+static_assert(sizeof(SortedTableHeader) == 32, "sorted table header layout");
+
+const size_t SortedTable::NOT_FOUND;
+
+SortedTable::SortedTable(const std::string &file_name, const char *magic, uint32_t version, size_t record_size,
+						 const std::string &kind, const std::function<bool(const SortedTable &, size_t)> &valid_record)
+	: m_file(file_name), m_record_size(record_size) {
+	SortedTableHeader header;
+	if (m_file.size() < sizeof(header)) {
+		throw runtime_error("[" + file_name + "] is not a " + kind);
+	}
+	memcpy(&header, m_file.data(), sizeof(header));
+	if (memcmp(header.magic, magic, sizeof(header.magic)) != 0) {
+		throw runtime_error("[" + file_name + "] is not a " + kind);
+	}
+	if (header.version != version) {
+		throw runtime_error("[" + file_name + "]: " + kind + " version " + to_string(header.version) +
+							" not supported");
+	}
+	m_count = header.count;
+	const uint64_t tables_size = (uint64_t)m_count * (record_size + sizeof(uint32_t));
+	// sizes are checked one at a time: their sum could overflow
+	uint64_t remaining = m_file.size() - sizeof(header);
+	if (tables_size > remaining || header.strings_size > remaining - tables_size ||
+		header.data_size != remaining - tables_size - header.strings_size) {
+		throw runtime_error("[" + file_name + "] is a truncated or corrupted " + kind);
+	}
+	m_records = m_file.data() + sizeof(header);
+	m_index = reinterpret_cast<const uint32_t *>(m_records + m_count * record_size);
+	m_strings = reinterpret_cast<const char *>(m_index + m_count);
+	m_strings_size = (size_t)header.strings_size;
+	m_data = m_strings + m_strings_size;
+	m_data_size = (size_t)header.data_size;
+	for (size_t i = 0; i < m_count; i++) {
+		if (m_index[i] >= m_count || !valid_record(*this, i)) {
+			throw runtime_error("[" + file_name + "] is a corrupted " + kind);
+		}
+	}
+}
+
+bool SortedTable::has_string(uint32_t offset, uint32_t size) const {
+	return (uint64_t)offset + size <= m_strings_size;
+}
+
+bool SortedTable::has_data(uint64_t offset, uint64_t size) const {
+	return offset <= m_data_size && size <= m_data_size - offset;
+}
+
+int SortedTable::compare_string(uint32_t offset, uint32_t size, const std::string &value) const {
+	const int result = memcmp(m_strings + offset, value.data(), min((size_t)size, value.size()));
+	if (result != 0) {
+		return result;
+	}
+	return size < value.size() ? -1 : (size > value.size() ? 1 : 0);
+}
+
+size_t SortedTable::lower_bound(const std::function<int(size_t)> &compare) const {
+	size_t low = 0, high = m_count;
+	while (low < high) {
+		const size_t middle = low + (high - low) / 2;
+		if (compare(middle) < 0) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+size_t SortedTable::find(const std::function<int(size_t)> &compare) const {
+	const size_t position = lower_bound(compare);
+	return position < m_count && compare(position) == 0 ? position : NOT_FOUND;
+}
+
+SortedTableWriter::SortedTableWriter(const char *magic, uint32_t version, const std::string &kind)
+	: m_magic(magic), m_version(version), m_kind(kind) {}
+
+uint32_t SortedTableWriter::add_string(const std::string &value) {
+	const size_t offset = m_strings.size();
+	if (value.size() > UINT32_MAX - offset) {
+		throw logic_error("strings too long for a " + m_kind);
+	}
+	m_strings.append(value);
+	return (uint32_t)offset;
+}
+
+std::vector<uint32_t> SortedTableWriter::sorted_index(size_t count,
+													  const std::function<bool(uint32_t, uint32_t)> &less) const {
+	if (count > UINT32_MAX) {
+		throw logic_error("too many records for a " + m_kind);
+	}
+	vector<uint32_t> index(count);
+	for (size_t i = 0; i < count; i++) {
+		index[i] = (uint32_t)i;
+	}
+	stable_sort(index.begin(), index.end(), less);
+	return index;
+}
+
+void SortedTableWriter::write(const std::string &file_name, const void *records, size_t record_size, size_t count,
+							  const std::vector<uint32_t> &index, const std::string &data) const {
+	SortedTableHeader header;
+	memcpy(header.magic, m_magic, sizeof(header.magic));
+	header.version = m_version;
+	header.count = (uint32_t)count;
+	header.strings_size = m_strings.size();
+	header.data_size = data.size();
+	const Segment segments[] = {{reinterpret_cast<const char *>(&header), sizeof(header)},
+								{reinterpret_cast<const char *>(records), count * record_size},
+								{reinterpret_cast<const char *>(index.data()), index.size() * sizeof(uint32_t)},
+								{m_strings.data(), m_strings.size()},
+								{data.data(), data.size()}};
+	AtomicFileWriter().write(file_name, segments, sizeof(segments) / sizeof(segments[0]));
+}
+
+} /* namespace license */
@@ -0,0 +1,135 @@
+/*
+ * mapped_file.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_MAPPED_FILE_HPP_
+#define SRC_LICENSE_GENERATOR_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace license {
+
+/**
+ * A file mapped read only in memory. Pages are loaded by the operating system on access, so large files can be
+ * scanned without reading them in a buffer first.
+ */
+class MappedFile {
+private:
+	const char *m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void *m_file;
+	void *m_mapping;
+#endif
+
+public:
+	/**
+	 * @throws runtime_error if the file can't be opened or mapped.
+	 */
+	explicit MappedFile(const std::string &file_name);
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	// nullptr for empty files
+	inline const char *data() const { return m_data; }
+	inline size_t size() const { return m_size; }
+	virtual ~MappedFile();
+};
+
+/**
+ * A file of fixed size records sorted by a key, mapped in memory. License bundles and keystores are sorted tables.
+ *
+ * <p>A 32 byte header (magic, version, number of records, sizes of the string heap and of the data section) is
+ * followed by the records, by an index of the record numbers sorted by a second key (uint32_t each), by the string
+ * heap and by the data section. Records refer to strings and data by offset and size.</p>
+ */
+class SortedTable {
+private:
+	const MappedFile m_file;
+	size_t m_count;
+	const char *m_records;
+	size_t m_record_size;
+	const uint32_t *m_index;
+	const char *m_strings;
+	size_t m_strings_size;
+	const char *m_data;
+	size_t m_data_size;
+
+public:
+	static const size_t NOT_FOUND = (size_t)-1;
+	/**
+	 * @param magic
+	 * 			the 8 bytes the file starts with.
+	 * @param kind
+	 * 			name of the format, in the error messages (eg. "keystore").
+	 * @param valid_record
+	 * 			checks the strings and the data a record refers to, with has_string() and has_data().
+	 * @throws runtime_error if the file can't be mapped, is not of this format or version, or is corrupted.
+	 */
+	SortedTable(const std::string &file_name, const char *magic, uint32_t version, size_t record_size,
+				const std::string &kind, const std::function<bool(const SortedTable &, size_t)> &valid_record);
+	SortedTable(const SortedTable &) = delete;
+	SortedTable &operator=(const SortedTable &) = delete;
+	inline size_t size() const { return m_count; }
+	inline const void *record(size_t index) const { return m_records + index * m_record_size; }
+	// number of the record at a position of the index
+	inline uint32_t indexed(size_t position) const { return m_index[position]; }
+	inline const char *strings() const { return m_strings; }
+	inline const char *data() const { return m_data; }
+	bool has_string(uint32_t offset, uint32_t size) const;
+	bool has_data(uint64_t offset, uint64_t size) const;
+	// compares a string of the heap with value, as memcmp
+	int compare_string(uint32_t offset, uint32_t size, const std::string &value) const;
+	/**
+	 * Binary search on the records, or on the index.
+	 * @param compare
+	 * 			compare(position) is negative if the item at that position comes before the one searched, zero if it
+	 * 			is the one searched, positive if it comes after.
+	 * @return the first position that doesn't come before the item searched.
+	 */
+	size_t lower_bound(const std::function<int(size_t)> &compare) const;
+	/**
+	 * @return the position of the item searched, NOT_FOUND if it isn't in the table.
+	 */
+	size_t find(const std::function<int(size_t)> &compare) const;
+};
+
+/**
+ * Writes a SortedTable file atomically.
+ */
+class SortedTableWriter {
+private:
+	const char *m_magic;
+	const uint32_t m_version;
+	const std::string m_kind;
+	std::string m_strings;
+
+public:
+	SortedTableWriter(const char *magic, uint32_t version, const std::string &kind);
+	/**
+	 * Add a string to the heap.
+	 * @return its offset.
+	 * @throws logic_error if the heap doesn't fit 32 bit offsets.
+	 */
+	uint32_t add_string(const std::string &value);
+	/**
+	 * Record numbers sorted by less. The sort is stable: records with the same key stay in table order.
+	 * @throws logic_error if there are too many records.
+	 */
+	std::vector<uint32_t> sorted_index(size_t count, const std::function<bool(uint32_t, uint32_t)> &less) const;
+	/**
+	 * @param records
+	 * 			count records of record_size bytes, sorted by the key of the table.
+	 */
+	void write(const std::string &file_name, const void *records, size_t record_size, size_t count,
+			   const std::vector<uint32_t> &index, const std::string &data) const;
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_MAPPED_FILE_HPP_ */
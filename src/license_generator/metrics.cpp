@@ -0,0 +1,289 @@
+/*
+ * metrics.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+#include "atomic_file.hpp"
+#include "metrics.hpp"
+
+namespace license {
+using namespace std;
+
+struct MetricInfo {
+	// OpenMetrics family name, without the lccgen_ prefix
+	const char *name;
+	const char *help;
+};
+
+static const MetricInfo COUNTERS[] = {
+	{"licenses", "Licenses written."},
+	{"license_bytes", "Bytes of the licenses written."},
+	{"sections_signed", "License sections signed."},
+	{"signatures_verified", "Signatures of unchanged license sections verified instead of signing them again."},
+	{"file_commits", "Commits of the atomic file writers."},
+	{"files_committed", "Files made durable by the commits."},
+	{"key_cache_hits", "Private keys found already loaded."},
+	{"key_cache_misses", "Private keys loaded from file."}};
+static const MetricInfo GAUGES[] = {
+	{"pending_commit_files", "Files written and waiting for their commit."},
+	{"pending_index_records", "Licenses waiting to be written in the license index."}};
+static const MetricInfo HISTOGRAMS[] = {
+	{"license_latency_seconds", "Time to issue and write a license."},
+	{"signature_latency_seconds", "Time to sign a license section."},
+	{"commit_latency_seconds", "Time to commit a group of files."}};
+
+static_assert(sizeof(COUNTERS) / sizeof(COUNTERS[0]) == (size_t)Counter::COUNTER_COUNT, "a name for every counter");
+static_assert(sizeof(GAUGES) / sizeof(GAUGES[0]) == (size_t)Gauge::GAUGE_COUNT, "a name for every gauge");
+static_assert(sizeof(HISTOGRAMS) / sizeof(HISTOGRAMS[0]) == (size_t)Histogram::HISTOGRAM_COUNT,
+			  "a name for every histogram");
+
+const unsigned HistogramSnapshot::SUB_BUCKET_BITS;
+const size_t HistogramSnapshot::BUCKETS;
+
+static const size_t COUNTER_COUNT = (size_t)Counter::COUNTER_COUNT;
+static const size_t GAUGE_COUNT = (size_t)Gauge::GAUGE_COUNT;
+static const size_t HISTOGRAM_COUNT = (size_t)Histogram::HISTOGRAM_COUNT;
+
+namespace {
+/**
+ * Metrics of a thread. Only the owner thread writes them, so increments don't need atomic read-modify-write
+ * operations: atomics are there only for the readers.
+ */
+struct ThreadMetrics {
+	atomic<uint64_t> counters[COUNTER_COUNT];
+	// gauges are sums of the deltas of all the threads
+	atomic<int64_t> gauges[GAUGE_COUNT];
+	atomic<uint64_t> histogram_sums[HISTOGRAM_COUNT];
+	atomic<uint64_t> histogram_buckets[HISTOGRAM_COUNT][HistogramSnapshot::BUCKETS];
+
+	ThreadMetrics() {
+		for (auto &counter : counters) counter.store(0, memory_order_relaxed);
+		for (auto &gauge : gauges) gauge.store(0, memory_order_relaxed);
+		for (auto &sum : histogram_sums) sum.store(0, memory_order_relaxed);
+		for (auto &histogram : histogram_buckets) {
+			for (auto &bucket : histogram) bucket.store(0, memory_order_relaxed);
+		}
+	}
+};
+
+template <typename T>
+inline void increment(atomic<T> &value, T amount) {
+	value.store(value.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+struct Registry {
+	const chrono::steady_clock::time_point start;
+	mutex threads_mutex;
+	// never released: the metrics of terminated threads still count
+	vector<unique_ptr<ThreadMetrics>> threads;
+	Registry() : start(chrono::steady_clock::now()) {}
+};
+}  // namespace
+
+static Registry &registry() {
+	static Registry instance;
+	return instance;
+}
+
+static ThreadMetrics &thread_metrics() {
+	static thread_local ThreadMetrics *metrics = nullptr;
+	if (metrics == nullptr) {
+		Registry &reg = registry();
+		unique_ptr<ThreadMetrics> created(new ThreadMetrics());
+		metrics = created.get();
+		lock_guard<mutex> guard(reg.threads_mutex);
+		reg.threads.push_back(move(created));
+	}
+	return *metrics;
+}
+
+static inline unsigned highest_bit(uint64_t value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (unsigned)index;
+#else
+	return 63u - (unsigned)__builtin_clzll(value);
+#endif
+}
+
+size_t HistogramSnapshot::bucket(uint64_t value_ns) {
+	if (value_ns < (1u << SUB_BUCKET_BITS)) {
+		return (size_t)value_ns;
+	}
+	const unsigned shift = highest_bit(value_ns) - SUB_BUCKET_BITS;
+	return ((size_t)(shift + 1) << SUB_BUCKET_BITS) | (size_t)((value_ns >> shift) & ((1u << SUB_BUCKET_BITS) - 1));
+}
+
+uint64_t HistogramSnapshot::bucket_lower_bound(size_t bucket) {
+	if (bucket < (1u << SUB_BUCKET_BITS)) {
+		return bucket;
+	}
+	const unsigned shift = (unsigned)(bucket >> SUB_BUCKET_BITS) - 1;
+	return ((uint64_t)(1u << SUB_BUCKET_BITS) | (bucket & ((1u << SUB_BUCKET_BITS) - 1))) << shift;
+}
+
+uint64_t HistogramSnapshot::quantile(double q) const {
+	if (count == 0) {
+		return 0;
+	}
+	uint64_t rank = (uint64_t)(q * count + 0.999999);
+	rank = rank == 0 ? 1 : min(rank, count);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKETS; i++) {
+		seen += buckets[i];
+		if (seen >= rank) {
+			const uint64_t lower = bucket_lower_bound(i);
+			const uint64_t width = i + 1 < BUCKETS ? bucket_lower_bound(i + 1) - lower : lower;
+			return lower + width / 2;
+		}
+	}
+	return bucket_lower_bound(BUCKETS - 1);
+}
+
+void Metrics::add(Counter counter, uint64_t amount) {
+	increment(thread_metrics().counters[(size_t)counter], amount);
+}
+
+void Metrics::add(Gauge gauge, int64_t delta) { increment(thread_metrics().gauges[(size_t)gauge], delta); }
+
+void Metrics::observe(Histogram histogram, uint64_t duration_ns) {
+	ThreadMetrics &metrics = thread_metrics();
+	increment(metrics.histogram_sums[(size_t)histogram], duration_ns);
+	increment(metrics.histogram_buckets[(size_t)histogram][HistogramSnapshot::bucket(duration_ns)], (uint64_t)1);
+}
+
+MetricsSnapshot Metrics::snapshot() {
+	Registry &reg = registry();
+	MetricsSnapshot snapshot;
+	snapshot.uptime_s = chrono::duration<double>(chrono::steady_clock::now() - reg.start).count();
+	for (auto &counter : snapshot.counters) counter = 0;
+	for (auto &gauge : snapshot.gauges) gauge = 0;
+	lock_guard<mutex> guard(reg.threads_mutex);
+	for (const auto &thread : reg.threads) {
+		for (size_t i = 0; i < COUNTER_COUNT; i++) {
+			snapshot.counters[i] += thread->counters[i].load(memory_order_relaxed);
+		}
+		for (size_t i = 0; i < GAUGE_COUNT; i++) {
+			snapshot.gauges[i] += thread->gauges[i].load(memory_order_relaxed);
+		}
+		for (size_t i = 0; i < HISTOGRAM_COUNT; i++) {
+			HistogramSnapshot &histogram = snapshot.histograms[i];
+			histogram.sum_ns += thread->histogram_sums[i].load(memory_order_relaxed);
+			for (size_t b = 0; b < HistogramSnapshot::BUCKETS; b++) {
+				const uint64_t observed = thread->histogram_buckets[i][b].load(memory_order_relaxed);
+				histogram.buckets[b] += observed;
+				histogram.count += observed;
+			}
+		}
+	}
+	return snapshot;
+}
+
+MetricsSnapshot MetricsSnapshot::since(const MetricsSnapshot &earlier) const {
+	MetricsSnapshot delta(*this);
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		delta.counters[i] -= earlier.counters[i];
+	}
+	for (size_t i = 0; i < HISTOGRAM_COUNT; i++) {
+		delta.histograms[i].count -= earlier.histograms[i].count;
+		delta.histograms[i].sum_ns -= earlier.histograms[i].sum_ns;
+		for (size_t b = 0; b < HistogramSnapshot::BUCKETS; b++) {
+			delta.histograms[i].buckets[b] -= earlier.histograms[i].buckets[b];
+		}
+	}
+	return delta;
+}
+
+static void write_family(ostream &os, const string &name, const char *type, const char *help) {
+	os << "# TYPE lccgen_" << name << " " << type << "\n# HELP lccgen_" << name << " " << help << "\n";
+}
+
+void MetricsSnapshot::write_openmetrics(std::ostream &os, const MetricsSnapshot *previous) const {
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		write_family(os, COUNTERS[i].name, "counter", COUNTERS[i].help);
+		os << "lccgen_" << COUNTERS[i].name << "_total " << counters[i] << "\n";
+	}
+	for (size_t i = 0; i < GAUGE_COUNT; i++) {
+		write_family(os, GAUGES[i].name, "gauge", GAUGES[i].help);
+		os << "lccgen_" << GAUGES[i].name << " " << gauges[i] << "\n";
+	}
+	const uint64_t key_lookups = (*this)[Counter::KEY_CACHE_HITS] + (*this)[Counter::KEY_CACHE_MISSES];
+	write_family(os, "key_cache_hit_ratio", "gauge", "Private keys found already loaded, over all the lookups.");
+	os << "lccgen_key_cache_hit_ratio "
+	   << (key_lookups == 0 ? 0.0 : (double)(*this)[Counter::KEY_CACHE_HITS] / key_lookups) << "\n";
+	if (previous != nullptr && uptime_s > previous->uptime_s) {
+		const double elapsed = uptime_s - previous->uptime_s;
+		write_family(os, "licenses_per_second", "gauge", "Licenses written per second, since the last snapshot.");
+		os << "lccgen_licenses_per_second "
+		   << ((*this)[Counter::LICENSES_ISSUED] - (*previous)[Counter::LICENSES_ISSUED]) / elapsed << "\n";
+		write_family(os, "signatures_per_second", "gauge", "Sections signed per second, since the last snapshot.");
+		os << "lccgen_signatures_per_second "
+		   << ((*this)[Counter::SECTIONS_SIGNED] - (*previous)[Counter::SECTIONS_SIGNED]) / elapsed << "\n";
+	}
+	static const char *const QUANTILES[] = {"0.5", "0.99", "0.999"};
+	for (size_t i = 0; i < HISTOGRAM_COUNT; i++) {
+		const HistogramSnapshot &histogram = histograms[i];
+		write_family(os, HISTOGRAMS[i].name, "summary", HISTOGRAMS[i].help);
+		for (const char *quantile : QUANTILES) {
+			os << "lccgen_" << HISTOGRAMS[i].name << "{quantile=\"" << quantile << "\"} "
+			   << histogram.quantile(stod(quantile)) / 1e9 << "\n";
+		}
+		os << "lccgen_" << HISTOGRAMS[i].name << "_sum " << histogram.sum_ns / 1e9 << "\n";
+		os << "lccgen_" << HISTOGRAMS[i].name << "_count " << histogram.count << "\n";
+	}
+	write_family(os, "uptime_seconds", "gauge", "Seconds since the metrics started.");
+	os << "lccgen_uptime_seconds " << uptime_s << "\n# EOF\n";
+}
+
+MetricsReporter::MetricsReporter(const std::string &file_name, std::chrono::milliseconds interval)
+	: m_file_name(file_name), m_interval(interval), m_stopping(false), m_previous(Metrics::snapshot()) {
+	m_thread = thread(&MetricsReporter::run, this);
+}
+
+void MetricsReporter::run() {
+	unique_lock<mutex> lock(m_mutex);
+	while (!m_stopping) {
+		if (m_stop_requested.wait_for(lock, m_interval, [this]() { return m_stopping; })) {
+			break;
+		}
+		lock.unlock();
+		try {
+			write_snapshot();
+		} catch (const exception &e) {
+			cerr << "Error writing metrics: " << e.what() << endl;
+		}
+		lock.lock();
+	}
+}
+
+void MetricsReporter::write_snapshot() {
+	lock_guard<mutex> guard(m_write_mutex);
+	const MetricsSnapshot snapshot = Metrics::snapshot();
+	stringstream content;
+	snapshot.write_openmetrics(content, &m_previous);
+	AtomicFileWriter file_writer;
+	file_writer.write(m_file_name, content.str());
+	m_previous = snapshot;
+}
+
+MetricsReporter::~MetricsReporter() {
+	{
+		lock_guard<mutex> guard(m_mutex);
+		m_stopping = true;
+	}
+	m_stop_requested.notify_all();
+	m_thread.join();
+	try {
+		write_snapshot();
+	} catch (const exception &e) {
+		cerr << "Error writing metrics: " << e.what() << endl;
+	}
+}
+
+} /* namespace license */
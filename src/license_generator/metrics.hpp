@@ -0,0 +1,163 @@
+/*
+ * metrics.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_METRICS_HPP_
+#define SRC_LICENSE_GENERATOR_METRICS_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace license {
+
+enum class Counter {
+	// licenses written (to a file, a sink or the standard output)
+	LICENSES_ISSUED,
+	// license bytes written
+	LICENSE_BYTES,
+	SECTIONS_SIGNED,
+	// signatures of unchanged sections verified instead of signing them again
+	SIGNATURES_VERIFIED,
+	FILE_COMMITS,
+	FILES_COMMITTED,
+	KEY_CACHE_HITS,
+	KEY_CACHE_MISSES,
+	COUNTER_COUNT
+};
+
+enum class Gauge {
+	// files written by the atomic file writers, waiting for their commit
+	PENDING_COMMIT_FILES,
+	// licenses waiting to be written in the license index journal
+	PENDING_INDEX_RECORDS,
+	GAUGE_COUNT
+};
+
+enum class Histogram {
+	// License::write_license, from start to end
+	LICENSE_LATENCY,
+	SIGNATURE_LATENCY,
+	COMMIT_LATENCY,
+	HISTOGRAM_COUNT
+};
+
+/**
+ * Distribution of durations in nanoseconds. Buckets are log-linear: every power of two is split in
+ * 2^SUB_BUCKET_BITS buckets, so that percentiles have a relative error below 1/2^SUB_BUCKET_BITS at any scale.
+ */
+struct HistogramSnapshot {
+	static const unsigned SUB_BUCKET_BITS = 3;
+	static const size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+	uint64_t count;
+	uint64_t sum_ns;
+	std::vector<uint64_t> buckets;
+
+	HistogramSnapshot() : count(0), sum_ns(0), buckets(BUCKETS) {}
+	static size_t bucket(uint64_t value_ns);
+	// smallest value of a bucket
+	static uint64_t bucket_lower_bound(size_t bucket);
+	/**
+	 * Estimate of the quantile (0..1), the middle of the bucket it falls in. 0 if the histogram is empty.
+	 */
+	uint64_t quantile(double q) const;
+};
+
+/**
+ * Values of all the metrics at a point in time, merged from all the threads.
+ */
+struct MetricsSnapshot {
+	// seconds since the process started reporting
+	double uptime_s;
+	uint64_t counters[(size_t)Counter::COUNTER_COUNT];
+	int64_t gauges[(size_t)Gauge::GAUGE_COUNT];
+	HistogramSnapshot histograms[(size_t)Histogram::HISTOGRAM_COUNT];
+
+	inline uint64_t operator[](Counter counter) const { return counters[(size_t)counter]; }
+	inline int64_t operator[](Gauge gauge) const { return gauges[(size_t)gauge]; }
+	inline const HistogramSnapshot &operator[](Histogram histogram) const {
+		return histograms[(size_t)histogram];
+	}
+	/**
+	 * Counters and histograms accumulated since an earlier snapshot (gauges are kept as they are).
+	 */
+	MetricsSnapshot since(const MetricsSnapshot &earlier) const;
+	/**
+	 * Write the snapshot in OpenMetrics text format (counters, gauges and latency summaries), ended by # EOF.
+	 * @param previous
+	 * 			optional earlier snapshot: licenses and signatures per second since it are added as gauges.
+	 */
+	void write_openmetrics(std::ostream &os, const MetricsSnapshot *previous = nullptr) const;
+};
+
+/**
+ * Process wide registry of the metrics.
+ *
+ * <p>Every thread updates its own copy of the metrics, allocated the first time it reports something: updates are
+ * plain relaxed atomic stores with no lock and no shared cache line. snapshot() sums the copies of all the threads
+ * (including the ones that have terminated), so it's the only operation that costs more than a few nanoseconds.</p>
+ */
+class Metrics {
+public:
+	static void add(Counter counter, uint64_t amount = 1);
+	static void add(Gauge gauge, int64_t delta);
+	static void observe(Histogram histogram, uint64_t duration_ns);
+	static MetricsSnapshot snapshot();
+};
+
+/**
+ * Observes the time elapsed from its construction to its destruction in a histogram.
+ */
+class LatencyTimer {
+private:
+	const Histogram m_histogram;
+	const std::chrono::steady_clock::time_point m_start;
+
+public:
+	explicit LatencyTimer(Histogram histogram)
+		: m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+	LatencyTimer(const LatencyTimer &) = delete;
+	LatencyTimer &operator=(const LatencyTimer &) = delete;
+	inline ~LatencyTimer() {
+		Metrics::observe(m_histogram, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+										  std::chrono::steady_clock::now() - m_start)
+										  .count());
+	}
+};
+
+/**
+ * Write a snapshot of the metrics to a file every interval, and a last one when it is destroyed. The file is
+ * replaced atomically, so that a collector (eg. the node exporter textfile collector) never reads a partial one.
+ */
+class MetricsReporter {
+private:
+	const std::string m_file_name;
+	const std::chrono::milliseconds m_interval;
+	std::mutex m_mutex;
+	std::condition_variable m_stop_requested;
+	bool m_stopping;
+	// the last snapshot written, to compute the rates
+	std::mutex m_write_mutex;
+	MetricsSnapshot m_previous;
+	std::thread m_thread;
+	void run();
+
+public:
+	MetricsReporter(const std::string &file_name, std::chrono::milliseconds interval);
+	MetricsReporter(const MetricsReporter &) = delete;
+	MetricsReporter &operator=(const MetricsReporter &) = delete;
+	void write_snapshot();
+	virtual ~MetricsReporter();
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_METRICS_HPP_ */
@@ -0,0 +1,98 @@
+/*
+ * output_sink.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "output_sink.hpp"
+
+namespace license {
+using namespace std;
+
+#ifdef _WIN32
+void FdSink::write(const std::string *, const Segment *segments, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		size_t written = 0;
+		while (written < segments[i].size) {
+			const int res = _write(m_fd, segments[i].data + written, (unsigned int)(segments[i].size - written));
+			if (res < 0) {
+				throw runtime_error(string("Error writing license: ") + strerror(errno));
+			}
+			written += res;
+		}
+		m_bytes_written += written;
+	}
+}
+#else
+void FdSink::write(const std::string *, const Segment *segments, size_t count) {
+	const size_t MAX_SEGMENTS = 64;
+	struct iovec iov[MAX_SEGMENTS];
+	size_t first = 0;
+	while (first < count) {
+		const size_t iov_count = count - first < MAX_SEGMENTS ? count - first : MAX_SEGMENTS;
+		size_t to_write = 0;
+		for (size_t i = 0; i < iov_count; i++) {
+			iov[i].iov_base = const_cast<char *>(segments[first + i].data);
+			iov[i].iov_len = segments[first + i].size;
+			to_write += segments[first + i].size;
+		}
+		struct iovec *cur = iov;
+		size_t remaining_iov = iov_count;
+		while (to_write > 0) {
+			const ssize_t res = writev(m_fd, cur, (int)remaining_iov);
+			if (res < 0) {
+				if (errno == EINTR) continue;
+				throw runtime_error(string("Error writing license: ") + strerror(errno));
+			}
+			m_bytes_written += (size_t)res;
+			to_write -= (size_t)res;
+			// partial write (eg. a full pipe): skip what was written and retry
+			size_t done = (size_t)res;
+			while (remaining_iov > 0 && done >= cur->iov_len) {
+				done -= cur->iov_len;
+				cur++;
+				remaining_iov--;
+			}
+			if (remaining_iov > 0) {
+				cur->iov_base = static_cast<char *>(cur->iov_base) + done;
+				cur->iov_len -= done;
+			}
+		}
+		first += iov_count;
+	}
+}
+#endif
+
+void BufferSink::write(const std::string *, const Segment *segments, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		m_buffer.append(segments[i].data, segments[i].size);
+	}
+}
+
+void StreamSink::write(const std::string *, const Segment *segments, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		m_stream.write(segments[i].data, segments[i].size);
+	}
+	m_stream.flush();
+}
+
+void FileSink::write(const std::string *license_name, const Segment *segments, size_t count) {
+	if (license_name == nullptr) {
+		throw invalid_argument("License output file name not specified");
+	}
+	m_file_writer.write(*license_name, segments, count);
+}
+
+} /* namespace license */
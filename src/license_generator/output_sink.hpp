@@ -0,0 +1,97 @@
+/*
+ * output_sink.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_OUTPUT_SINK_HPP_
+#define SRC_LICENSE_GENERATOR_OUTPUT_SINK_HPP_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include "atomic_file.hpp"
+
+namespace license {
+
+/**
+ * Contiguous piece of a serialized license.
+ */
+struct Segment {
+	const char *data;
+	size_t size;
+};
+
+/**
+ * Destination of the serialized licenses.
+ *
+ * <p>A license is handed to the sink as a short list of contiguous segments (section headers and values,
+ * signatures), that the sink writes without copying them in an intermediate buffer.</p>
+ */
+class OutputSink {
+public:
+	/**
+	 * @param license_name
+	 * 			output name of the license, nullptr if not specified.
+	 * @param segments
+	 * 			license content
+	 */
+	virtual void write(const std::string *license_name, const Segment *segments, size_t count) = 0;
+	virtual ~OutputSink() {}
+};
+
+/**
+ * Write the licenses to an open file descriptor (file, pipe, socket) with one writev per license.
+ * The descriptor is not closed by the sink.
+ */
+class FdSink : public OutputSink {
+private:
+	const int m_fd;
+	size_t m_bytes_written;
+
+public:
+	explicit FdSink(int fd) : m_fd(fd), m_bytes_written(0) {}
+	virtual void write(const std::string *license_name, const Segment *segments, size_t count);
+	inline size_t bytes_written() const { return m_bytes_written; }
+};
+
+/**
+ * Append the licenses to a memory buffer.
+ */
+class BufferSink : public OutputSink {
+private:
+	std::string &m_buffer;
+
+public:
+	explicit BufferSink(std::string &buffer) : m_buffer(buffer) {}
+	virtual void write(const std::string *license_name, const Segment *segments, size_t count);
+};
+
+/**
+ * Write the licenses to a c++ stream (eg. std::cout).
+ */
+class StreamSink : public OutputSink {
+private:
+	std::ostream &m_stream;
+
+public:
+	explicit StreamSink(std::ostream &stream) : m_stream(stream) {}
+	virtual void write(const std::string *license_name, const Segment *segments, size_t count);
+};
+
+/**
+ * Write every license in its own file (the license name), atomically. See AtomicFileWriter.
+ */
+class FileSink : public OutputSink {
+private:
+	AtomicFileWriter &m_file_writer;
+
+public:
+	explicit FileSink(AtomicFileWriter &file_writer) : m_file_writer(file_writer) {}
+	virtual void write(const std::string *license_name, const Segment *segments, size_t count);
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_OUTPUT_SINK_HPP_ */
@@ -0,0 +1,62 @@
+/*
+ * parallel.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace license {
+using namespace std;
+
+unsigned int default_jobs() {
+	const unsigned int cores = thread::hardware_concurrency();
+	return cores == 0 ? 1 : cores;
+}
+
+void parallel_for(size_t count, unsigned int jobs, const std::function<void(size_t)> &task) {
+	if (jobs <= 1 || count <= 1) {
+		for (size_t i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+	atomic<size_t> next(0);
+	mutex error_mutex;
+	exception_ptr error;
+	auto worker = [&]() {
+		size_t item;
+		while ((item = next++) < count) {
+			try {
+				task(item);
+			} catch (...) {
+				lock_guard<mutex> guard(error_mutex);
+				if (!error) {
+					error = current_exception();
+				}
+				next = count;
+			}
+		}
+	};
+	vector<thread> threads;
+	const size_t thread_count = jobs < count ? jobs : count;
+	for (size_t i = 1; i < thread_count; i++) {
+		threads.push_back(thread(worker));
+	}
+	// the calling thread is a worker too
+	worker();
+	for (auto &it : threads) {
+		it.join();
+	}
+	if (error) {
+		rethrow_exception(error);
+	}
+}
+
+} /* namespace license */
@@ -0,0 +1,33 @@
+/*
+ * parallel.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_PARALLEL_HPP_
+#define SRC_LICENSE_GENERATOR_PARALLEL_HPP_
+
+#include <cstddef>
+#include <functional>
+
+namespace license {
+
+/**
+ * Number of worker threads used when the user doesn't specify it: the number of cores.
+ */
+unsigned int default_jobs();
+
+/**
+ * Run task(0) ... task(count - 1) on a pool of worker threads and wait for all of them.
+ *
+ * <p>Items are handed out one at a time, so that a slow item doesn't hold back a whole chunk. If a task throws no
+ * more items are started and the exception is rethrown once the running tasks complete: tasks that can fail on a
+ * single item should catch and record their own errors.</p>
+ * @param jobs
+ * 			number of threads, 1 runs the tasks in the calling thread.
+ */
+void parallel_for(size_t count, unsigned int jobs, const std::function<void(size_t)> &task);
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_PARALLEL_HPP_ */
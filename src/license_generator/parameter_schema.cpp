@@ -0,0 +1,51 @@
+/*
+ * parameter_schema.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "parameter_schema.hpp"
+
+namespace license {
+using namespace std;
+
+static constexpr uint32_t bucket_of(size_t idx) {
+	return parameter_hash(PARAMETER_SCHEMA[idx].name) % PARAMETER_SCHEMA_BUCKETS;
+}
+
+static constexpr bool collides_with_next(size_t idx, size_t other) {
+	return other >= PARAMETER_SCHEMA_SIZE ? false
+										  : (bucket_of(idx) == bucket_of(other) || collides_with_next(idx, other + 1));
+}
+
+static constexpr bool has_collisions(size_t idx = 0) {
+	return idx >= PARAMETER_SCHEMA_SIZE ? false : (collides_with_next(idx, idx + 1) || has_collisions(idx + 1));
+}
+
+static_assert(!has_collisions(), "parameter_hash is not perfect, change PARAMETER_SCHEMA_BUCKETS");
+
+// index of the parameter in the bucket, -1 if the bucket is empty
+static constexpr int schema_index(uint32_t bucket, size_t idx = 0) {
+	return idx >= PARAMETER_SCHEMA_SIZE ? -1 : (bucket_of(idx) == bucket ? (int)idx : schema_index(bucket, idx + 1));
+}
+
+#define SCHEMA_BUCKET_4(b) schema_index(b), schema_index(b + 1), schema_index(b + 2), schema_index(b + 3)
+#define SCHEMA_BUCKET_16(b) SCHEMA_BUCKET_4(b), SCHEMA_BUCKET_4(b + 4), SCHEMA_BUCKET_4(b + 8), SCHEMA_BUCKET_4(b + 12)
+
+static constexpr int SCHEMA_BUCKETS[] = {SCHEMA_BUCKET_16(0), SCHEMA_BUCKET_16(16), SCHEMA_BUCKET_16(32)};
+static_assert(sizeof(SCHEMA_BUCKETS) / sizeof(SCHEMA_BUCKETS[0]) >= PARAMETER_SCHEMA_BUCKETS,
+			  "SCHEMA_BUCKETS table is too small");
+
+const ParameterSchema *find_parameter(const std::string &name) {
+	uint32_t hash = 2166136261u;
+	for (const char c : name) {
+		hash = (hash ^ (uint32_t)(unsigned char)c) * 16777619u;
+	}
+	const int idx = SCHEMA_BUCKETS[hash % PARAMETER_SCHEMA_BUCKETS];
+	if (idx < 0 || name != PARAMETER_SCHEMA[idx].name) {
+		return nullptr;
+	}
+	return &PARAMETER_SCHEMA[idx];
+}
+
+} /* namespace license */
@@ -0,0 +1,120 @@
+/*
+ * parameter_schema.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_PARAMETER_SCHEMA_HPP_
+#define SRC_LICENSE_GENERATOR_PARAMETER_SCHEMA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../base_lib/base.h"
+
+namespace license {
+
+/**
+ * How the value of a parameter is normalized before it is used.
+ */
+enum class ParamKind {
+	// free text, copied as is in the license
+	STRING,
+	// date, normalized to YYYY-MM-DD
+	DATE,
+	// software version, "0" means all the versions and it is not written
+	VERSION,
+	// comma separated list of features (license sections)
+	FEATURE_NAMES,
+	// location of the private key
+	PRIMARY_KEY,
+	// command line switch, has no value
+	FLAG,
+	// consumed by the command line, ignored by the license
+	IGNORED,
+	// known parameter, that can't be set when issuing a license
+	UNSUPPORTED
+};
+
+/**
+ * Definition of a license parameter. The same definition is used to build the command line options of
+ * `license issue` and to validate and normalize the parameters in License::add_parameter.
+ */
+struct ParameterSchema {
+	const char *name;
+	// short command line option, 0 if none
+	char short_name;
+	ParamKind kind;
+	// true if the parameter is written in the license (and signed)
+	bool serialized;
+	// default value on the command line, nullptr if none
+	const char *default_value;
+	// how the default value is shown in the help
+	const char *default_description;
+	// command line help. nullptr if the parameter is not a command line option
+	const char *description;
+};
+
+constexpr ParameterSchema PARAMETER_SCHEMA[] = {
+	{PARAM_BASE64, 'b', ParamKind::FLAG, false, nullptr, nullptr,
+	 "Encode license as base64 for inclusion in environment variables."},
+	{PARAM_FORMAT, 0, ParamKind::IGNORED, false, "ini", nullptr,
+	 "Format of the license: ini (the one read by the clients), binary or json. Signatures are the same in every "
+	 "format."},
+	{PARAM_BEGIN_DATE, 0, ParamKind::DATE, true, nullptr, nullptr,
+	 "Specify the start of the validity for this license.  Format YYYYMMDD, or relative to today (eg. +30d, +12m)."
+	 " If not specified defaults to today"},
+	{PARAM_EXPIRY_DATE, 'e', ParamKind::DATE, true, nullptr, nullptr,
+	 "Specify the expire date for this license.  Format YYYYMMDD, or relative to today (eg. +30d, +12m)."
+	 " If not specified the license won't expire"},
+	{PARAM_CLIENT_SIGNATURE, 's', ParamKind::STRING, true, nullptr, nullptr,
+	 "The signature of the hardware that requires the license. It should be in the format XXXX-XXXX-XXXX. If not "
+	 "specified the license won't be linked to a specific hardware (eg. demo license)."},
+	{PARAM_LICENSE_OUTPUT, 'o', ParamKind::IGNORED, false, nullptr, nullptr,
+	 "License output file name. May contain / that will be interpreded as subfolders."},
+	{PARAM_FEATURE_NAMES, 'f', ParamKind::FEATURE_NAMES, false, nullptr, nullptr,
+	 "Feature names: comma separate list of project features to enable. if not specified will be taken as project "
+	 "name."},
+	{PARAM_PRIMARY_KEY, 0, ParamKind::PRIMARY_KEY, false, nullptr, nullptr,
+	 "Primary key location, in case it is not in default folder"},
+	{PARAM_KEYSTORE, 0, ParamKind::IGNORED, false, nullptr, nullptr,
+	 "Keystore holding the key of the project (see keystore import), used instead of the key in the project folder."},
+	{PARAM_PROJECT_FOLDER, 'p', ParamKind::IGNORED, false, ".", nullptr,
+	 "path to where project configurations and licenses are stored."},
+	{PARAM_LICENSES_FOLDER, 'l', ParamKind::IGNORED, false, nullptr, nullptr,
+	 "Folder the output file name is relative to. If the folder is sharded (see " PARAM_SHARD_FANOUT
+	 ") the license is placed in its shard."},
+	{PARAM_SHARD_FANOUT, 0, ParamKind::IGNORED, false, nullptr, nullptr,
+	 "Spread the licenses of " PARAM_LICENSES_FOLDER " among this many hash-prefixed subfolders. It is recorded in "
+	 "the folder the first time, later commands use it automatically."},
+	{PARAM_VERSION_FROM, 0, ParamKind::VERSION, true, "0", "All Versions",
+	 "Specify the first version of the software this license apply to."},
+	{PARAM_VERSION_TO, 0, ParamKind::VERSION, true, "0", "All Versions",
+	 "Specify the last version of the software this license apply to."},
+	{PARAM_EXTRA_DATA, 'x', ParamKind::STRING, true, nullptr, nullptr,
+	 "Specify extra data to be included into the license"},
+	{PARAM_MAGIC_NUMBER, 0, ParamKind::UNSUPPORTED, false, nullptr, nullptr, nullptr},
+};
+
+constexpr size_t PARAMETER_SCHEMA_SIZE = sizeof(PARAMETER_SCHEMA) / sizeof(PARAMETER_SCHEMA[0]);
+
+/**
+ * Number of buckets of the perfect hash. If a new parameter collides with an existing one compilation fails:
+ * change this number until the static_assert in parameter_schema.cpp is satisfied.
+ */
+constexpr uint32_t PARAMETER_SCHEMA_BUCKETS = 39;
+
+constexpr uint32_t parameter_hash(const char *name, uint32_t hash = 2166136261u) {
+	return *name == 0 ? hash : parameter_hash(name + 1, (hash ^ (uint32_t)(unsigned char)*name) * 16777619u);
+}
+
+/**
+ * Find the definition of a parameter.
+ * @return the definition or nullptr if the parameter is not a known one.
+ */
+const ParameterSchema *find_parameter(const std::string &name);
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_PARAMETER_SCHEMA_HPP_ */
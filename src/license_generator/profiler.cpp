@@ -0,0 +1,147 @@
+/*
+ * profiler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "profiler.hpp"
+
+namespace license {
+using namespace std;
+
+std::atomic<bool> Profiler::s_enabled(false);
+
+static const char *const STAGE_NAMES[] = {"option_parsing", "project_resolution", "key_load",
+										  "key_generation", "key_export",		  "previous_license_load",
+										  "canonicalization", "signing",		  "serialization",
+										  "file_write",		"file_commit"};
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == (size_t)Stage::STAGE_COUNT, "a name for every stage");
+
+namespace {
+struct StageStats {
+	mutex stats_mutex;
+	uint64_t count;
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+	uint64_t max_wall_ns;
+	// reservoir sample of the wall times
+	vector<uint64_t> samples;
+	uint64_t random_state;
+
+	StageStats() { reset(); }
+	void reset() {
+		count = wall_ns = cpu_ns = max_wall_ns = 0;
+		samples.clear();
+		random_state = 0x9E3779B97F4A7C15ull;
+	}
+	// xorshift64: the sample only needs to be uniform, not unpredictable
+	uint64_t next_random() {
+		random_state ^= random_state << 13;
+		random_state ^= random_state >> 7;
+		random_state ^= random_state << 17;
+		return random_state;
+	}
+};
+
+struct RunStats {
+	chrono::steady_clock::time_point wall_start;
+	clock_t cpu_start;
+	StageStats stages[(size_t)Stage::STAGE_COUNT];
+};
+}  // namespace
+
+static RunStats &run_stats() {
+	static RunStats stats;
+	return stats;
+}
+
+uint64_t thread_cpu_ns() {
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+		return 0;
+	}
+	const uint64_t kernel_100ns = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	const uint64_t user_100ns = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+	return (kernel_100ns + user_100ns) * 100;
+#else
+	struct timespec now;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+		return 0;
+	}
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void Profiler::enable(bool enabled) {
+	if (enabled) {
+		RunStats &stats = run_stats();
+		for (auto &stage : stats.stages) {
+			lock_guard<mutex> guard(stage.stats_mutex);
+			stage.reset();
+		}
+		stats.wall_start = chrono::steady_clock::now();
+		stats.cpu_start = clock();
+	}
+	s_enabled.store(enabled);
+}
+
+void Profiler::record(Stage stage, uint64_t wall_ns, uint64_t cpu_ns) {
+	StageStats &stats = run_stats().stages[(size_t)stage];
+	lock_guard<mutex> guard(stats.stats_mutex);
+	stats.count++;
+	stats.wall_ns += wall_ns;
+	stats.cpu_ns += cpu_ns;
+	stats.max_wall_ns = max(stats.max_wall_ns, wall_ns);
+	if (stats.samples.size() < MAX_SAMPLES) {
+		stats.samples.push_back(wall_ns);
+	} else {
+		const uint64_t slot = stats.next_random() % stats.count;
+		if (slot < MAX_SAMPLES) {
+			stats.samples[(size_t)slot] = wall_ns;
+		}
+	}
+}
+
+const char *Profiler::stage_name(Stage stage) { return STAGE_NAMES[(size_t)stage]; }
+
+static inline double to_ms(uint64_t ns) { return ns / 1e6; }
+
+void Profiler::print_json(std::ostream &os) {
+	RunStats &stats = run_stats();
+	const chrono::duration<double, milli> wall = chrono::steady_clock::now() - stats.wall_start;
+	const double cpu_ms = (clock() - stats.cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+	os << "{\"wall_ms\": " << wall.count() << ", \"cpu_ms\": " << cpu_ms << ", \"stages\": {";
+	bool first = true;
+	for (size_t i = 0; i < (size_t)Stage::STAGE_COUNT; i++) {
+		StageStats &stage = stats.stages[i];
+		lock_guard<mutex> guard(stage.stats_mutex);
+		if (stage.count == 0) {
+			continue;
+		}
+		os << (first ? "" : ", ") << "\"" << STAGE_NAMES[i] << "\": {\"count\": " << stage.count
+		   << ", \"wall_ms\": " << to_ms(stage.wall_ns) << ", \"cpu_ms\": " << to_ms(stage.cpu_ns);
+		if (stage.count > 1) {
+			vector<uint64_t> sorted(stage.samples);
+			sort(sorted.begin(), sorted.end());
+			os << ", \"wall_ms_p50\": " << to_ms(nearest_rank_percentile(sorted, 50))
+			   << ", \"wall_ms_p90\": " << to_ms(nearest_rank_percentile(sorted, 90))
+			   << ", \"wall_ms_p99\": " << to_ms(nearest_rank_percentile(sorted, 99))
+			   << ", \"wall_ms_max\": " << to_ms(stage.max_wall_ns);
+		}
+		os << "}";
+		first = false;
+	}
+	os << "}}" << endl;
+}
+
+} /* namespace license */
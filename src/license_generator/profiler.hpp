@@ -0,0 +1,116 @@
+/*
+ * profiler.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_PROFILER_HPP_
+#define SRC_LICENSE_GENERATOR_PROFILER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace license {
+
+/**
+ * Stages of a command timed by the profiler. Stages may nest: in immediate mode the file write includes its commit.
+ */
+enum class Stage {
+	OPTION_PARSING,
+	// checks and canonicalization of the project folder
+	PROJECT_RESOLUTION,
+	// read and parse a private key
+	KEY_LOAD,
+	KEY_GENERATION,
+	// render and write the public key artifacts of a project
+	KEY_EXPORT,
+	// read and parse a license that is being extended
+	PREVIOUS_LICENSE_LOAD,
+	// build the signed text of the license sections
+	CANONICALIZATION,
+	// sign or verify the license sections
+	SIGNING,
+	SERIALIZATION,
+	// write the license to its destination (file, standard output, sink)
+	FILE_WRITE,
+	// make the written files durable and visible
+	FILE_COMMIT,
+	STAGE_COUNT
+};
+
+/**
+ * Time spent in each stage, enabled by the --profile command line option.
+ *
+ * <p>When profiling is disabled a StageTimer only checks a flag. When it's enabled every stage execution records its
+ * wall and thread CPU time: totals are exact, percentiles are computed on a uniform sample of at most
+ * MAX_SAMPLES executions per stage, so that the memory used doesn't grow with the number of licenses issued.
+ * Recording is safe from multiple threads.</p>
+ */
+class Profiler {
+private:
+	static std::atomic<bool> s_enabled;
+
+public:
+	static const size_t MAX_SAMPLES = 65536;
+	/**
+	 * Enable or disable the profiler. Enabling it resets the collected times and starts the run clock.
+	 */
+	static void enable(bool enabled);
+	static inline bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+	static void record(Stage stage, uint64_t wall_ns, uint64_t cpu_ns);
+	/**
+	 * Print the times collected since the profiler was enabled as a JSON object: run totals and, for each stage
+	 * executed, count, totals and (for stages executed more than once) percentiles of the wall time.
+	 */
+	static void print_json(std::ostream &os);
+	static const char *stage_name(Stage stage);
+};
+
+// CPU time of the calling thread
+uint64_t thread_cpu_ns();
+
+// nearest rank percentile (0..100) of sorted, non empty, samples
+template <typename T> inline T nearest_rank_percentile(const std::vector<T> &sorted, double p) {
+	const size_t rank = (size_t)(p * sorted.size() / 100.0 + 0.5);
+	return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+/**
+ * Times a stage from its construction to stop() or to its destruction.
+ */
+class StageTimer {
+private:
+	const Stage m_stage;
+	bool m_active;
+	std::chrono::steady_clock::time_point m_wall_start;
+	uint64_t m_cpu_start;
+
+public:
+	explicit StageTimer(Stage stage) : m_stage(stage), m_active(Profiler::enabled()) {
+		if (m_active) {
+			m_wall_start = std::chrono::steady_clock::now();
+			m_cpu_start = thread_cpu_ns();
+		}
+	}
+	StageTimer(const StageTimer &) = delete;
+	StageTimer &operator=(const StageTimer &) = delete;
+	inline void stop() {
+		if (m_active) {
+			m_active = false;
+			const uint64_t wall_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+										 std::chrono::steady_clock::now() - m_wall_start)
+										 .count();
+			Profiler::record(m_stage, wall_ns, thread_cpu_ns() - m_cpu_start);
+		}
+	}
+	inline ~StageTimer() { stop(); }
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_PROFILER_HPP_ */
@@ -9,11 +9,20 @@
 #include <boost/filesystem.hpp>
 #include <stdexcept>
 #include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
 
 #include "../inja/inja.hpp"
 #include "../base_lib/base.h"
 #include "../base_lib/crypto_helper.hpp"
+#include "atomic_file.hpp"
+#include "profiler.hpp"
 #include "project.hpp"
+#include "project_index.hpp"
 
 namespace license {
 namespace fs = boost::filesystem;
@@ -36,21 +45,35 @@ static const constexpr char *const TEMPLATE = "public_key.inja";
 	return FUNC_RET_OK;
 }*/
 
+static const constexpr char *const TEMPLATE_EXTENSION = ".inja";
+static const constexpr char *const KEYS_FOLDER = "keys";
+
+static bool has_templates(const fs::path &folder) {
+	if (!fs::is_directory(folder)) {
+		return false;
+	}
+	for (fs::directory_iterator it(folder); it != fs::directory_iterator(); ++it) {
+		if (fs::is_regular_file(it->status()) && it->path().extension() == TEMPLATE_EXTENSION) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static const string guess_templates_folder(const string &source_folder) {
 	fs::path templates_path(source_folder);
 	if (!fs::exists(templates_path) || !fs::is_directory(templates_path)) {
 		throw std::runtime_error(string("Templates directory [") + templates_path.string() +
 								 "] does not exist or is not a directory");
 	}
-	fs::path template_fname(templates_path / TEMPLATE);
-	if (!fs::exists(template_fname) || !fs::is_regular_file(template_fname)) {
+	if (!has_templates(templates_path)) {
 		// try to add a /templates
-		templates_path = templates_path / "templates";
-		fs::path template_fname2(templates_path / TEMPLATE);
-		if (!fs::exists(template_fname2) || !fs::is_regular_file(template_fname2)) {
-			throw std::runtime_error(string("Templates file [") + template_fname2.string() +
-									 "] does not exist. tried also [" + template_fname.string() + "]");
+		const fs::path templates_path2 = templates_path / "templates";
+		if (!has_templates(templates_path2)) {
+			throw std::runtime_error(string("Templates file [") + (templates_path2 / TEMPLATE).string() +
+									 "] does not exist. tried also [" + (templates_path / TEMPLATE).string() + "]");
 		}
+		templates_path = templates_path2;
 	}
 	fs::path normalized = templates_path.normalize();
 	return normalized.string();
@@ -59,42 +82,179 @@ static const fs::path publicKeyFolder(const fs::path &product_folder, const stri
 	return product_folder / "include" / "licensecc" / product_name;
 }
 
+// true if the template uses the public_key array, not only public_key_len or the callbacks
+static bool uses_key_array(const string &template_text) {
+	static const string KEY_ARRAY("public_key");
+	for (size_t pos = template_text.find(KEY_ARRAY); pos != string::npos;
+		 pos = template_text.find(KEY_ARRAY, pos + KEY_ARRAY.size())) {
+		const size_t next = pos + KEY_ARRAY.size();
+		if (next == template_text.size() || !(isalnum((unsigned char)template_text[next]) || template_text[next] == '_')) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// key of the project being rendered by this thread, read by the template callbacks.
+static thread_local const vector<unsigned char> *rendered_key = nullptr;
+
+static const vector<unsigned char> &current_key() {
+	if (rendered_key == nullptr) {
+		throw logic_error("public key callbacks used outside of a key template");
+	}
+	return *rendered_key;
+}
+
+KeyTemplates::KeyTemplates(const std::string &source_folder)
+	: m_templates_folder(guess_templates_folder(source_folder)), m_env(new Environment(m_templates_folder + "/")) {
+	m_env->add_callback("public_key_bytes", 0, [](Arguments &) {
+		const vector<unsigned char> &key = current_key();
+		string bytes;
+		bytes.reserve(key.size() * 4);
+		for (size_t i = 0; i < key.size(); i++) {
+			if (i > 0) bytes += ',';
+			bytes += to_string(key[i]);
+		}
+		return json(bytes);
+	});
+	m_env->add_callback("public_key_hex", 0, [](Arguments &) {
+		static const char HEX[] = "0123456789abcdef";
+		const vector<unsigned char> &key = current_key();
+		string hex(key.size() * 2, '0');
+		for (size_t i = 0; i < key.size(); i++) {
+			hex[i * 2] = HEX[key[i] >> 4];
+			hex[i * 2 + 1] = HEX[key[i] & 0xf];
+		}
+		return json(hex);
+	});
+	vector<fs::path> template_files;
+	for (fs::directory_iterator it(m_templates_folder); it != fs::directory_iterator(); ++it) {
+		if (fs::is_regular_file(it->status()) && it->path().extension() == TEMPLATE_EXTENSION) {
+			template_files.push_back(it->path());
+		}
+	}
+	sort(template_files.begin(), template_files.end());
+	for (const auto &template_file : template_files) {
+		Artifact artifact;
+		artifact.template_name = template_file.filename().string();
+		artifact.output_name =
+			artifact.template_name == TEMPLATE ? string(PUBLIC_KEY_INC_FNAME) : template_file.stem().string();
+		ifstream template_stream(template_file.string());
+		const string template_text((istreambuf_iterator<char>(template_stream)), istreambuf_iterator<char>());
+		artifact.needs_key_array = uses_key_array(template_text);
+		m_templates.push_back(unique_ptr<Template>(new Template(m_env->parse(template_text))));
+		m_artifacts.push_back(artifact);
+	}
+}
+
+shared_ptr<const KeyTemplates> KeyTemplates::get(const std::string &source_folder) {
+	static mutex cache_mutex;
+	static map<string, shared_ptr<const KeyTemplates>> cache;
+	const string templates_folder = fs::canonical(guess_templates_folder(source_folder)).string();
+	lock_guard<mutex> guard(cache_mutex);
+	auto it = cache.find(templates_folder);
+	if (it != cache.end()) {
+		return it->second;
+	}
+	shared_ptr<const KeyTemplates> templates = make_shared<const KeyTemplates>(templates_folder);
+	cache[templates_folder] = templates;
+	return templates;
+}
+
+std::vector<std::string> KeyTemplates::render(const std::string &project_name,
+											  const std::vector<unsigned char> &public_key) const {
+	json data;
+	data["public_key_len"] = public_key.size();
+	data["product_name"] = project_name;
+	bool with_array = false;
+	struct KeyGuard {
+		explicit KeyGuard(const vector<unsigned char> &key) { rendered_key = &key; }
+		~KeyGuard() { rendered_key = nullptr; }
+	} key_guard(public_key);
+	vector<string> rendered;
+	for (size_t i = 0; i < m_artifacts.size(); i++) {
+		if (m_artifacts[i].needs_key_array && !with_array) {
+			data["public_key"] = public_key;
+			with_array = true;
+		}
+		// rendering only reads the environment, it is safe to render the same templates from many threads.
+		rendered.push_back(m_env->render(*m_templates[i], data));
+	}
+	return rendered;
+}
+
+KeyTemplates::~KeyTemplates() {}
+
 Project::Project(const std::string &name, const std::string &project_folder, const std::string &source_folder,
 				 bool force_overwrite)
+	: Project(name, project_folder, KeyTemplates::get(source_folder), force_overwrite) {}
+
+Project::Project(const std::string &name, const std::string &project_folder,
+				 const std::shared_ptr<const KeyTemplates> &key_templates, bool force_overwrite)
 	: m_name(name),
 	  m_project_folder(project_folder),
-	  m_templates_folder(guess_templates_folder(source_folder)),
-	  m_force_overwrite(force_overwrite) {
+	  m_templates(key_templates),
+	  m_force_overwrite(force_overwrite),
+	  m_keys_generated(false) {
 	if (name.find('[') != std::string::npos || name.find(']') != std::string::npos ||
 		name.find('/') != std::string::npos || name.find('\\') != std::string::npos) {
 		throw invalid_argument("project name should not contain any of '[ ] / \' characters.");
 	}
 }
 
-void Project::exportPublicKey(const std::string &include_folder, const std::unique_ptr<CryptoHelper> &cryptoHelper) {
-	const fs::path templates_path(m_templates_folder);
-	Environment env(templates_path.string() + "/", include_folder + "/");
-	Template temp = env.parse_template(TEMPLATE);
-	json data;
-	const vector<unsigned char> pkey = cryptoHelper->exportPublicKey();
-	data["public_key"] = pkey;
-	data["public_key_len"] = pkey.size();
-	data["product_name"] = m_name;
-	env.write(temp, data, PUBLIC_KEY_INC_FNAME);
+const std::string Project::artifact_path(const std::string &destination_dir,
+										 const KeyTemplates::Artifact &artifact) const {
+	const fs::path folder = artifact.output_name == PUBLIC_KEY_INC_FNAME ? publicKeyFolder(destination_dir, m_name)
+																		   : fs::path(destination_dir) / KEYS_FOLDER;
+	return (folder / artifact.output_name).string();
+}
+
+void Project::exportPublicKey(const std::string &destination_dir, const std::unique_ptr<CryptoHelper> &cryptoHelper,
+							  bool missing_only) {
+	StageTimer timer(Stage::KEY_EXPORT);
+	const vector<KeyTemplates::Artifact> &artifacts = m_templates->artifacts();
+	const vector<string> rendered = m_templates->render(m_name, cryptoHelper->exportPublicKey());
+	AtomicFileWriter file_writer;
+	for (size_t i = 0; i < artifacts.size(); i++) {
+		const string output = artifact_path(destination_dir, artifacts[i]);
+		if (missing_only && fs::exists(output)) {
+			continue;
+		}
+		fs::create_directories(fs::path(output).parent_path());
+		file_writer.write(output, rendered[i]);
+	}
+}
+
+void Project::fill_manifest(const std::unique_ptr<CryptoHelper> &cryptoHelper, std::time_t created) {
+	m_manifest.name = m_name;
+	m_manifest.key_algorithm = PROJECT_KEY_ALGORITHM;
+	m_manifest.key_fingerprint = cryptoHelper->publicKeyFingerprint();
+	m_manifest.created = manifest_timestamp(created);
+	m_manifest.templates = m_templates->templates_folder();
+	m_manifest.artifacts.clear();
+	for (const auto &artifact : m_templates->artifacts()) {
+		m_manifest.artifacts += (m_manifest.artifacts.empty() ? "" : ",") + artifact.output_name;
+	}
 }
 
-FUNCTION_RETURN Project::initialize() {
+FUNCTION_RETURN Project::initialize(bool update_index) {
 	const fs::path destinationDir(fs::path(m_project_folder) / m_name);
 	const fs::path include_folder(publicKeyFolder(destinationDir, m_name));
-	const fs::path publicKeyFile(include_folder / PUBLIC_KEY_INC_FNAME);
 	const fs::path privateKeyFile(destinationDir / PRIVATE_KEY_FNAME);
 	bool keyFilesExist = false;
+	bool rotation = false;
 	if (fs::exists(destinationDir)) {
 		keyFilesExist = fs::exists(destinationDir / PRIVATE_KEY_FNAME);
 		if (m_force_overwrite && keyFilesExist) {
+			// one rotation at a time: the licenses signed with the key kept aside can be signed again only with it
+			if (fs::exists(destinationDir / PREVIOUS_PRIVATE_KEY_FNAME)) {
+				throw std::runtime_error("Key of project [" + m_name + "] not rotated: the key replaced by the last "
+										 "rotation (" PREVIOUS_PRIVATE_KEY_FNAME ") is still in the project folder. "
+										 "Sign the licenses again with license resign --retire-previous-key first.");
+			}
+			// the old key stays in place until the new one replaces it
 			keyFilesExist = false;
-			fs::remove(destinationDir / PRIVATE_KEY_FNAME);
-			fs::remove(publicKeyFile);
+			rotation = true;
 		}
 		if (!fs::exists(include_folder)) {
 			if (!fs::create_directories(include_folder)) {
@@ -105,23 +265,59 @@ FUNCTION_RETURN Project::initialize() {
 		throw std::runtime_error("Cannot create destination directory [" + destinationDir.string() + "]");
 	}
 	FUNCTION_RETURN result = FUNC_RET_OK;
+	m_keys_generated = false;
 	unique_ptr<CryptoHelper> cryptoHelper(CryptoHelper::getInstance());
 	if (keyFilesExist) {
-		if (!fs::exists(publicKeyFile)) {
-			// how strange, private key was found, but public key is not.
-			// Let's regenerate public key
+		bool missing = false;
+		for (const auto &artifact : m_templates->artifacts()) {
+			missing = missing || !fs::exists(artifact_path(destinationDir.string(), artifact));
+		}
+		if (missing) {
+			// private key was found, but some public key artifacts are not (eg. a template was added).
+			// Let's regenerate them
+			StageTimer timer(Stage::KEY_LOAD);
 			cryptoHelper->loadPrivateKey_file(privateKeyFile.string());
-			exportPublicKey(include_folder.string(), cryptoHelper);
+			timer.stop();
+			exportPublicKey(destinationDir.string(), cryptoHelper, true);
+		}
+		if (!read_manifest(destinationDir.string(), m_manifest)) {
+			// project created before manifests existed
+			if (!missing) {
+				StageTimer timer(Stage::KEY_LOAD);
+				cryptoHelper->loadPrivateKey_file(privateKeyFile.string());
+			}
+			fill_manifest(cryptoHelper, fs::last_write_time(privateKeyFile));
+			write_manifest(destinationDir.string(), m_manifest);
 		}
 	} else {
-		ofstream ofs;
+		AtomicFileWriter file_writer;
+		if (rotation) {
+			// kept aside, license resign checks the licenses against it before signing them again
+			ifstream old_key(privateKeyFile.string(), ios::binary);
+			const string old_key_pem((istreambuf_iterator<char>(old_key)), istreambuf_iterator<char>());
+			if (old_key.bad() || old_key_pem.empty()) {
+				throw runtime_error("Can not read the private key [" + privateKeyFile.string() + "]");
+			}
+			file_writer.write((destinationDir / PREVIOUS_PRIVATE_KEY_FNAME).string(), old_key_pem);
+			// the artifacts of the old key go first: if the rotation is interrupted the next project init writes
+			// them again, from whichever private key is in place
+			for (const auto &artifact : m_templates->artifacts()) {
+				fs::remove(artifact_path(destinationDir.string(), artifact));
+			}
+			fs::remove(destinationDir / PROJECT_MANIFEST_FNAME);
+		}
+		StageTimer timer(Stage::KEY_GENERATION);
 		cryptoHelper->generateKeyPair();
-		const std::string privateKey = cryptoHelper->exportPrivateKey();
-		const string private_key_file_str = privateKeyFile.string();
-		ofs.open(private_key_file_str.c_str(), std::fstream::trunc | std::fstream::binary);
-		ofs << privateKey;
-		ofs.close();
-		exportPublicKey(include_folder.string(), cryptoHelper);
+		timer.stop();
+		// the private key first: the public key artifacts missing are exported again from it by the next init
+		file_writer.write(privateKeyFile.string(), cryptoHelper->exportPrivateKey());
+		exportPublicKey(destinationDir.string(), cryptoHelper, false);
+		m_keys_generated = true;
+		fill_manifest(cryptoHelper, time(nullptr));
+		write_manifest(destinationDir.string(), m_manifest);
+	}
+	if (update_index) {
+		update_project_index(m_project_folder, vector<ProjectManifest>(1, m_manifest));
 	}
 	return result;
 }
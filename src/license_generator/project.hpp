@@ -10,26 +10,113 @@
 
 #include "../base_lib/base.h"
 #include "../base_lib/crypto_helper.hpp"
+#include "project_index.hpp"
 #include <boost/optional.hpp>
+#include <ctime>
+#include <memory>
 #include <string>
+#include <vector>
+
+namespace inja {
+class Environment;
+struct Template;
+}  // namespace inja
 
 namespace license {
 
+/**
+ * Templates of the public key artifacts of a templates folder (public_key.h, but also key files for other languages).
+ *
+ * <p>Every <code>name.inja</code> file of the folder renders the artifact <code>name</code>, the legacy
+ * <code>public_key.inja</code> renders the C header <code>public_key.h</code>. Templates are parsed once: get() keeps
+ * them cached for the whole process. The same instance can be shared by many projects and rendered from many threads
+ * at the same time.</p>
+ *
+ * <p>Besides <code>product_name</code> and <code>public_key_len</code>, templates can print the key with the callbacks
+ * <code>public_key_bytes()</code> (comma separated decimal bytes) and <code>public_key_hex()</code>, that read it
+ * directly from the key buffer. The <code>public_key</code> array (one json element per byte) is only built for
+ * templates that use it.</p>
+ */
+class KeyTemplates {
+public:
+	struct Artifact {
+		// template file name
+		std::string template_name;
+		// rendered file name
+		std::string output_name;
+		// the template loops on the public_key array
+		bool needs_key_array;
+	};
+
+private:
+	std::string m_templates_folder;
+	std::unique_ptr<inja::Environment> m_env;
+	std::vector<Artifact> m_artifacts;
+	std::vector<std::unique_ptr<inja::Template>> m_templates;
+
+public:
+	/**
+	 * Parse all the templates of a folder, bypassing the cache.
+	 * @param source_folder
+	 * 			folder containing the templates, or its "templates" subfolder.
+	 */
+	explicit KeyTemplates(const std::string &source_folder);
+	KeyTemplates(const KeyTemplates &) = delete;
+	KeyTemplates &operator=(const KeyTemplates &) = delete;
+	/**
+	 * Templates of a folder, parsed the first time they are requested in this process.
+	 */
+	static std::shared_ptr<const KeyTemplates> get(const std::string &source_folder);
+	inline const std::string &templates_folder() const { return m_templates_folder; }
+	inline const std::vector<Artifact> &artifacts() const { return m_artifacts; }
+	/**
+	 * Render the artifacts of a project in one pass.
+	 * @return the content of the artifacts, in the same order of artifacts()
+	 */
+	std::vector<std::string> render(const std::string &project_name,
+									const std::vector<unsigned char> &public_key) const;
+	~KeyTemplates();
+};
+
 class Project {
 private:
 	const std::string m_name;
 	boost::optional<std::string> m_primary_key_file_name(boost::optional<std::string>());
 	boost::optional<std::string> m_public_key_file_name(boost::optional<std::string>());
-	void exportPublicKey(const std::string &include_folder, const std::unique_ptr<CryptoHelper> &cryptoHelper);
+	void exportPublicKey(const std::string &destination_dir, const std::unique_ptr<CryptoHelper> &cryptoHelper,
+						 bool missing_only);
+	const std::string artifact_path(const std::string &destination_dir, const KeyTemplates::Artifact &artifact) const;
+	void fill_manifest(const std::unique_ptr<CryptoHelper> &cryptoHelper, std::time_t created);
 
 	std::string m_project_folder;
-	std::string m_templates_folder;
+	const std::shared_ptr<const KeyTemplates> m_templates;
 	const bool m_force_overwrite;
+	bool m_keys_generated;
+	ProjectManifest m_manifest;
 
 public:
 	Project(const std::string &name, const std::string &project_folder, const std::string &source_folder,
 			const bool force_overwrite = false);
-	FUNCTION_RETURN initialize();
+	/**
+	 * @param key_templates
+	 * 			templates already parsed, eg. shared by all the projects initialized in the same run.
+	 */
+	Project(const std::string &name, const std::string &project_folder,
+			const std::shared_ptr<const KeyTemplates> &key_templates, const bool force_overwrite = false);
+	/**
+	 * Create the project folder, the key pair and the public key artifacts: public_key.h goes in
+	 * include/licensecc/[name], the other artifacts in the keys folder of the project. Files are written atomically: an
+	 * interrupted initialization never leaves a truncated key. If the keys exist the missing artifacts are rendered.
+	 * The project manifest is written too.
+	 * @param update_index
+	 * 			add the project to the index of the projects folder. Pass false when initializing many projects and
+	 * 			call update_project_index() once at the end.
+	 */
+	FUNCTION_RETURN initialize(bool update_index = true);
+	// manifest of the project, available after initialize()
+	inline const ProjectManifest &manifest() const { return m_manifest; }
+	// true if the last initialize() generated a new key pair, false if the project keys already existed
+	inline bool keys_generated() const { return m_keys_generated; }
 	~Project();
 };
 
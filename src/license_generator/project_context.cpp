@@ -0,0 +1,96 @@
+/*
+ * project_context.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#include "../base_lib/base.h"
+#include "metrics.hpp"
+#include "profiler.hpp"
+#include "project_context.hpp"
+
+namespace license {
+using namespace std;
+namespace fs = boost::filesystem;
+
+static const string normalize_project_path(const string &project_path) {
+	StageTimer timer(Stage::PROJECT_RESOLUTION);
+	const fs::path rproject_path(project_path);
+	if (!fs::exists(rproject_path) || !fs::is_directory(rproject_path)) {
+		throw logic_error("Path " + project_path + " doesn't exist or is not a directory.");
+	}
+	fs::path normalized;
+	const string rproject_path_str = rproject_path.string();
+	if (rproject_path.string() == ".") {
+		normalized = fs::current_path();
+		// sometimes is_relative fails under wine: a linux path is taken for a relative path.
+		normalized = fs::canonical(fs::current_path() / rproject_path);
+	} else {
+		normalized = fs::canonical(rproject_path);
+	}
+	return normalized.string();
+}
+
+ProjectContext::ProjectContext(const std::string &project_folder)
+	: m_project_folder(normalize_project_path(project_folder)),
+	  // default feature = project name
+	  m_default_features(fs::path(m_project_folder).filename().string()),
+	  m_private_key_file((fs::path(m_project_folder) / PRIVATE_KEY_FNAME).string()),
+	  m_license_index(new LicenseIndex(m_project_folder)),
+	  m_ledger(new LicenseLedger(m_project_folder)) {}
+
+ProjectContext::ProjectContext(const std::string &project_folder, const std::shared_ptr<const Keystore> &keystore)
+	: m_project_folder(normalize_project_path(project_folder)),
+	  m_default_features(fs::path(m_project_folder).filename().string()),
+	  m_private_key_file((fs::path(m_project_folder) / PRIVATE_KEY_FNAME).string()),
+	  m_keystore(keystore),
+	  m_license_index(new LicenseIndex(m_project_folder)),
+	  m_ledger(new LicenseLedger(m_project_folder)) {}
+
+ProjectContext::ProjectContext(const std::string &project_name, const shared_ptr<const CryptoHelper> &private_key)
+	: m_project_folder(), m_default_features(project_name), m_private_key_file() {
+	if (!private_key) {
+		throw invalid_argument("Private key of project " + project_name + " is missing");
+	}
+	m_keys[m_private_key_file] = private_key;
+}
+
+static shared_ptr<const CryptoHelper> load_key(const std::string &private_key_pem) {
+	StageTimer timer(Stage::KEY_LOAD);
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKey(private_key_pem);
+	return shared_ptr<const CryptoHelper>(crypto.release());
+}
+
+ProjectContext::ProjectContext(const std::string &project_name, const std::string &private_key_pem)
+	: ProjectContext(project_name, load_key(private_key_pem)) {}
+
+shared_ptr<const CryptoHelper> ProjectContext::crypto(const std::string &private_key_file) const {
+	lock_guard<mutex> guard(m_keys_mutex);
+	auto it = m_keys.find(private_key_file);
+	if (it != m_keys.end()) {
+		Metrics::add(Counter::KEY_CACHE_HITS);
+		return it->second;
+	}
+	Metrics::add(Counter::KEY_CACHE_MISSES);
+	shared_ptr<const CryptoHelper> shared;
+	if (m_keystore && private_key_file == m_private_key_file) {
+		const size_t index = m_keystore->find(m_default_features);
+		if (index == Keystore::NOT_FOUND) {
+			throw logic_error("Project " + m_default_features + " is not in the keystore");
+		}
+		shared = m_keystore->key(index);
+	} else {
+		StageTimer timer(Stage::KEY_LOAD);
+		unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+		crypto->loadPrivateKey_file(private_key_file);
+		shared.reset(crypto.release());
+	}
+	m_keys[private_key_file] = shared;
+	return shared;
+}
+
+} /* namespace license */
@@ -0,0 +1,94 @@
+/*
+ * project_context.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_PROJECT_CONTEXT_HPP_
+#define SRC_LICENSE_GENERATOR_PROJECT_CONTEXT_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../base_lib/crypto_helper.hpp"
+#include "keystore.hpp"
+#include "license_index.hpp"
+#include "license_layout.hpp"
+#include "license_ledger.hpp"
+
+namespace license {
+
+/**
+ * State of a project shared by all the licenses issued for it: canonical project folder, default features and
+ * private keys.
+ *
+ * <p>It is resolved once and then borrowed by many License objects, so that issuing many licenses doesn't repeat
+ * the file system checks and the key parsing for every license. Keys are loaded on first use and cached, it's safe
+ * to use the same context from multiple threads.</p>
+ */
+class ProjectContext {
+private:
+	const std::string m_project_folder;
+	const std::string m_default_features;
+	const std::string m_private_key_file;
+	// if set, the default key is taken from here instead of private_key_file
+	const std::shared_ptr<const Keystore> m_keystore;
+	mutable std::mutex m_keys_mutex;
+	mutable std::map<std::string, std::shared_ptr<const CryptoHelper>> m_keys;
+	mutable DirectoryCache m_directories;
+	// null for in memory projects
+	const std::unique_ptr<LicenseIndex> m_license_index;
+	const std::unique_ptr<LicenseLedger> m_ledger;
+
+public:
+	/**
+	 * @param project_folder
+	 * 			folder of the project. It must exist.
+	 */
+	explicit ProjectContext(const std::string &project_folder);
+	/**
+	 * Project whose default key is in a keystore, under the project name, instead of the project folder.
+	 * @throws logic_error (when the key is first used) if the project is not in the keystore.
+	 */
+	ProjectContext(const std::string &project_folder, const std::shared_ptr<const Keystore> &keystore);
+	/**
+	 * Context of a project that doesn't exist on disk, to issue licenses in memory.
+	 * @param project_name
+	 * 			name of the project, it is the default feature.
+	 * @param private_key
+	 * 			key used to sign the licenses.
+	 */
+	ProjectContext(const std::string &project_name, const std::shared_ptr<const CryptoHelper> &private_key);
+	/**
+	 * @param private_key_pem
+	 * 			private key in pkcs#1 PEM format (the content of private_key.rsa).
+	 */
+	ProjectContext(const std::string &project_name, const std::string &private_key_pem);
+	ProjectContext(const ProjectContext &) = delete;
+	ProjectContext &operator=(const ProjectContext &) = delete;
+
+	// canonical path of the project folder, empty for in memory projects
+	inline const std::string &project_folder() const { return m_project_folder; }
+	// features issued when none is specified: the project name
+	inline const std::string &default_features() const { return m_default_features; }
+	// default private key of the project, empty for in memory projects
+	inline const std::string &private_key_file() const { return m_private_key_file; }
+	/**
+	 * Return the key stored in private_key_file, loading it the first time.
+	 */
+	std::shared_ptr<const CryptoHelper> crypto(const std::string &private_key_file) const;
+	inline std::shared_ptr<const CryptoHelper> crypto() const { return crypto(m_private_key_file); }
+	// folders where licenses of this project have been written in this run
+	inline DirectoryCache &directories() const { return m_directories; }
+	// index of the licenses of the project, nullptr for in memory projects
+	inline LicenseIndex *license_index() const { return m_license_index.get(); }
+	// ledger of the sections issued for the project, nullptr for in memory projects
+	inline LicenseLedger *ledger() const { return m_ledger.get(); }
+	virtual ~ProjectContext() {}
+};
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_PROJECT_CONTEXT_HPP_ */
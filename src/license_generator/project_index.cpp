@@ -0,0 +1,221 @@
+/*
+ * project_index.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#define SI_SUPPORT_IOSTREAMS
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#include "../base_lib/base.h"
+#include "../base_lib/crypto_helper.hpp"
+#include "../ini/SimpleIni.h"
+#include "atomic_file.hpp"
+#include "file_lock.hpp"
+#include "project_index.hpp"
+
+namespace license {
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define MANIFEST_SECTION "project"
+#define INDEX_HEADER "# lcc project index 1"
+
+static const char *const INDEX_COLUMNS = "name\tkey-algorithm\tkey-fingerprint\tcreated\ttemplates\tartifacts";
+
+const std::string manifest_timestamp(std::time_t time) {
+	struct tm utc;
+#ifdef _WIN32
+	gmtime_s(&utc, &time);
+#else
+	gmtime_r(&time, &utc);
+#endif
+	char buffer[32];
+	strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+	return buffer;
+}
+
+void write_manifest(const std::string &project_folder, const ProjectManifest &manifest) {
+	CSimpleIniA ini;
+	ini.SetValue(MANIFEST_SECTION, "name", manifest.name.c_str());
+	ini.SetValue(MANIFEST_SECTION, "key-algorithm", manifest.key_algorithm.c_str());
+	ini.SetValue(MANIFEST_SECTION, "key-fingerprint", manifest.key_fingerprint.c_str());
+	ini.SetValue(MANIFEST_SECTION, "created", manifest.created.c_str());
+	ini.SetValue(MANIFEST_SECTION, "templates", manifest.templates.c_str());
+	ini.SetValue(MANIFEST_SECTION, "artifacts", manifest.artifacts.c_str());
+	string content;
+	ini.Save(content, true);
+	AtomicFileWriter file_writer;
+	file_writer.write((fs::path(project_folder) / PROJECT_MANIFEST_FNAME).string(), content);
+}
+
+bool read_manifest(const std::string &project_folder, ProjectManifest &manifest) {
+	CSimpleIniA ini;
+	const string manifest_file = (fs::path(project_folder) / PROJECT_MANIFEST_FNAME).string();
+	if (ini.LoadFile(manifest_file.c_str()) != SI_OK) {
+		return false;
+	}
+	if (ini.GetSectionSize(MANIFEST_SECTION) <= 0) {
+		throw runtime_error("[" + manifest_file + "] is not a project manifest");
+	}
+	manifest.name = ini.GetValue(MANIFEST_SECTION, "name", "");
+	manifest.key_algorithm = ini.GetValue(MANIFEST_SECTION, "key-algorithm", "");
+	manifest.key_fingerprint = ini.GetValue(MANIFEST_SECTION, "key-fingerprint", "");
+	manifest.created = ini.GetValue(MANIFEST_SECTION, "created", "");
+	manifest.templates = ini.GetValue(MANIFEST_SECTION, "templates", "");
+	manifest.artifacts = ini.GetValue(MANIFEST_SECTION, "artifacts", "");
+	return true;
+}
+
+static const string index_file(const string &projects_folder) {
+	return (fs::path(projects_folder) / PROJECT_INDEX_FNAME).string();
+}
+
+static const string index_lock_file(const string &projects_folder) {
+	if (!fs::is_directory(projects_folder)) {
+		throw logic_error("Path " + projects_folder + " doesn't exist or is not a directory.");
+	}
+	return (fs::path(projects_folder) / PROJECT_INDEX_LOCK_FNAME).string();
+}
+
+static bool by_name(const ProjectManifest &a, const ProjectManifest &b) { return a.name < b.name; }
+
+static void write_index(const string &projects_folder, vector<ProjectManifest> &projects) {
+	sort(projects.begin(), projects.end(), by_name);
+	string content(INDEX_HEADER "\n");
+	content.append(INDEX_COLUMNS).append("\n");
+	for (const auto &project : projects) {
+		const string fields[] = {project.name,	  project.key_algorithm, project.key_fingerprint,
+								 project.created, project.templates,	 project.artifacts};
+		for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+			if (fields[i].find_first_of("\t\r\n") != string::npos) {
+				throw invalid_argument("project [" + project.name + "] can't be indexed: tab or new line in its " +
+									   "manifest");
+			}
+			content.append(i == 0 ? "" : "\t").append(fields[i]);
+		}
+		content.append("\n");
+	}
+	AtomicFileWriter file_writer;
+	file_writer.write(index_file(projects_folder), content);
+}
+
+// index loaded from disk, false if it doesn't exist. The file is read at once and split in place.
+static bool read_index(const string &projects_folder, vector<ProjectManifest> &projects) {
+	ifstream index(index_file(projects_folder), ios::binary);
+	if (!index.is_open()) {
+		return false;
+	}
+	const string content((istreambuf_iterator<char>(index)), istreambuf_iterator<char>());
+	const size_t header_end = content.find('\n');
+	if (content.compare(0, header_end, INDEX_HEADER) != 0) {
+		throw runtime_error("[" + index_file(projects_folder) + "] is not a project index, use project list --rebuild");
+	}
+	// skip the column names
+	size_t line = content.find('\n', header_end + 1);
+	line = line == string::npos ? content.size() : line + 1;
+	projects.reserve(count(content.begin() + line, content.end(), '\n'));
+	while (line < content.size()) {
+		size_t end = content.find('\n', line);
+		if (end == string::npos) end = content.size();
+		if (end > line) {
+			ProjectManifest project;
+			string *const fields[] = {&project.name,	&project.key_algorithm, &project.key_fingerprint,
+									  &project.created, &project.templates,		&project.artifacts};
+			size_t field_start = line;
+			for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]) && field_start <= end; i++) {
+				size_t field_end = content.find('\t', field_start);
+				if (field_end == string::npos || field_end > end) field_end = end;
+				fields[i]->assign(content, field_start, field_end - field_start);
+				field_start = field_end + 1;
+			}
+			projects.push_back(std::move(project));
+		}
+		line = end + 1;
+	}
+	return true;
+}
+
+// serializes the threads, the lock file serializes the processes
+static mutex index_mutex;
+
+static vector<ProjectManifest> scan_projects(const string &projects_folder) {
+	vector<ProjectManifest> projects;
+	if (!fs::is_directory(projects_folder)) {
+		throw logic_error("Path " + projects_folder + " doesn't exist or is not a directory.");
+	}
+	for (fs::directory_iterator it(projects_folder); it != fs::directory_iterator(); ++it) {
+		if (!fs::is_directory(it->status())) {
+			continue;
+		}
+		const string project_folder = it->path().string();
+		ProjectManifest manifest;
+		if (read_manifest(project_folder, manifest)) {
+			projects.push_back(manifest);
+			continue;
+		}
+		const fs::path private_key(it->path() / PRIVATE_KEY_FNAME);
+		if (fs::is_regular_file(private_key)) {
+			// project initialized before manifests existed
+			unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+			crypto->loadPrivateKey_file(private_key.string());
+			manifest.name = it->path().filename().string();
+			manifest.key_algorithm = PROJECT_KEY_ALGORITHM;
+			manifest.key_fingerprint = crypto->publicKeyFingerprint();
+			manifest.created = manifest_timestamp(fs::last_write_time(private_key));
+			write_manifest(project_folder, manifest);
+			projects.push_back(manifest);
+		}
+	}
+	return projects;
+}
+
+std::vector<ProjectManifest> rebuild_project_index(const std::string &projects_folder) {
+	lock_guard<mutex> guard(index_mutex);
+	FileLock lock(index_lock_file(projects_folder));
+	vector<ProjectManifest> projects = scan_projects(projects_folder);
+	write_index(projects_folder, projects);
+	return projects;
+}
+
+std::vector<ProjectManifest> load_project_index(const std::string &projects_folder) {
+	{
+		lock_guard<mutex> guard(index_mutex);
+		vector<ProjectManifest> projects;
+		if (read_index(projects_folder, projects)) {
+			return projects;
+		}
+	}
+	return rebuild_project_index(projects_folder);
+}
+
+void update_project_index(const std::string &projects_folder, const std::vector<ProjectManifest> &projects) {
+	lock_guard<mutex> guard(index_mutex);
+	// the index is read and written again holding the lock, or concurrent updates would lose each other's projects
+	FileLock lock(index_lock_file(projects_folder));
+	vector<ProjectManifest> indexed;
+	if (!read_index(projects_folder, indexed)) {
+		// the first index of the folder: the new projects have their manifest already.
+		indexed = scan_projects(projects_folder);
+	}
+	map<string, ProjectManifest> by_project;
+	for (const auto &project : indexed) {
+		by_project[project.name] = project;
+	}
+	for (const auto &project : projects) {
+		by_project[project.name] = project;
+	}
+	indexed.clear();
+	for (const auto &it : by_project) {
+		indexed.push_back(it.second);
+	}
+	write_index(projects_folder, indexed);
+}
+
+} /* namespace license */
@@ -0,0 +1,82 @@
+/*
+ * project_index.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SRC_LICENSE_GENERATOR_PROJECT_INDEX_HPP_
+#define SRC_LICENSE_GENERATOR_PROJECT_INDEX_HPP_
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace license {
+
+/**
+ * Manifest of a project, in the project folder.
+ */
+#define PROJECT_MANIFEST_FNAME "project.ini"
+/**
+ * Index of all the projects of a projects folder.
+ */
+#define PROJECT_INDEX_FNAME ".lcc_projects"
+/**
+ * Locked by the processes updating the index. It is never replaced, so it can be locked while the index is rewritten.
+ */
+#define PROJECT_INDEX_LOCK_FNAME ".lcc_projects.lock"
+/**
+ * Keys generated by CryptoHelper
+ */
+#define PROJECT_KEY_ALGORITHM "RSA-1024"
+
+/**
+ * Description of a project, written by Project::initialize. It allows to list the projects without opening their
+ * keys.
+ */
+struct ProjectManifest {
+	std::string name;
+	std::string key_algorithm;
+	// see CryptoHelper::publicKeyFingerprint()
+	std::string key_fingerprint;
+	// creation time, ISO 8601 UTC
+	std::string created;
+	// templates folder the public key artifacts were rendered from
+	std::string templates;
+	// comma separated names of the rendered artifacts
+	std::string artifacts;
+};
+
+/**
+ * Format a time as ISO 8601 UTC, eg. 2026-10-19T08:30:00Z
+ */
+const std::string manifest_timestamp(std::time_t time);
+
+/**
+ * Write (atomically) the manifest of a project.
+ * @param project_folder
+ * 			folder of the project (projects folder/project name)
+ */
+void write_manifest(const std::string &project_folder, const ProjectManifest &manifest);
+/**
+ * @return false if the project has no manifest.
+ */
+bool read_manifest(const std::string &project_folder, ProjectManifest &manifest);
+
+/**
+ * Projects of a projects folder, sorted by name. The index of the folder is built if it doesn't exist.
+ */
+std::vector<ProjectManifest> load_project_index(const std::string &projects_folder);
+/**
+ * Add (or replace) some projects in the index of a projects folder. Updates from the same process are serialized.
+ */
+void update_project_index(const std::string &projects_folder, const std::vector<ProjectManifest> &projects);
+/**
+ * Build the index of a projects folder again from the manifests of its projects. Projects created before the
+ * manifests existed (they only have a private key) get their manifest: this is the only time their keys are read.
+ */
+std::vector<ProjectManifest> rebuild_project_index(const std::string &projects_folder);
+
+} /* namespace license */
+
+#endif /* SRC_LICENSE_GENERATOR_PROJECT_INDEX_HPP_ */
@@ -0,0 +1,95 @@
+#define BOOST_TEST_MODULE test_allocations
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <build_properties.h>
+
+#include "../src/base_lib/base.h"
+#include "../src/base_lib/base64.h"
+#include "../src/base_lib/crypto_helper.hpp"
+#include "../src/license_generator/license.hpp"
+#include "../src/license_generator/project_context.hpp"
+#include "allocation_tracker.hpp"
+
+/**
+ * Allocation budgets of the license issuing hot path. A budget failing means new heap allocations were added to the
+ * path: avoid them, or raise the budget if they are worth it. The budgets include the allocations of OpenSSL 3, that
+ * depend on its version: they leave some room over the counts measured.
+ */
+namespace license {
+namespace test {
+using namespace std;
+
+// signing a section with the 1024 bit test key
+static const size_t SIGN_STRING_BUDGET = 55;
+// a license with three sections, all of them signed
+static const size_t WRITE_LICENSE_BUDGET = 3 * SIGN_STRING_BUDGET + 120;
+
+static const string private_key() {
+	ifstream stream(string(PROJECT_TEST_SRC_DIR) + "/data/" PRIVATE_KEY_FNAME, ios::binary);
+	return string((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+}
+
+static void issue(License &license, const string &client_signature, string &buffer) {
+	license.reset(nullptr);
+	license.add_parameter(PARAM_FEATURE_NAMES, "f1,f2,f3");
+	license.add_parameter(PARAM_CLIENT_SIGNATURE, client_signature);
+	license.add_parameter(PARAM_EXPIRY_DATE, "2030-01-31");
+	license.add_parameter(PARAM_EXTRA_DATA, "customer=ACME");
+	license.write_license(buffer);
+}
+
+BOOST_AUTO_TEST_CASE(tracker_counts) {
+	AllocationTracker tracker;
+	unique_ptr<vector<int>> numbers(new vector<int>(10));
+	BOOST_CHECK_EQUAL(tracker.allocations(), 2);
+	BOOST_CHECK_EQUAL(tracker.bytes(), sizeof(vector<int>) + 10 * sizeof(int));
+	{
+		AllocationTracker nested;
+		numbers->reserve(100);
+		BOOST_CHECK_EQUAL(nested.allocations(), 1);
+	}
+	BOOST_CHECK_EQUAL(tracker.allocations(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(base64_single_allocation) {
+	const vector<unsigned char> data(4096, 0x5a);
+	for (const int line_length : {-1, 65}) {
+		AllocationTracker tracker;
+		const string encoded = base64(data.data(), data.size(), line_length);
+		BOOST_CHECK_EQUAL(tracker.allocations(), 1);
+		BOOST_CHECK_LE(tracker.bytes(), encoded.size() + 8);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(sign_string_budget) {
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKey(private_key());
+	const string text(1024, 'x');
+	crypto->signString(text);
+	AllocationTracker tracker;
+	const string signature = crypto->signString(text);
+	BOOST_TEST_MESSAGE("signString: " << tracker.allocations() << " allocations, " << tracker.bytes() << " bytes"
+									  << (AllocationTracker::counts_openssl() ? "" : " (OpenSSL not counted)"));
+	BOOST_CHECK(!signature.empty());
+	BOOST_CHECK_LE(tracker.allocations(), SIGN_STRING_BUDGET);
+}
+
+BOOST_AUTO_TEST_CASE(write_license_budget) {
+	const ProjectContext project("TEST", private_key());
+	License license(project, nullptr);
+	string buffer;
+	issue(license, "AAAA-BBBB-0000", buffer);
+	AllocationTracker tracker;
+	issue(license, "AAAA-BBBB-0001", buffer);
+	BOOST_TEST_MESSAGE("write_license: " << tracker.allocations() << " allocations, " << tracker.bytes() << " bytes");
+	BOOST_CHECK_EQUAL(license.signed_sections(), 3);
+	BOOST_CHECK_LE(tracker.allocations(), WRITE_LICENSE_BUDGET);
+}
+
+}  // namespace test
+}  // namespace license
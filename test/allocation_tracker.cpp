@@ -0,0 +1,76 @@
+/*
+ * allocation_tracker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdlib>
+#include <new>
+#ifdef HAS_OPENSSL
+#include <openssl/crypto.h>
+#endif
+
+#include "allocation_tracker.hpp"
+
+namespace license {
+namespace test {
+
+static thread_local size_t allocation_count = 0;
+static thread_local size_t allocated_bytes = 0;
+
+static void *counted_malloc(size_t size) {
+	allocation_count++;
+	allocated_bytes += size;
+	// malloc(0) may return nullptr, which operator new can't
+	return malloc(size == 0 ? 1 : size);
+}
+
+#ifdef HAS_OPENSSL
+static void *openssl_malloc(size_t size, const char *, int) { return counted_malloc(size); }
+
+static void *openssl_realloc(void *ptr, size_t size, const char *, int) {
+	allocation_count++;
+	allocated_bytes += size;
+	return realloc(ptr, size);
+}
+
+static void openssl_free(void *ptr, const char *, int) { free(ptr); }
+
+// installed before main, when OpenSSL hasn't allocated anything yet
+static const bool openssl_counted = CRYPTO_set_mem_functions(openssl_malloc, openssl_realloc, openssl_free) == 1;
+#else
+static const bool openssl_counted = false;
+#endif
+
+AllocationTracker::AllocationTracker() : m_allocations_start(allocation_count), m_bytes_start(allocated_bytes) {}
+
+size_t AllocationTracker::allocations() const { return allocation_count - m_allocations_start; }
+
+size_t AllocationTracker::bytes() const { return allocated_bytes - m_bytes_start; }
+
+bool AllocationTracker::counts_openssl() { return openssl_counted; }
+
+}  // namespace test
+}  // namespace license
+
+void *operator new(size_t size) {
+	void *ptr = license::test::counted_malloc(size);
+	if (ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return license::test::counted_malloc(size); }
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return license::test::counted_malloc(size); }
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete[](void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { free(ptr); }
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { free(ptr); }
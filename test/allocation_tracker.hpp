@@ -0,0 +1,41 @@
+/*
+ * allocation_tracker.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TEST_ALLOCATION_TRACKER_HPP_
+#define TEST_ALLOCATION_TRACKER_HPP_
+
+#include <cstddef>
+
+namespace license {
+namespace test {
+
+/**
+ * Counts the heap allocations made by the current thread while it is alive.
+ *
+ * <p>Linking allocation_tracker.cpp replaces the global operator new and delete of the test executable. When OpenSSL
+ * is used its allocator is replaced as well, so the memory allocated by OpenSSL (keys, digest contexts, BIO buffers)
+ * is counted too. Reallocations count as allocations of their new size. Trackers can be nested: each one counts the
+ * allocations made since it was created.</p>
+ */
+class AllocationTracker {
+private:
+	const size_t m_allocations_start;
+	const size_t m_bytes_start;
+
+public:
+	AllocationTracker();
+	AllocationTracker(const AllocationTracker &) = delete;
+	AllocationTracker &operator=(const AllocationTracker &) = delete;
+	size_t allocations() const;
+	size_t bytes() const;
+	// false if OpenSSL allocated memory before its allocator could be replaced
+	static bool counts_openssl();
+};
+
+}  // namespace test
+}  // namespace license
+
+#endif /* TEST_ALLOCATION_TRACKER_HPP_ */
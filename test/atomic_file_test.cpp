@@ -0,0 +1,113 @@
+#define BOOST_TEST_MODULE test_atomic_file
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/atomic_file.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const string read_file(const fs::path& fname) {
+	ifstream is(fname.string(), ios::binary);
+	return string((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+}
+
+static size_t count_files(const fs::path& folder) {
+	size_t count = 0;
+	for (fs::directory_iterator it(folder); it != fs::directory_iterator(); ++it) {
+		count++;
+	}
+	return count;
+}
+
+static const fs::path clean_folder(const string& name) {
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / name);
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	return folder;
+}
+
+BOOST_AUTO_TEST_CASE(immediate_write_replaces_file) {
+	const fs::path folder = clean_folder("atomic_immediate");
+	const fs::path target = folder / "test.lic";
+	AtomicFileWriter writer;
+	writer.write(target.string(), string("first version, longer than the second"));
+	BOOST_CHECK_EQUAL(read_file(target), "first version, longer than the second");
+	writer.write(target.string(), string("second"));
+	BOOST_CHECK_EQUAL(read_file(target), "second");
+	BOOST_CHECK_EQUAL(writer.pending(), 0);
+	BOOST_CHECK_EQUAL(writer.commit_stats().commits, 2);
+	BOOST_CHECK_EQUAL(writer.commit_stats().files, 2);
+	BOOST_CHECK_MESSAGE(count_files(folder) == 1, "no temporary files are left behind");
+}
+
+BOOST_AUTO_TEST_CASE(group_commit) {
+	const fs::path folder = clean_folder("atomic_group");
+	{
+		AtomicFileWriter writer(4);
+		for (int i = 0; i < 10; i++) {
+			writer.write((folder / (to_string(i) + ".lic")).string(), to_string(i));
+		}
+		BOOST_CHECK_EQUAL(writer.commit_stats().commits, 2);
+		BOOST_CHECK_EQUAL(writer.commit_stats().files, 8);
+		BOOST_CHECK_EQUAL(writer.pending(), 2);
+		BOOST_CHECK_MESSAGE(!fs::exists(folder / "9.lic"), "pending files are not visible before commit");
+		BOOST_CHECK(writer.is_pending((folder / "9.lic").string()));
+		writer.commit();
+		BOOST_CHECK_EQUAL(writer.commit_stats().commits, 3);
+		BOOST_CHECK_EQUAL(writer.commit_stats().files, 10);
+		BOOST_CHECK_EQUAL(writer.commit_stats().directories, 3);
+	}
+	BOOST_CHECK_EQUAL(count_files(folder), 10);
+	BOOST_CHECK_EQUAL(read_file(folder / "9.lic"), "9");
+}
+
+BOOST_AUTO_TEST_CASE(group_commit_same_file_twice) {
+	const fs::path folder = clean_folder("atomic_twice");
+	const fs::path target = folder / "test.lic";
+	AtomicFileWriter writer(100);
+	writer.write(target.string(), string("one"));
+	writer.write(target.string(), string("two"));
+	BOOST_CHECK_EQUAL(read_file(target), "one");
+	writer.commit();
+	BOOST_CHECK_EQUAL(read_file(target), "two");
+	BOOST_CHECK_EQUAL(count_files(folder), 1);
+}
+
+BOOST_AUTO_TEST_CASE(failed_commit_keeps_only_unrenamed_files) {
+	const fs::path folder = clean_folder("atomic_failed");
+	{
+		AtomicFileWriter writer(100);
+		writer.write((folder / "a.lic").string(), string("a"));
+		// the target of b.lic is a non empty folder: it can't be replaced
+		fs::create_directories(folder / "b.lic" / "child");
+		writer.write((folder / "b.lic").string(), string("b"));
+		writer.write((folder / "c.lic").string(), string("c"));
+		BOOST_CHECK_THROW(writer.commit(), runtime_error);
+		BOOST_CHECK(!writer.is_pending((folder / "a.lic").string()));
+		BOOST_CHECK(writer.is_pending((folder / "b.lic").string()));
+		BOOST_CHECK_EQUAL(read_file(folder / "a.lic"), "a");
+		fs::remove_all(folder / "b.lic");
+	}
+	BOOST_CHECK_EQUAL(read_file(folder / "b.lic"), "b");
+	BOOST_CHECK_EQUAL(read_file(folder / "c.lic"), "c");
+}
+
+BOOST_AUTO_TEST_CASE(commit_on_destruction) {
+	const fs::path folder = clean_folder("atomic_destruction");
+	{
+		AtomicFileWriter writer(100, 60000);
+		writer.write((folder / "a.lic").string(), string("a"));
+	}
+	BOOST_CHECK_EQUAL(read_file(folder / "a.lic"), "a");
+}
+
+}  // namespace test
+}  // namespace license
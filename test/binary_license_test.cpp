@@ -0,0 +1,120 @@
+#define BOOST_TEST_MODULE test_binary_license
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <build_properties.h>
+
+#include "../src/base_lib/base.h"
+#include "../src/license_generator/binary_license.hpp"
+#include "../src/license_generator/license.hpp"
+#include "../src/license_generator/project_context.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static LicenseSection section(const string& name, const vector<LicenseField>& fields) {
+	LicenseSection result;
+	result.name = name;
+	result.fields = fields;
+	return result;
+}
+
+BOOST_AUTO_TEST_CASE(values_round_trip) {
+	const vector<LicenseSection> sections = {
+		section("PROJECT", {{LICENSE_VERSION, "200"},
+							{PARAM_EXPIRY_DATE, "2030-01-31"},
+							{PARAM_CLIENT_SIGNATURE, "AAAA-BBBB"},
+							{"custom", "4294967295"},
+							{LICENSE_SIGNATURE, "c2lnbmF0dXJl"}}),
+		// values that look typed but can't be stored as such without changing their text
+		section("ODD", {{PARAM_VERSION_FROM, "007"},
+						{PARAM_BEGIN_DATE, "2030-1-1"},
+						{"big", "4294967296"},
+						{LICENSE_SIGNATURE, "not base64!"},
+						{"empty", ""}}),
+		section("EMPTY", {})};
+	string binary;
+	encode_binary_license(sections, binary);
+	BOOST_CHECK(is_binary_license(binary.data(), binary.size()));
+	vector<LicenseSection> decoded;
+	decode_binary_license(binary.data(), binary.size(), decoded);
+	BOOST_REQUIRE_EQUAL(decoded.size(), sections.size());
+	for (size_t s = 0; s < sections.size(); s++) {
+		BOOST_CHECK_EQUAL(decoded[s].name, sections[s].name);
+		BOOST_REQUIRE_EQUAL(decoded[s].fields.size(), sections[s].fields.size());
+		for (size_t f = 0; f < sections[s].fields.size(); f++) {
+			BOOST_CHECK_EQUAL(decoded[s].fields[f].key, sections[s].fields[f].key);
+			BOOST_CHECK_EQUAL(decoded[s].fields[f].value, sections[s].fields[f].value);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_license) {
+	string binary;
+	encode_binary_license({section("PROJECT", {{LICENSE_VERSION, "200"}, {"key", "value"}})}, binary);
+	vector<LicenseSection> decoded;
+	// truncated (the size in the header is fixed to match, to reach the section parsing)
+	for (size_t size = 12; size < binary.size(); size++) {
+		string truncated = binary.substr(0, size);
+		truncated[8] = (char)size;
+		BOOST_CHECK_THROW(decode_binary_license(truncated.data(), truncated.size(), decoded), runtime_error);
+	}
+	string wrong_version(binary);
+	wrong_version[4] = 9;
+	BOOST_CHECK_THROW(decode_binary_license(wrong_version.data(), wrong_version.size(), decoded), runtime_error);
+	BOOST_CHECK(!is_binary_license("[PROJECT]\nkey=value\n", 20));
+	BOOST_CHECK_THROW(encode_binary_license({section("PROJECT", {{"key", string(70000, 'x')}})}, binary),
+					  invalid_argument);
+}
+
+/**
+ * A license issued in binary format has the same signatures of the same license issued as INI, and it converts to
+ * the same INI license.
+ */
+BOOST_AUTO_TEST_CASE(signatures_independent_of_format) {
+	ifstream key_file((fs::path(PROJECT_TEST_SRC_DIR) / "data" / PRIVATE_KEY_FNAME).string());
+	const string private_key((istreambuf_iterator<char>(key_file)), istreambuf_iterator<char>());
+	const ProjectContext project("BINARY_PROJECT", private_key);
+	License license(project, nullptr);
+	string ini, binary;
+	for (const LicenseFormat format : {LicenseFormat::INI, LicenseFormat::BINARY}) {
+		license.reset(nullptr);
+		license.set_format(format);
+		license.add_parameter(PARAM_FEATURE_NAMES, "f1,f2");
+		license.add_parameter(PARAM_EXPIRY_DATE, "2030-01-31");
+		license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB");
+		license.write_license(format == LicenseFormat::INI ? ini : binary);
+	}
+	BOOST_CHECK(is_binary_license(binary.data(), binary.size()));
+	BOOST_CHECK_MESSAGE(binary.size() < ini.size() * 3 / 4, to_string(binary.size()) + " vs " + to_string(ini.size()));
+	vector<SectionVerification> sections;
+	BOOST_REQUIRE(License::verify(binary.data(), binary.size(), *project.crypto(), sections));
+	BOOST_REQUIRE_EQUAL(sections.size(), 2);
+	BOOST_CHECK_EQUAL(sections[1].feature, "F2");
+	BOOST_CHECK(sections[0].status == SignatureStatus::VALID && sections[1].status == SignatureStatus::VALID);
+
+	// RSA PKCS#1 v1.5 signatures are deterministic: same text, same signature
+	string converted;
+	License::convert(binary.data(), binary.size(), LicenseFormat::INI, converted);
+	BOOST_CHECK_EQUAL(converted, ini);
+	License::convert(ini.data(), ini.size(), LicenseFormat::BINARY, converted);
+	BOOST_CHECK(converted == binary);
+
+	// a binary license is extended as a binary license
+	const string previous(binary);
+	license.reset(nullptr);
+	license.add_parameter(PARAM_FEATURE_NAMES, "f3");
+	license.write_license(binary, &previous);
+	BOOST_REQUIRE(License::verify(binary.data(), binary.size(), *project.crypto(), sections));
+	BOOST_CHECK_EQUAL(sections.size(), 3);
+	BOOST_CHECK_EQUAL(license.signed_sections(), 1);
+}
+
+}  // namespace test
+}  // namespace license
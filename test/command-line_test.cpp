@@ -1,5 +1,7 @@
 #define BOOST_TEST_MODULE test_command_line
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <fstream>
 #include <boost/test/unit_test.hpp>
@@ -13,9 +15,13 @@
 #include <iostream>
 
 #include <build_properties.h>
+#include "../src/license_generator/binary_license.hpp"
 #include "../src/license_generator/command_line-parser.hpp"
+#include "../src/license_generator/license_layout.hpp"
+#include "../src/license_generator/project_index.hpp"
 #include "../src/ini/SimpleIni.h"
 #include "../src/base_lib/base.h"
+#include "../src/base_lib/crypto_helper.hpp"
 #include "cout_redirect.hpp"
 
 namespace fs = boost::filesystem;
@@ -52,6 +58,29 @@ static void create_project(const fs::path& projects_folder, const fs::path& expe
 	BOOST_CHECK_MESSAGE(fs::exists(expected_public_key), "Public key " + expected_public_key.string() + " created.");
 }
 
+static vector<string> read_lines(const fs::path& file) {
+	ifstream input(file.string());
+	vector<string> lines;
+	string line;
+	while (getline(input, line)) {
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+static int run_quiet(vector<const char*> argv, string* out = nullptr) {
+	boost::test_tools::output_test_stream output;
+	int result;
+	{
+		cout_redirect guard(output.rdbuf());
+		result = CommandLineParser::parseCommandLine((int)argv.size(), argv.data());
+	}
+	if (out != nullptr) {
+		*out = output.str();
+	}
+	return result;
+}
+
 BOOST_AUTO_TEST_CASE(product_initialize_issue_license) {
 	const string project_name("TEST");
 	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
@@ -123,6 +152,654 @@ BOOST_AUTO_TEST_CASE(product_initialize_issue_license_multi_feature) {
 }
 #endif
 
+BOOST_AUTO_TEST_CASE(issue_license_batch) {
+	const string project_name("TEST_BATCH");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_batch");
+	const fs::path expected_project_folder(projects_folder / project_name);
+	const fs::path expectedPrivateKey(projects_folder / project_name / PRIVATE_KEY_FNAME);
+	const fs::path expected_public_key(projects_folder / project_name / "include" / "licensecc" / project_name /
+									   PUBLIC_KEY_INC_FNAME);
+	create_project(projects_folder, expectedPrivateKey, expected_public_key, mock_source_folder, project_name);
+
+	const fs::path licenses_folder(projects_folder / "licenses");
+	const fs::path orders_file(projects_folder / "orders.tsv");
+	{
+		ofstream orders(orders_file.string());
+		orders << PARAM_LICENSE_OUTPUT "\t" PARAM_FEATURE_NAMES "\t" PARAM_EXPIRY_DATE "\t" PARAM_CLIENT_SIGNATURE << endl;
+		for (int i = 0; i < 5; i++) {
+			orders << (licenses_folder / ("client" + to_string(i) + ".lic")).string() << "\t\t2030-01-01\tAAAA-" << i
+				   << endl;
+		}
+		orders << (licenses_folder / "multi.lic").string() << "\tf1,f2\t\t" << endl;
+		orders << (licenses_folder / "wrong.lic").string() << "\t\t2030-13-01\t" << endl;
+	}
+	const string orders_str = orders_file.string();
+	const string project_folder_str = expected_project_folder.string();
+	const char* argv[] = {"lcc", "license", "batch", "-i", orders_str.c_str(), "-p", project_folder_str.c_str(),
+						  "--commit-every", "3"};
+	boost::test_tools::output_test_stream output;
+	int result;
+	{
+		cout_redirect guard(output.rdbuf());
+		result = CommandLineParser::parseCommandLine(9, argv);
+	}
+	BOOST_CHECK_EQUAL(result, 1);
+	BOOST_CHECK_MESSAGE(output.str().find("Licenses issued: 6, failed: 1") != string::npos, output.str());
+	BOOST_CHECK(!fs::exists(licenses_folder / "wrong.lic"));
+	CSimpleIniA ini;
+	ini.LoadFile((licenses_folder / "client4.lic").c_str());
+	BOOST_CHECK_EQUAL(string(ini.GetValue(project_name.c_str(), PARAM_CLIENT_SIGNATURE, "")), "AAAA-4");
+	ini.Reset();
+	ini.LoadFile((licenses_folder / "multi.lic").c_str());
+	BOOST_CHECK_EQUAL(ini.GetSectionSize("F1"), 2);
+	BOOST_CHECK_EQUAL(ini.GetSectionSize(project_name.c_str()), -1);
+
+	// the issued licenses are in the index of the project
+	const char* list_argv[] = {"lcc", "license", "list", "-p", project_folder_str.c_str(), "--expires-before",
+							   "2030-12-31"};
+	boost::test_tools::output_test_stream listing;
+	{
+		cout_redirect guard(listing.rdbuf());
+		result = CommandLineParser::parseCommandLine(7, list_argv);
+	}
+	BOOST_CHECK_EQUAL(result, 0);
+	BOOST_CHECK_MESSAGE(listing.str().find("5 licenses") != string::npos, listing.str());
+	BOOST_CHECK(listing.str().find("multi.lic") == string::npos);
+	const char* feature_argv[] = {"lcc", "license", "list", "-p", project_folder_str.c_str(), "-f", "f2"};
+	listing.str("");
+	{
+		cout_redirect guard(listing.rdbuf());
+		result = CommandLineParser::parseCommandLine(7, feature_argv);
+	}
+	BOOST_CHECK_MESSAGE(listing.str().find("F1,F2") != string::npos && listing.str().find("1 licenses") != string::npos,
+						listing.str());
+
+	// verification of the whole folder, after tampering with a license
+	const string tampered_file = (licenses_folder / "client2.lic").string();
+	string tampered;
+	{
+		ifstream input(tampered_file);
+		tampered.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+	}
+	tampered.replace(tampered.find("AAAA-2"), 6, "AAAA-9");
+	ofstream(tampered_file, ios::trunc) << tampered;
+	const string licenses_str = licenses_folder.string();
+	const char* verify_argv[] = {"lcc", "license", "verify", "-p", project_folder_str.c_str(), "-l",
+								 licenses_str.c_str(), "-j", "3"};
+	boost::test_tools::output_test_stream verification;
+	{
+		cout_redirect guard(verification.rdbuf());
+		result = CommandLineParser::parseCommandLine(9, verify_argv);
+	}
+	BOOST_CHECK_EQUAL(result, 1);
+	const string lines = verification.str();
+	BOOST_CHECK_EQUAL(count(lines.begin(), lines.end(), '\n'), 6);
+	BOOST_CHECK_MESSAGE(lines.find("client2.lic\", \"valid\": false, \"sections\": [{\"feature\": \"" + project_name +
+									   "\", \"signature\": \"invalid\"}]}") != string::npos,
+						lines);
+	BOOST_CHECK_MESSAGE(lines.find("multi.lic\", \"valid\": true, \"sections\": [{\"feature\": \"F1\", \"signature\": "
+								   "\"valid\"}, {\"feature\": \"F2\", \"signature\": \"valid\"}]}") != string::npos,
+						lines);
+	BOOST_CHECK(lines.find("client1.lic\", \"valid\": true") < lines.find("client2.lic"));
+
+	const string list_file = (projects_folder / "verify.txt").string();
+	ofstream(list_file) << (licenses_folder / "client0.lic").string() << "\n" << (licenses_folder / "missing.lic").string();
+	const char* list_verify_argv[] = {"lcc", "license", "verify", "-p", project_folder_str.c_str(), "-i",
+									  list_file.c_str()};
+	verification.str("");
+	{
+		cout_redirect guard(verification.rdbuf());
+		result = CommandLineParser::parseCommandLine(7, list_verify_argv);
+	}
+	BOOST_CHECK_EQUAL(result, 1);
+	BOOST_CHECK_MESSAGE(verification.str().find("client0.lic\", \"valid\": true") != string::npos, verification.str());
+	BOOST_CHECK_MESSAGE(verification.str().find("missing.lic\", \"valid\": false, \"error\": ") != string::npos,
+						verification.str());
+	// errors that are not parameter errors are reported
+	const string missing_orders = (projects_folder / "missing.tsv").string(),
+				 empty_orders = (projects_folder / "empty.tsv").string();
+	ofstream(empty_orders, ios::trunc);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "batch", "-i", missing_orders.c_str(), "-p",
+								 project_folder_str.c_str()}),
+					  1);
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "license", "batch", "-i", empty_orders.c_str(), "-p", project_folder_str.c_str()}), 1);
+}
+
+BOOST_AUTO_TEST_CASE(issue_license_batch_sharded) {
+	const string project_name("TEST_SHARDED");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_sharded");
+	const fs::path expected_project_folder(projects_folder / project_name);
+	const fs::path expectedPrivateKey(projects_folder / project_name / PRIVATE_KEY_FNAME);
+	const fs::path expected_public_key(projects_folder / project_name / "include" / "licensecc" / project_name /
+									   PUBLIC_KEY_INC_FNAME);
+	create_project(projects_folder, expectedPrivateKey, expected_public_key, mock_source_folder, project_name);
+
+	const fs::path licenses_folder(projects_folder / "licenses");
+	const fs::path orders_file(projects_folder / "orders.tsv");
+	{
+		ofstream orders(orders_file.string());
+		orders << PARAM_LICENSE_OUTPUT "\t" PARAM_CLIENT_SIGNATURE << endl;
+		for (int i = 0; i < 20; i++) {
+			orders << "customer" << i % 3 << "/host" << i << ".lic\tAAAA-" << i << endl;
+		}
+	}
+	const string orders_str = orders_file.string();
+	const string project_folder_str = expected_project_folder.string();
+	const string licenses_folder_str = licenses_folder.string();
+	const char* argv[] = {"lcc", "license", "batch", "-i", orders_str.c_str(), "-p", project_folder_str.c_str(),
+						  "-l", licenses_folder_str.c_str(), "--" PARAM_SHARD_FANOUT, "8"};
+	boost::test_tools::output_test_stream output;
+	int result;
+	{
+		cout_redirect guard(output.rdbuf());
+		result = CommandLineParser::parseCommandLine(11, argv);
+	}
+	BOOST_CHECK_EQUAL(result, 0);
+	BOOST_CHECK_MESSAGE(output.str().find("Licenses issued: 20, failed: 0") != string::npos, output.str());
+	BOOST_CHECK(!fs::exists(licenses_folder / "customer1"));
+	const LicenseLayout layout = LicenseLayout::open(licenses_folder_str);
+	BOOST_CHECK_EQUAL(layout.fanout(), 8);
+	BOOST_CHECK_EQUAL(layout.list().size(), 20);
+
+	// license issue finds the layout on its own
+	const char* argv_issue[] = {"lcc", "license", "issue", "-p", project_folder_str.c_str(), "-l",
+								licenses_folder_str.c_str(), "-o", "customer1/host1.lic", "-x", "more data"};
+	{
+		cout_redirect guard(output.rdbuf());
+		result = CommandLineParser::parseCommandLine(11, argv_issue);
+	}
+	BOOST_CHECK_EQUAL(result, 0);
+	CSimpleIniA ini;
+	ini.LoadFile(layout.find("customer1/host1.lic").c_str());
+	BOOST_CHECK_EQUAL(string(ini.GetValue(project_name.c_str(), PARAM_EXTRA_DATA, "")), "more data");
+	BOOST_CHECK_EQUAL(layout.list().size(), 20);
+}
+
+BOOST_AUTO_TEST_CASE(resign_after_key_rotation) {
+	const string project_name("TEST_RESIGN");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_resign");
+	const fs::path project_folder(projects_folder / project_name);
+	const fs::path private_key(project_folder / PRIVATE_KEY_FNAME);
+	create_project(projects_folder, private_key,
+				   project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME, mock_source_folder,
+				   project_name);
+	const fs::path licenses_folder(projects_folder / "licenses");
+	const fs::path orders_file(projects_folder / "orders.tsv");
+	{
+		ofstream orders(orders_file.string());
+		orders << PARAM_LICENSE_OUTPUT "\t" PARAM_FEATURE_NAMES "\t" PARAM_CLIENT_SIGNATURE << endl;
+		for (int i = 0; i < 10; i++) {
+			orders << "customer" << i % 3 << "/host" << i << ".lic\t" << (i == 0 ? "f1,f2" : "") << "\tAAAA-" << i
+				   << endl;
+		}
+	}
+	const string orders_str = orders_file.string(), project_str = project_folder.string(),
+				 licenses_str = licenses_folder.string(), projects_str = projects_folder.string(),
+				 mock_source = mock_source_folder.string();
+	BOOST_REQUIRE_EQUAL(run_quiet({"lcc", "license", "batch", "-i", orders_str.c_str(), "-p", project_str.c_str(), "-l",
+								   licenses_str.c_str(), "--" PARAM_SHARD_FANOUT, "4"}),
+						0);
+	const LicenseLayout layout = LicenseLayout::open(licenses_str);
+	const vector<string> host0_before = read_lines(layout.find("customer0/host0.lic"));
+
+	// key rotation
+	BOOST_REQUIRE_EQUAL(run_quiet({"lcc", "project", "init", "-n", project_name.c_str(), "-p", projects_str.c_str(),
+								   "-t", mock_source.c_str(), "--force"}),
+						0);
+	const vector<const char*> verify_argv = {"lcc", "license", "verify", "-p", project_str.c_str(), "-l",
+											 licenses_str.c_str()};
+	BOOST_CHECK_EQUAL(run_quiet(verify_argv), 1);
+
+	BOOST_CHECK(fs::exists(project_folder / PREVIOUS_PRIVATE_KEY_FNAME));
+
+	// a license forged in the licenses folder is not signed with the previous key
+	const string forged_file = layout.find("customer2/host5.lic");
+	const string forged = "[" + project_name + "]\n" PARAM_EXPIRY_DATE " = 2099-12-31\n" LICENSE_SIGNATURE " = AAAA\n";
+	ofstream(forged_file, ios::trunc) << forged;
+
+	// a previous run was interrupted after host0
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKey_file(private_key.string());
+	const fs::path journal_file(licenses_folder / RESIGN_JOURNAL_FNAME);
+	ofstream(journal_file.string()) << "# key " << crypto->publicKeyFingerprint() << "\ncustomer0/host0.lic\n";
+	const vector<const char*> resign_argv = {"lcc", "license", "resign", "-p", project_str.c_str(), "-l",
+											 licenses_str.c_str(), "-j", "3", "--commit-every", "4"};
+	string output;
+	BOOST_CHECK_EQUAL(run_quiet(resign_argv, &output), 1);
+	BOOST_CHECK_MESSAGE(output.find("Licenses signed again: 8, already valid: 0, done before: 1, failed: 1, "
+									"sections signed: 8,") != string::npos,
+						output);
+	BOOST_CHECK(read_lines(forged_file).size() == 3);
+	BOOST_CHECK_EQUAL(run_quiet(verify_argv, &output), 1);
+	BOOST_CHECK_MESSAGE(output.find("host0.lic\", \"valid\": false") != string::npos, output);
+	BOOST_CHECK_MESSAGE(output.find("host5.lic\", \"valid\": false") != string::npos, output);
+
+	fs::remove(forged_file);
+	fs::remove(journal_file);
+	BOOST_CHECK_EQUAL(run_quiet(resign_argv, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("Licenses signed again: 1, already valid: 8, done before: 0, failed: 0, "
+									"sections signed: 2,") != string::npos,
+						output);
+	BOOST_CHECK(!fs::exists(journal_file));
+	BOOST_CHECK_EQUAL(run_quiet(verify_argv), 0);
+	// only the signature changed
+	const vector<string> host0 = read_lines(layout.find("customer0/host0.lic"));
+	BOOST_REQUIRE_EQUAL(host0.size(), host0_before.size());
+	for (size_t i = 0; i < host0.size(); i++) {
+		if (host0[i].compare(0, 3, LICENSE_SIGNATURE) == 0) {
+			BOOST_CHECK_NE(host0[i], host0_before[i]);
+		} else {
+			BOOST_CHECK_EQUAL(host0[i], host0_before[i]);
+		}
+	}
+	// the new signatures are in the ledger
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "ledger", "find", "-p", project_str.c_str(), "-s", "AAAA-0", "--details"}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("4 sections") != string::npos, output);
+	for (const string& line : host0) {
+		if (line.compare(0, 3, LICENSE_SIGNATURE) == 0) {
+			BOOST_CHECK_MESSAGE(output.find(LICENSE_SIGNATURE "=" + line.substr(line.find('=') + 2)) != string::npos,
+								output);
+		}
+	}
+	// without the previous key nothing can be signed again
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "resign", "-p", project_str.c_str(), "-l", licenses_str.c_str(),
+								 "--previous-key", forged_file.c_str()}),
+					  1);
+	BOOST_CHECK_EQUAL(layout.list().size(), 9);
+
+	// no new rotation until the previous key is retired
+	const vector<const char*> rotate_argv = {"lcc", "project", "init", "-n", project_name.c_str(), "-p",
+											 projects_str.c_str(), "-t", mock_source.c_str(), "--force"};
+	const string key_before = read_lines(private_key.string())[1];
+	BOOST_CHECK_EQUAL(run_quiet(rotate_argv), 1);
+	BOOST_CHECK_EQUAL(read_lines(private_key.string())[1], key_before);
+	vector<const char*> retire_argv(resign_argv);
+	retire_argv.push_back("--retire-previous-key");
+	BOOST_CHECK_EQUAL(run_quiet(retire_argv), 0);
+	BOOST_CHECK(!fs::exists(project_folder / PREVIOUS_PRIVATE_KEY_FNAME));
+	BOOST_CHECK_EQUAL(run_quiet(rotate_argv), 0);
+	BOOST_CHECK(fs::exists(project_folder / PREVIOUS_PRIVATE_KEY_FNAME));
+
+	// a rotation interrupted after the private key was written is completed by the next init
+	const fs::path public_key(project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME);
+	fs::remove(public_key);
+	fs::remove(project_folder / PROJECT_MANIFEST_FNAME);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "project", "init", "-n", project_name.c_str(), "-p", projects_str.c_str(),
+								 "-t", mock_source.c_str()}),
+					  0);
+	BOOST_CHECK(fs::exists(public_key));
+	crypto->loadPrivateKey_file(private_key.string());
+	ProjectManifest manifest;
+	BOOST_REQUIRE(read_manifest(project_str, manifest));
+	BOOST_CHECK_EQUAL(manifest.key_fingerprint, crypto->publicKeyFingerprint());
+}
+
+BOOST_AUTO_TEST_CASE(initialize_project_batch) {
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_init_batch");
+	const fs::path other_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_init_batch_other");
+	fs::remove_all(projects_folder);
+	fs::remove_all(other_folder);
+	fs::create_directories(projects_folder);
+	const fs::path orders_file(projects_folder / "projects.tsv");
+	{
+		ofstream orders(orders_file.string());
+		orders << "project-name\tprojects-folder" << endl;
+		for (int i = 0; i < 8; i++) {
+			orders << "PRODUCT" << i << "\t" << endl;
+		}
+		orders << "OTHER\t" << other_folder.string() << endl;
+		orders << "PRODUCT3\t" << endl;
+		orders << "WRONG/NAME\t" << endl;
+	}
+	const string orders_str = orders_file.string();
+	const string projects_str = projects_folder.string();
+	const string mock_source = mock_source_folder.string();
+	const char* argv[] = {"lcc", "project", "init-batch", "-i", orders_str.c_str(), "-p", projects_str.c_str(),
+						  "-t", mock_source.c_str(), "-j", "4"};
+	boost::test_tools::output_test_stream output;
+	int result;
+	{
+		cout_redirect guard(output.rdbuf());
+		result = CommandLineParser::parseCommandLine(11, argv);
+	}
+	BOOST_CHECK_EQUAL(result, 1);
+	BOOST_CHECK_MESSAGE(output.str().find("Projects initialized: 9 (keys generated: 9, already existing: 0), failed: 2") !=
+							string::npos,
+						output.str());
+	for (int i = 0; i < 8; i++) {
+		const string project_name = "PRODUCT" + to_string(i);
+		BOOST_CHECK(fs::exists(projects_folder / project_name / PRIVATE_KEY_FNAME));
+		BOOST_CHECK(fs::exists(projects_folder / project_name / "include" / "licensecc" / project_name /
+							   PUBLIC_KEY_INC_FNAME));
+	}
+	BOOST_CHECK(fs::exists(other_folder / "OTHER" / PRIVATE_KEY_FNAME));
+	BOOST_CHECK_EQUAL(load_project_index(projects_str).size(), 8);
+	BOOST_CHECK_EQUAL(load_project_index(other_folder.string()).size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(list_projects) {
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_list");
+	fs::remove_all(projects_folder);
+	const string projects_str = projects_folder.string();
+	const string mock_source = mock_source_folder.string();
+	for (const char* name : {"BETA", "ALPHA", "LEGACY"}) {
+		const char* argv[] = {"lcc", "project", "init", "-n", name, "-p", projects_str.c_str(), "-t",
+							  mock_source.c_str()};
+		BOOST_REQUIRE_EQUAL(CommandLineParser::parseCommandLine(9, argv), 0);
+	}
+	// a project created before manifests existed
+	fs::remove(projects_folder / "LEGACY" / PROJECT_MANIFEST_FNAME);
+	fs::remove(projects_folder / PROJECT_INDEX_FNAME);
+
+	const char* argv[] = {"lcc", "project", "list", "-p", projects_str.c_str()};
+	boost::test_tools::output_test_stream output;
+	int result;
+	{
+		cout_redirect guard(output.rdbuf());
+		result = CommandLineParser::parseCommandLine(5, argv);
+	}
+	BOOST_CHECK_EQUAL(result, 0);
+	const string listing = output.str();
+	BOOST_CHECK_MESSAGE(listing.find("3 projects") != string::npos, listing);
+	const size_t alpha = listing.find("ALPHA"), beta = listing.find("BETA"), legacy = listing.find("LEGACY");
+	BOOST_CHECK_MESSAGE(alpha != string::npos && alpha < beta && beta < legacy, listing);
+	BOOST_CHECK(listing.find(PROJECT_KEY_ALGORITHM) != string::npos);
+	BOOST_CHECK(fs::exists(projects_folder / "LEGACY" / PROJECT_MANIFEST_FNAME));
+	BOOST_CHECK(fs::exists(projects_folder / PROJECT_INDEX_FNAME));
+}
+
+BOOST_AUTO_TEST_CASE(test_sign_payload_file) {
+	const string key_file = (fs::path(PROJECT_TEST_SRC_DIR) / "data" / "private_key.rsa").string();
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_test_sign");
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	vector<string> payloads;
+	for (int i = 0; i < 100; i++) {
+		payloads.push_back("payload " + to_string(i));
+	}
+	payloads[7] = "";
+	const string lines_file = (folder / "payloads.txt").string(), binary_file = (folder / "payloads.bin").string();
+	{
+		ofstream lines(lines_file), binary(binary_file, ios::binary);
+		for (const string& payload : payloads) {
+			lines << payload << "\n";
+		}
+		// binary payloads may contain new lines
+		payloads[3] = "line 1\nline 2";
+		for (const string& payload : payloads) {
+			const char prefix[] = {0, 0, 0, (char)payload.size()};
+			binary.write(prefix, 4);
+			binary << payload;
+		}
+	}
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKey_file(key_file);
+	for (const bool length_prefixed : {false, true}) {
+		const string output_file = (folder / (length_prefixed ? "binary.sig" : "lines.sig")).string();
+		vector<const char*> argv = {"lcc", "test", "sign", "-p", key_file.c_str(), "-o", output_file.c_str(),
+									"-i", length_prefixed ? binary_file.c_str() : lines_file.c_str(), "-j", "3"};
+		if (length_prefixed) {
+			argv.push_back("--length-prefixed");
+		}
+		boost::test_tools::output_test_stream output;
+		int result;
+		{
+			cout_redirect guard(output.rdbuf());
+			result = CommandLineParser::parseCommandLine((int)argv.size(), &argv[0]);
+		}
+		BOOST_CHECK_EQUAL(result, 0);
+		BOOST_CHECK_MESSAGE(output.str().find("Payloads signed: 100") != string::npos, output.str());
+		const vector<string> signatures = read_lines(output_file);
+		BOOST_REQUIRE_EQUAL(signatures.size(), payloads.size());
+		for (size_t i = 0; i < payloads.size(); i++) {
+			const string payload = !length_prefixed && i == 3 ? "payload 3" : payloads[i];
+			BOOST_CHECK_MESSAGE(crypto->verifySignature(payload, signatures[i]), "signature " + to_string(i));
+		}
+	}
+	const char* argv[] = {"lcc", "test", "sign", "-p", key_file.c_str(), "-o", "cout"};
+	boost::test_tools::output_test_stream output;
+	{
+		cout_redirect guard(output.rdbuf());
+		BOOST_CHECK_EQUAL(CommandLineParser::parseCommandLine(7, argv), 1);
+	}
+	const string empty_sig = (folder / "empty.sig").string();
+	BOOST_REQUIRE_EQUAL(
+		run_quiet({"lcc", "test", "sign", "-p", key_file.c_str(), "-o", empty_sig.c_str(), "-d", ""}), 0);
+	BOOST_CHECK(crypto->verifySignature("", read_lines(empty_sig)[0]));
+	// a damaged length prefix, far longer than the file
+	const string damaged_file = (folder / "damaged.bin").string();
+	{
+		ofstream damaged(damaged_file, ios::binary);
+		const char prefix[] = {(char)0xff, (char)0xff, (char)0xff, (char)0xf0};
+		damaged.write(prefix, 4);
+		damaged << "short";
+	}
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "test", "sign", "-p", key_file.c_str(), "-o", empty_sig.c_str(), "-i",
+								 damaged_file.c_str(), "--length-prefixed"}),
+					  1);
+}
+
+BOOST_AUTO_TEST_CASE(binary_license_convert) {
+	const string project_name("TEST_BINARY");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_binary");
+	const fs::path project_folder(projects_folder / project_name);
+	create_project(projects_folder, project_folder / PRIVATE_KEY_FNAME,
+				   project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME, mock_source_folder,
+				   project_name);
+	const string project_str = project_folder.string(), binary_file = (projects_folder / "client.lcc").string(),
+				 ini_file = (projects_folder / "client.lic").string();
+	string output;
+	BOOST_REQUIRE_EQUAL(run_quiet({"lcc", "license", "issue", "-p", project_str.c_str(), "-o", binary_file.c_str(),
+								   "--format", "binary", "-e", "2030-01-01"},
+								  &output),
+						0);
+	// scripts parse this line
+	BOOST_CHECK_EQUAL(output, "License written \n");
+	BOOST_REQUIRE_EQUAL(run_quiet({"lcc", "license", "issue", "--verbose", "-p", project_str.c_str(), "-o",
+								   binary_file.c_str(), "--format", "binary", "-e", "2030-01-01"},
+								  &output),
+						0);
+	BOOST_CHECK_EQUAL(output, "License written \nSections signed: 0, unchanged: 1\n");
+	BOOST_CHECK_EQUAL(read_lines(binary_file)[0].substr(0, 4), BINARY_LICENSE_MAGIC);
+	BOOST_REQUIRE_EQUAL(
+		run_quiet({"lcc", "license", "convert", "-i", binary_file.c_str(), "-o", ini_file.c_str(), "--to", "ini"}), 0);
+	CSimpleIniA ini;
+	BOOST_REQUIRE(ini.LoadFile(ini_file.c_str()) == SI_OK);
+	BOOST_CHECK_EQUAL(string(ini.GetValue(project_name.c_str(), PARAM_EXPIRY_DATE, "")), "2030-01-01");
+	const string missing_file = (projects_folder / "missing.lcc").string();
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "license", "convert", "-i", missing_file.c_str(), "-o", ini_file.c_str(), "--to", "ini"}), 1);
+
+	const string list_file = (projects_folder / "verify.txt").string();
+	ofstream(list_file) << binary_file << "\n" << ini_file << "\n";
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "license", "verify", "-p", project_str.c_str(), "-i", list_file.c_str()}, &output), 0);
+	BOOST_CHECK_MESSAGE(count(output.begin(), output.end(), '\n') == 2 &&
+							output.find("\"valid\": false") == string::npos,
+						output);
+}
+
+BOOST_AUTO_TEST_CASE(json_license_and_batch_results) {
+	const string project_name("TEST_JSON");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_json");
+	const fs::path project_folder(projects_folder / project_name);
+	create_project(projects_folder, project_folder / PRIVATE_KEY_FNAME,
+				   project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME, mock_source_folder,
+				   project_name);
+	const string project_str = project_folder.string(), json_file = (projects_folder / "client.json").string();
+	BOOST_REQUIRE_EQUAL(run_quiet({"lcc", "license", "issue", "-p", project_str.c_str(), "-o", json_file.c_str(),
+								   "--format", "json", "-e", "2030-01-01"}),
+						0);
+	const vector<string> license = read_lines(json_file);
+	BOOST_REQUIRE_EQUAL(license.size(), 1);
+	BOOST_CHECK_MESSAGE(license[0].find("{\"format\": \"lcc-license\"") == 0 &&
+							license[0].find("\"valid-to\": \"2030-01-01\"") != string::npos,
+						license[0]);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "issue", "-p", project_str.c_str(), "--format", "xml"}), 1);
+
+	const string orders_file = (projects_folder / "orders.tsv").string(),
+				 results_file = (projects_folder / "results.jsonl").string();
+	ofstream(orders_file) << PARAM_LICENSE_OUTPUT "\t" PARAM_FEATURE_NAMES "\n"
+						  << (projects_folder / "a.json").string() << "\tf1\n"
+						  << (projects_folder / "b.json").string() << "\tf[1\n";
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "batch", "-p", project_str.c_str(), "-i", orders_file.c_str(),
+								 "--format", "json", "--results", results_file.c_str()}),
+					  1);
+	const vector<string> results = read_lines(results_file);
+	BOOST_REQUIRE_EQUAL(results.size(), 2);
+	BOOST_CHECK_MESSAGE(results[0].find("{\"line\": 2, ") == 0 &&
+							results[0].find("\"issued\": true, \"signed_sections\": 1") != string::npos,
+						results[0]);
+	BOOST_CHECK_MESSAGE(results[1].find("\"issued\": false, \"error\": ") != string::npos, results[1]);
+	string output;
+	const string list_file = (projects_folder / "verify.txt").string();
+	ofstream(list_file) << json_file << "\n" << (projects_folder / "a.json").string() << "\n";
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "license", "verify", "-p", project_str.c_str(), "-i", list_file.c_str()}, &output), 0);
+	BOOST_CHECK_MESSAGE(count(output.begin(), output.end(), '\n') == 2 &&
+							output.find("\"valid\": false") == string::npos,
+						output);
+}
+
+BOOST_AUTO_TEST_CASE(issue_license_bundle) {
+	const string project_name("TEST_BUNDLE");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_bundle");
+	const fs::path project_folder(projects_folder / project_name);
+	create_project(projects_folder, project_folder / PRIVATE_KEY_FNAME,
+				   project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME, mock_source_folder,
+				   project_name);
+	const fs::path orders_file(projects_folder / "orders.tsv");
+	{
+		ofstream orders(orders_file.string());
+		orders << PARAM_LICENSE_OUTPUT "\t" PARAM_CLIENT_SIGNATURE << endl;
+		for (int i = 0; i < 12; i++) {
+			orders << "customer" << i % 3 << "/host" << i << ".lic\tAAAA-" << i % 4 << endl;
+		}
+		orders << "customer0/host0.lic\tBBBB" << endl;
+	}
+	const string orders_str = orders_file.string(), project_str = project_folder.string(),
+				 bundle_file = (projects_folder / "licenses.bundle").string(),
+				 extract_str = (projects_folder / "extracted").string();
+	string output;
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "batch", "-i", orders_str.c_str(), "-p", project_str.c_str(),
+								 "--bundle", bundle_file.c_str()},
+								&output),
+					  1);
+	BOOST_CHECK_MESSAGE(output.find("Licenses issued: 12, failed: 1") != string::npos, output);
+	BOOST_CHECK(!fs::exists(projects_folder / "customer0"));
+	// the duplicate license was not issued
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "ledger", "find", "-p", project_str.c_str(), "-s", "BBBB"}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("0 sections") != string::npos, output);
+
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "bundle", "list", "-i", bundle_file.c_str(), "-s", "AAAA-1"}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("3 licenses") != string::npos &&
+							output.find("customer1/host1.lic") != string::npos && output.find("host9.lic") != string::npos,
+						output);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "bundle", "extract", "-i", bundle_file.c_str(), "-o", extract_str.c_str(), "-n",
+								 "customer2/host5.lic", "-n", "customer0/host3.lic"}),
+					  0);
+	CSimpleIniA ini;
+	BOOST_REQUIRE(ini.LoadFile((projects_folder / "extracted" / "customer2" / "host5.lic").c_str()) == SI_OK);
+	BOOST_CHECK_EQUAL(string(ini.GetValue(project_name.c_str(), PARAM_CLIENT_SIGNATURE, "")), "AAAA-1");
+	BOOST_CHECK(fs::exists(projects_folder / "extracted" / "customer0" / "host3.lic"));
+	BOOST_CHECK(!fs::exists(projects_folder / "extracted" / "customer0" / "host0.lic"));
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "bundle", "extract", "-i", bundle_file.c_str(), "-o", extract_str.c_str(), "-n", "none"}), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ledger_of_issued_sections) {
+	const string project_name("TEST_LEDGER");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_ledger");
+	const fs::path project_folder(projects_folder / project_name);
+	create_project(projects_folder, project_folder / PRIVATE_KEY_FNAME,
+				   project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME, mock_source_folder,
+				   project_name);
+	const string project_str = project_folder.string(), license_str = (projects_folder / "ledger.lic").string();
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "issue", "-p", project_str.c_str(), "-o", license_str.c_str(), "-s",
+								 "AAAA-LEDGER", "-f", "f1,f2"}),
+					  0);
+	// unchanged sections are not issued again
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "issue", "-p", project_str.c_str(), "-o", license_str.c_str(), "-s",
+								 "AAAA-LEDGER", "-f", "f1,f3"}),
+					  0);
+	string output;
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "ledger", "find", "-p", project_str.c_str(), "-s", "AAAA-LEDGER", "--details"}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("3 sections") != string::npos && output.find("F3") != string::npos &&
+							output.find("client-signature=AAAA-LEDGER") != string::npos,
+						output);
+	CSimpleIniA ini;
+	BOOST_REQUIRE(ini.LoadFile(license_str.c_str()) == SI_OK);
+	BOOST_CHECK(output.find(string(LICENSE_SIGNATURE "=") + ini.GetValue("F2", LICENSE_SIGNATURE, "?")) !=
+				string::npos);
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "ledger", "find", "-p", project_str.c_str(), "-o", license_str.c_str()}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("3 sections") != string::npos, output);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "ledger", "compact", "-p", project_str.c_str(), "--drop-superseded"}, &output),
+					  0);
+	BOOST_CHECK_MESSAGE(output.find("Ledger records kept: 3, superseded: 0") != string::npos, output);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "ledger", "find", "-p", project_str.c_str()}), 1);
+}
+
+BOOST_AUTO_TEST_CASE(keystore_import_issue_export) {
+	const string project_name("TEST_KEYSTORE");
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_projects_keystore");
+	const fs::path project_folder(projects_folder / project_name);
+	const fs::path key_file(project_folder / PRIVATE_KEY_FNAME);
+	create_project(projects_folder, key_file,
+				   project_folder / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME, mock_source_folder,
+				   project_name);
+	const string projects_str = projects_folder.string(), project_str = project_folder.string();
+	const string keystore_str = (fs::path(PROJECT_TEST_TEMP_DIR) / "projects.lks").string();
+	fs::remove(keystore_str);
+	string output;
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "keystore", "import", "-k", keystore_str.c_str(), "-p", projects_str.c_str(),
+								 "-n", project_name.c_str()},
+								&output),
+					  0);
+	BOOST_CHECK_MESSAGE(output.find("Keys imported: 1") != string::npos, output);
+	// the project key is taken from the keystore
+	const fs::path moved_key(projects_folder / "moved_key.rsa");
+	fs::rename(key_file, moved_key);
+	// a key that can't be imported again doesn't drop the one in the keystore
+	const vector<const char*> import_argv = {"lcc", "keystore", "import", "-k", keystore_str.c_str(), "-p",
+											 projects_str.c_str(), "-n", project_name.c_str()};
+	BOOST_CHECK_EQUAL(run_quiet(import_argv), 1);
+	vector<const char*> force_argv(import_argv);
+	force_argv.push_back("--force");
+	BOOST_CHECK_EQUAL(run_quiet(force_argv, &output), 1);
+	BOOST_CHECK_MESSAGE(output.find("Keys imported: 0, kept from the keystore: 1, failed: 1") != string::npos, output);
+	const string license_str = (projects_folder / "keystore.lic").string();
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "issue", "-p", project_str.c_str(), "--keystore",
+								 keystore_str.c_str(), "-o", license_str.c_str()}),
+					  0);
+	BOOST_CHECK_EQUAL(
+		run_quiet({"lcc", "keystore", "export", "-k", keystore_str.c_str(), "-p", projects_str.c_str()}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find("Keys exported: 1, unchanged: 0") != string::npos, output);
+	unique_ptr<CryptoHelper> exported(CryptoHelper::getInstance()), original(CryptoHelper::getInstance());
+	exported->loadPrivateKey_file(key_file.string());
+	original->loadPrivateKey_file(moved_key.string());
+	BOOST_CHECK_EQUAL(exported->publicKeyFingerprint(), original->publicKeyFingerprint());
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "license", "verify", "-p", project_str.c_str(), "-l", license_str.c_str()}), 0);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "keystore", "list", "-k", keystore_str.c_str()}, &output), 0);
+	BOOST_CHECK_MESSAGE(output.find(project_name) != string::npos && output.find("1 keys") != string::npos, output);
+	BOOST_CHECK_EQUAL(run_quiet({"lcc", "keystore", "export", "-k", keystore_str.c_str(), "-p", projects_str.c_str(),
+								 "-n", "MISSING_PROJECT"}),
+					  1);
+}
+
 BOOST_AUTO_TEST_CASE(issue_license_help) {
 	int argc = 4;
 	const char* argv1[] = {"lcc", "license", "issue", "-h"};
@@ -71,6 +71,19 @@ BOOST_AUTO_TEST_CASE(test_load_and_export_private) {
 	crypto.release();
 }
 
+BOOST_AUTO_TEST_CASE(test_public_key_fingerprint) {
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKey(loadPrivateKey());
+	const string fingerprint = crypto->publicKeyFingerprint();
+	BOOST_CHECK_EQUAL(fingerprint.size(), 64);
+	BOOST_CHECK(fingerprint.find_first_not_of("0123456789abcdef") == string::npos);
+	unique_ptr<CryptoHelper> other(CryptoHelper::getInstance());
+	other->loadPrivateKey(loadPrivateKey());
+	BOOST_CHECK_EQUAL(other->publicKeyFingerprint(), fingerprint);
+	other->generateKeyPair();
+	BOOST_CHECK_NE(other->publicKeyFingerprint(), fingerprint);
+}
+
 BOOST_AUTO_TEST_CASE(test_load_and_export_public_key) {
 	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
 	const vector<unsigned char> expected_pubkey(PUBKEY);
@@ -103,6 +116,16 @@ BOOST_AUTO_TEST_CASE(test_load_and_sign) {
 	crypto.release();
 }
 
+BOOST_AUTO_TEST_CASE(test_verify_signature) {
+	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
+	crypto->loadPrivateKey(loadPrivateKey());
+	BOOST_CHECK_MESSAGE(crypto->verifySignature("testString", SIGNATURE), "signature verified");
+	BOOST_CHECK_MESSAGE(!crypto->verifySignature("testString2", SIGNATURE), "different data is not verified");
+	unique_ptr<CryptoHelper> other(CryptoHelper::getInstance());
+	other->generateKeyPair();
+	BOOST_CHECK_MESSAGE(!other->verifySignature("testString", SIGNATURE), "a different key is not verified");
+}
+
 BOOST_AUTO_TEST_CASE(test_generate_export_import_and_sign) {
 	unique_ptr<CryptoHelper> crypto(CryptoHelper::getInstance());
 	crypto->generateKeyPair();
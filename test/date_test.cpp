@@ -0,0 +1,113 @@
+#define BOOST_TEST_MODULE test_date
+
+#include <string>
+#include <stdexcept>
+#include <boost/test/unit_test.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include "../src/license_generator/date_parser.hpp"
+
+namespace license {
+namespace test {
+using namespace std;
+namespace bg = boost::gregorian;
+
+static const string normalize(const string& date, const RunClock& clock) {
+	char out[DATE_LENGTH];
+	normalize_date(date.data(), date.size(), clock, out);
+	return string(out, DATE_LENGTH);
+}
+
+static const string two_digits(unsigned int value) { return (value < 10 ? "0" : "") + to_string(value); }
+
+/**
+ * Every day from 1600 to 2400 in the three formats is normalized as boost::gregorian does.
+ */
+BOOST_AUTO_TEST_CASE(all_valid_dates) {
+	const RunClock clock(2020, 1, 1);
+	const bg::date first(1600, 1, 1), last(2400, 12, 31);
+	long checked = 0;
+	for (bg::date day = first; day <= last; day += bg::days(1)) {
+		const bg::date::ymd_type ymd = day.year_month_day();
+		const string expected = bg::to_iso_extended_string(day);
+		const string year = to_string(ymd.year), month = two_digits(ymd.month), mday = two_digits(ymd.day);
+		BOOST_REQUIRE_EQUAL(normalize(year + month + mday, clock), expected);
+		BOOST_REQUIRE_EQUAL(normalize(year + "/" + month + "/" + mday, clock), expected);
+		BOOST_REQUIRE_EQUAL(normalize(expected, clock), expected);
+		checked++;
+	}
+	BOOST_CHECK_EQUAL(checked, (last - first).days() + 1);
+}
+
+/**
+ * Every day/month combination that doesn't exist is refused.
+ */
+BOOST_AUTO_TEST_CASE(all_invalid_dates) {
+	const RunClock clock(2020, 1, 1);
+	for (unsigned int year = 1896; year <= 2104; year++) {
+		for (unsigned int month = 0; month <= 13; month++) {
+			for (unsigned int day = 0; day <= 32; day++) {
+				bool valid = true;
+				try {
+					bg::date(year, month, day);
+				} catch (const out_of_range&) {
+					valid = false;
+				}
+				const string date = to_string(year) + "-" + two_digits(month) + "-" + two_digits(day);
+				if (valid) {
+					BOOST_REQUIRE_EQUAL(normalize(date, clock), date);
+				} else {
+					BOOST_REQUIRE_THROW(normalize(date, clock), invalid_argument);
+				}
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(leap_years) {
+	const RunClock clock(2020, 1, 1);
+	BOOST_CHECK_EQUAL(normalize("2000-02-29", clock), "2000-02-29");
+	BOOST_CHECK_EQUAL(normalize("2024/2/29", clock), "2024-02-29");
+	BOOST_CHECK_THROW(normalize("1900-02-29", clock), invalid_argument);
+	BOOST_CHECK_THROW(normalize("20190229", clock), invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(wrong_formats) {
+	const RunClock clock(2020, 1, 1);
+	const char* wrong[] = {"",			 "2020",		 "2020-1-1x",  "2020-01/01", "202001011",
+						   "2020_01_01", "20-01-2020",	 "0000-01-01", "2020-13-01", "+",
+						   "+d",		 "+12",			 "+12x",	   "+1dd",		 "+9999999d",
+						   "+8000y",	 "2020-01-01 a", "x2020-01-01"};
+	for (const char* date : wrong) {
+		BOOST_CHECK_THROW(normalize(date, clock), invalid_argument);
+	}
+	BOOST_CHECK_EQUAL(normalize(" 2020-01-01\t", clock), "2020-01-01");
+	BOOST_CHECK_EQUAL(normalize("2020-1-1", clock), "2020-01-01");
+}
+
+BOOST_AUTO_TEST_CASE(relative_dates) {
+	const RunClock clock(2020, 1, 31);
+	BOOST_CHECK_EQUAL(normalize("+0d", clock), "2020-01-31");
+	BOOST_CHECK_EQUAL(normalize("+1d", clock), "2020-02-01");
+	BOOST_CHECK_EQUAL(normalize("+365d", clock), "2021-01-30");
+	BOOST_CHECK_EQUAL(normalize("-31d", clock), "2019-12-31");
+	BOOST_CHECK_EQUAL(normalize("+2w", clock), "2020-02-14");
+	BOOST_CHECK_EQUAL(normalize("+1m", clock), "2020-02-29");
+	BOOST_CHECK_EQUAL(normalize("+13m", clock), "2021-02-28");
+	BOOST_CHECK_EQUAL(normalize("+12m", clock), "2021-01-31");
+	BOOST_CHECK_EQUAL(normalize("-2M", clock), "2019-11-30");
+	BOOST_CHECK_EQUAL(normalize("+1y", RunClock(2020, 2, 29)), "2021-02-28");
+	BOOST_CHECK_EQUAL(normalize("+4Y", RunClock(2020, 2, 29)), "2024-02-29");
+}
+
+/**
+ * Relative dates in the same run are resolved against the same day.
+ */
+BOOST_AUTO_TEST_CASE(run_clock) {
+	BOOST_CHECK_EQUAL(&RunClock::current(), &RunClock::current());
+	BOOST_CHECK_EQUAL(normalize_date("+0d"), normalize("+0d", RunClock::current()));
+	BOOST_CHECK_EQUAL(RunClock::current().today(), RunClock().today());
+}
+
+}  // namespace test
+}  // namespace license
@@ -0,0 +1,147 @@
+#define BOOST_TEST_MODULE test_json_license
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <build_properties.h>
+
+#include "../src/base_lib/base.h"
+#include "../src/license_generator/json_license.hpp"
+#include "../src/license_generator/json_writer.hpp"
+#include "../src/license_generator/license.hpp"
+#include "../src/license_generator/project_context.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static LicenseSection section(const string& name, const vector<LicenseField>& fields) {
+	LicenseSection result;
+	result.name = name;
+	result.fields = fields;
+	return result;
+}
+
+BOOST_AUTO_TEST_CASE(writer_nesting_and_escaping) {
+	string out;
+	JsonWriter writer(out);
+	writer.begin_object().key("empty").begin_array().end_array().key("list").begin_array();
+	writer.number(0).value(true).null().begin_object().end_object().value("a\"b\\c\n\t\x01");
+	writer.end_array().key("n").number(18446744073709551615ull).key("r").real(0.125).key("nan").real(NAN);
+	BOOST_CHECK(!writer.complete());
+	writer.end_object();
+	BOOST_CHECK(writer.complete());
+	BOOST_CHECK_EQUAL(out,
+					  "{\"empty\": [], \"list\": [0, true, null, {}, \"a\\\"b\\\\c\\n\\t\\u0001\"], "
+					  "\"n\": 18446744073709551615, \"r\": 0.125, \"nan\": null}");
+	BOOST_CHECK_THROW(JsonWriter(out).end_object(), logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(values_round_trip) {
+	const vector<LicenseSection> sections = {
+		section("PROJECT", {{LICENSE_VERSION, "200"},
+							{PARAM_EXPIRY_DATE, "2030-01-31"},
+							{"z-custom", "quotes \" and \\ and \xc3\xa8"},
+							{"a-custom", ""},
+							{LICENSE_SIGNATURE, "c2lnbmF0dXJl"}}),
+		section("EMPTY", {})};
+	string json;
+	encode_json_license(sections, json);
+	BOOST_CHECK(is_json_license(json.data(), json.size()));
+	BOOST_CHECK_EQUAL(count(json.begin(), json.end(), '\n'), 1);
+	vector<LicenseSection> decoded;
+	// the layout of the document doesn't matter
+	const string indented = "\n  " + boost::replace_all_copy(json, ", ", ",\n    ");
+	for (const string& document : {json, indented}) {
+		decode_json_license(document.data(), document.size(), decoded);
+		BOOST_REQUIRE_EQUAL(decoded.size(), sections.size());
+		for (size_t s = 0; s < sections.size(); s++) {
+			BOOST_CHECK_EQUAL(decoded[s].name, sections[s].name);
+			BOOST_REQUIRE_EQUAL(decoded[s].fields.size(), sections[s].fields.size());
+			// fields keep their order
+			for (size_t f = 0; f < sections[s].fields.size(); f++) {
+				BOOST_CHECK_EQUAL(decoded[s].fields[f].key, sections[s].fields[f].key);
+				BOOST_CHECK_EQUAL(decoded[s].fields[f].value, sections[s].fields[f].value);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(malformed_license) {
+	const vector<string> documents = {
+		"{",
+		"{}",
+		"[]",
+		"{\"format\": \"other\", \"sections\": []}",
+		"{\"format\": \"lcc-license\", \"version\": 2, \"sections\": []}",
+		"{\"format\": \"lcc-license\", \"sections\": [], \"extra\": 1}",
+		"{\"format\": \"lcc-license\", \"sections\": [{\"name\": \"F1\", \"fields\": {\"lic_ver\": 200}}]}",
+		"{\"format\": \"lcc-license\", \"sections\": [{\"name\": \"F1\", \"fields\": {\"a\": [\"b\"]}}]}",
+		"{\"format\": \"lcc-license\", \"sections\": [{\"name\": \"F1\", \"other\": \"b\"}]}",
+		"{\"format\": \"lcc-license\", \"sections\": [[]]}",
+		"{\"format\": \"lcc-license\", \"sections\": []} trailing"};
+	vector<LicenseSection> decoded;
+	for (const string& document : documents) {
+		BOOST_CHECK_THROW(decode_json_license(document.data(), document.size(), decoded), runtime_error);
+	}
+	// members in any order
+	const string valid =
+		"{\"sections\": [{\"fields\": {\"k\": \"v\"}, \"name\": \"F1\"}], \"format\": \"lcc-license\"}";
+	decode_json_license(valid.data(), valid.size(), decoded);
+	BOOST_REQUIRE_EQUAL(decoded.size(), 1);
+	BOOST_CHECK_EQUAL(decoded[0].name, "F1");
+	BOOST_CHECK(!is_json_license("[PROJECT]\nkey=value\n", 20));
+	BOOST_CHECK(!is_json_license(" \n ", 3));
+}
+
+/**
+ * JSON licenses are signed on the canonical text of their sections: the same signatures of the INI license, whatever
+ * the order of the fields in the document.
+ */
+BOOST_AUTO_TEST_CASE(signatures_canonical) {
+	ifstream key_file((fs::path(PROJECT_TEST_SRC_DIR) / "data" / PRIVATE_KEY_FNAME).string());
+	const string private_key((istreambuf_iterator<char>(key_file)), istreambuf_iterator<char>());
+	const ProjectContext project("JSON_PROJECT", private_key);
+	License license(project, nullptr);
+	string ini, json;
+	for (const LicenseFormat format : {LicenseFormat::INI, LicenseFormat::JSON}) {
+		license.reset(nullptr);
+		license.set_format(format);
+		license.add_parameter(PARAM_FEATURE_NAMES, "f1,f2");
+		license.add_parameter(PARAM_EXPIRY_DATE, "2030-01-31");
+		license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB");
+		license.write_license(format == LicenseFormat::INI ? ini : json);
+	}
+	BOOST_CHECK(is_json_license(json.data(), json.size()));
+	string converted;
+	License::convert(json.data(), json.size(), LicenseFormat::INI, converted);
+	BOOST_CHECK_EQUAL(converted, ini);
+	License::convert(ini.data(), ini.size(), LicenseFormat::JSON, converted);
+	BOOST_CHECK_EQUAL(converted, json);
+
+	vector<LicenseSection> sections;
+	decode_json_license(json.data(), json.size(), sections);
+	for (LicenseSection& section : sections) {
+		reverse(section.fields.begin(), section.fields.end());
+	}
+	string reordered;
+	encode_json_license(sections, reordered);
+	BOOST_CHECK(reordered != json);
+	vector<SectionVerification> verification;
+	BOOST_REQUIRE(License::verify(reordered.data(), reordered.size(), *project.crypto(), verification));
+	BOOST_REQUIRE_EQUAL(verification.size(), 2);
+	BOOST_CHECK(verification[0].status == SignatureStatus::VALID && verification[1].status == SignatureStatus::VALID);
+
+	const string tampered = boost::replace_first_copy(json, "2030-01-31", "2039-01-31");
+	BOOST_REQUIRE(License::verify(tampered.data(), tampered.size(), *project.crypto(), verification));
+	BOOST_CHECK(verification[0].status == SignatureStatus::INVALID);
+}
+
+}  // namespace test
+}  // namespace license
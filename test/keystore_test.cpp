@@ -0,0 +1,85 @@
+#define BOOST_TEST_MODULE test_keystore
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/keystore.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const string keystore_file(const string& name) {
+	fs::create_directories(PROJECT_TEST_TEMP_DIR);
+	const fs::path file(fs::path(PROJECT_TEST_TEMP_DIR) / name);
+	fs::remove(file);
+	return file.string();
+}
+
+BOOST_AUTO_TEST_CASE(write_and_find) {
+	const string file = keystore_file("keystore_find.lks");
+	vector<unique_ptr<CryptoHelper>> keys;
+	KeystoreWriter writer(file);
+	// added out of order, numbered by name in the keystore
+	for (int i = 9; i >= 0; i--) {
+		keys.emplace_back(CryptoHelper::getInstance());
+		keys.back()->generateKeyPair();
+		writer.add("project_" + to_string(i), *keys.back());
+	}
+	BOOST_CHECK_THROW(writer.add("project_3", *keys[0]), invalid_argument);
+	BOOST_CHECK_EQUAL(writer.size(), 10);
+	writer.finish();
+
+	const Keystore keystore(file);
+	BOOST_REQUIRE_EQUAL(keystore.size(), 10);
+	for (int i = 0; i < 10; i++) {
+		const CryptoHelper& original = *keys[9 - i];
+		const size_t index = keystore.find("project_" + to_string(i));
+		BOOST_REQUIRE_EQUAL(index, i);
+		BOOST_CHECK_EQUAL(keystore.project_name(index), "project_" + to_string(i));
+		BOOST_CHECK_EQUAL(keystore.fingerprint(index), original.publicKeyFingerprint());
+		BOOST_CHECK_EQUAL(keystore.find_fingerprint(original.publicKeyFingerprint()), index);
+		// the key is loaded once, signatures match the original key
+		const shared_ptr<const CryptoHelper> key = keystore.key(index);
+		BOOST_CHECK(key == keystore.key(index));
+		BOOST_CHECK_EQUAL(key->signString("license"), original.signString("license"));
+		BOOST_CHECK_EQUAL(key->exportPrivateKey(), original.exportPrivateKey());
+	}
+	BOOST_CHECK_EQUAL(keystore.find("project_"), Keystore::NOT_FOUND);
+	BOOST_CHECK_EQUAL(keystore.find("project_99"), Keystore::NOT_FOUND);
+	BOOST_CHECK_EQUAL(keystore.find(""), Keystore::NOT_FOUND);
+	BOOST_CHECK_EQUAL(keystore.find_fingerprint(string(64, '0')), Keystore::NOT_FOUND);
+	BOOST_CHECK_EQUAL(keystore.find_fingerprint("not a fingerprint"), Keystore::NOT_FOUND);
+}
+
+BOOST_AUTO_TEST_CASE(empty_and_corrupted) {
+	const string file = keystore_file("keystore_corrupted.lks");
+	KeystoreWriter(file).finish();
+	{
+		const Keystore keystore(file);
+		BOOST_CHECK_EQUAL(keystore.size(), 0);
+		BOOST_CHECK_EQUAL(keystore.find("project"), Keystore::NOT_FOUND);
+	}
+	unique_ptr<CryptoHelper> key(CryptoHelper::getInstance());
+	key->generateKeyPair();
+	KeystoreWriter writer(file);
+	writer.add("project", *key);
+	writer.finish();
+	const uintmax_t size = fs::file_size(file);
+	fs::resize_file(file, size - 1);
+	BOOST_CHECK_THROW(Keystore keystore(file), runtime_error);
+
+	ofstream(file, ios::trunc) << "not a keystore";
+	BOOST_CHECK_THROW(Keystore keystore(file), runtime_error);
+	fs::remove(file);
+	BOOST_CHECK_THROW(Keystore keystore(file), runtime_error);
+}
+
+}  // namespace test
+}  // namespace license
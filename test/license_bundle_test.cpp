@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE test_license_bundle
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/license_bundle.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const string bundle_path(const string& name) {
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / "lcc_bundles");
+	fs::create_directories(folder);
+	return (folder / name).string();
+}
+
+BOOST_AUTO_TEST_CASE(write_and_find) {
+	const string file = bundle_path("licenses.bundle");
+	BundleWriter writer(file);
+	// added out of order, with a client that has many licenses
+	for (int i = 999; i >= 0; i--) {
+		const string client = i % 10 == 0 ? "CLIENT-0" : "CLIENT-" + to_string(i);
+		writer.add("customer/host" + to_string(i) + ".lic", client, "[PROJECT]\nlicense = " + to_string(i) + "\n");
+	}
+	writer.add("demo.lic", "", "[PROJECT]\n");
+	BOOST_CHECK_THROW(writer.add("demo.lic", "", ""), invalid_argument);
+	writer.finish();
+
+	const LicenseBundle bundle(file);
+	BOOST_REQUIRE_EQUAL(bundle.size(), 1001);
+	for (size_t i = 1; i < bundle.size(); i++) {
+		BOOST_CHECK(bundle.entry(i - 1).name < bundle.entry(i).name);
+	}
+	const size_t found = bundle.find("customer/host42.lic");
+	BOOST_REQUIRE(found != LicenseBundle::NOT_FOUND);
+	const BundleEntry entry = bundle.entry(found);
+	BOOST_CHECK_EQUAL(entry.client_signature, "CLIENT-42");
+	BOOST_CHECK_EQUAL(string(entry.data, entry.size), "[PROJECT]\nlicense = 42\n");
+	BOOST_CHECK(bundle.find("customer/host42") == LicenseBundle::NOT_FOUND);
+	BOOST_CHECK(bundle.find("zzz") == LicenseBundle::NOT_FOUND);
+	BOOST_CHECK(bundle.find("") == LicenseBundle::NOT_FOUND);
+
+	const vector<size_t> client_licenses = bundle.find_client("CLIENT-0");
+	BOOST_REQUIRE_EQUAL(client_licenses.size(), 100);
+	for (size_t i = 0; i < client_licenses.size(); i++) {
+		BOOST_CHECK_EQUAL(bundle.entry(client_licenses[i]).client_signature, "CLIENT-0");
+		BOOST_CHECK(i == 0 || client_licenses[i - 1] < client_licenses[i]);
+	}
+	BOOST_CHECK_EQUAL(bundle.find_client("CLIENT-999").size(), 1);
+	BOOST_CHECK_EQUAL(bundle.find_client("CLIENT-1000").size(), 0);
+	BOOST_CHECK_EQUAL(bundle.entry(bundle.find_client("")[0]).name, "demo.lic");
+}
+
+BOOST_AUTO_TEST_CASE(empty_and_corrupted) {
+	const string file = bundle_path("empty.bundle");
+	BundleWriter(file).finish();
+	BOOST_CHECK_EQUAL(LicenseBundle(file).size(), 0);
+	BOOST_CHECK(LicenseBundle(file).find("any") == LicenseBundle::NOT_FOUND);
+
+	const string corrupted = bundle_path("corrupted.bundle");
+	BundleWriter writer(corrupted);
+	writer.add("a.lic", "", "license");
+	writer.finish();
+	fs::resize_file(corrupted, fs::file_size(corrupted) - 1);
+	BOOST_CHECK_THROW(LicenseBundle bundle(corrupted), runtime_error);
+	ofstream(corrupted, ios::trunc) << "[PROJECT]\nnot a bundle at all, but long enough\n";
+	BOOST_CHECK_THROW(LicenseBundle bundle(corrupted), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(section_sizes_overflow) {
+	const string file = bundle_path("overflow.bundle");
+	BundleWriter writer(file);
+	writer.add("a.lic", "", "license");
+	writer.finish();
+	// the sizes of the string heap and of the data section still add up to the file size, modulo 2^64
+	fstream stream(file, ios::in | ios::out | ios::binary);
+	uint64_t sizes[2];
+	stream.seekg(16);
+	stream.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+	sizes[0] -= 0x1000;
+	sizes[1] += 0x1000;
+	sizes[0] += 0x8000000000000000ULL;
+	sizes[1] += 0x8000000000000000ULL;
+	stream.seekp(16);
+	stream.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+	stream.close();
+	BOOST_CHECK_THROW(LicenseBundle bundle(file), runtime_error);
+}
+
+}  // namespace test
+}  // namespace license
@@ -0,0 +1,149 @@
+#define BOOST_TEST_MODULE test_license_index
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/file_lock.hpp"
+#include "../src/license_generator/license_index.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const fs::path clean_folder(const string& name) {
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / name);
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	return folder;
+}
+
+static LicenseRecord record(const string& path, const string& features, const string& valid_to,
+							const string& client_signature) {
+	LicenseRecord result;
+	result.path = path;
+	result.features = features;
+	result.valid_from = "2026-01-01";
+	result.valid_to = valid_to;
+	result.client_signature = client_signature;
+	result.version_from = "1";
+	return result;
+}
+
+static vector<string> paths(LicenseIndex& index, const LicenseFilter& filter) {
+	vector<string> found;
+	const size_t count = index.query(filter, [&](const LicenseRecord& record) { found.push_back(record.path); });
+	BOOST_CHECK_EQUAL(count, found.size());
+	return found;
+}
+
+BOOST_AUTO_TEST_CASE(filters) {
+	const fs::path folder = clean_folder("license_index_filters");
+	LicenseIndex index(folder.string());
+	index.add(record("/l/c.lic", "PRJ", "2026-12-31", "AAAA-BBBB"));
+	index.add(record("/l/a.lic", "PRJ,EXTRA", "2027-03-01", ""));
+	index.add(record("/l/b.lic", "PRJ", "", "AAAA-BBBB"));
+
+	LicenseFilter filter;
+	BOOST_CHECK((paths(index, filter) == vector<string>{"/l/a.lic", "/l/b.lic", "/l/c.lic"}));
+	filter.feature = "extra";
+	BOOST_CHECK((paths(index, filter) == vector<string>{"/l/a.lic"}));
+	filter.feature = "EXTR";
+	BOOST_CHECK(paths(index, filter).empty());
+
+	filter = LicenseFilter();
+	filter.client_signature = "AAAA-BBBB";
+	BOOST_CHECK((paths(index, filter) == vector<string>{"/l/b.lic", "/l/c.lic"}));
+	filter.expires_before = "20270101";
+	BOOST_CHECK((paths(index, filter) == vector<string>{"/l/c.lic"}));
+
+	filter = LicenseFilter();
+	filter.expires_after = "2026-12-31";
+	BOOST_CHECK((paths(index, filter) == vector<string>{"/l/a.lic", "/l/c.lic"}));
+	filter.expires_after = "2027-01-01";
+	BOOST_CHECK((paths(index, filter) == vector<string>{"/l/a.lic"}));
+	filter.expires_after = "2027-02-30";
+	BOOST_CHECK_THROW(paths(index, filter), invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(journal_and_compaction) {
+	const fs::path folder = clean_folder("license_index_compaction");
+	{
+		LicenseIndex index(folder.string());
+		index.add(record("/l/b.lic", "PRJ", "2026-12-31", ""));
+		index.add(record("/l/d.lic", "PRJ", "2026-12-31", ""));
+		index.compact();
+	}
+	BOOST_CHECK(fs::exists(folder / LICENSE_INDEX_FNAME));
+	BOOST_CHECK(!fs::exists(folder / LICENSE_JOURNAL_FNAME));
+	{
+		LicenseIndex index(folder.string());
+		// replaces the indexed record, the other ones are merged in path order
+		index.add(record("/l/d.lic", "PRJ", "2028-01-01", ""));
+		index.add(record("/l/a.lic", "PRJ", "2026-12-31", ""));
+		index.add(record("/l/c.lic", "PRJ", "2026-12-31", ""));
+	}
+	BOOST_CHECK(fs::exists(folder / LICENSE_JOURNAL_FNAME));
+	LicenseIndex index(folder.string());
+	vector<LicenseRecord> found;
+	LicenseFilter filter;
+	index.query(filter, [&](const LicenseRecord& record) { found.push_back(record); });
+	BOOST_REQUIRE_EQUAL(found.size(), 4);
+	BOOST_CHECK_EQUAL(found[0].path, "/l/a.lic");
+	BOOST_CHECK_EQUAL(found[1].path, "/l/b.lic");
+	BOOST_CHECK_EQUAL(found[2].path, "/l/c.lic");
+	BOOST_CHECK_EQUAL(found[3].path, "/l/d.lic");
+	BOOST_CHECK_EQUAL(found[3].valid_to, "2028-01-01");
+
+	index.compact();
+	BOOST_CHECK(!fs::exists(folder / LICENSE_JOURNAL_FNAME));
+	found.clear();
+	index.query(filter, [&](const LicenseRecord& record) { found.push_back(record); });
+	BOOST_REQUIRE_EQUAL(found.size(), 4);
+	BOOST_CHECK_EQUAL(found[3].valid_to, "2028-01-01");
+	BOOST_CHECK_EQUAL(found[3].valid_from, "2026-01-01");
+	BOOST_CHECK_EQUAL(found[3].version_from, "1");
+	BOOST_CHECK_EQUAL(found[3].features, "PRJ");
+
+	// a line cut by an interrupted write is ignored
+	ofstream(fs::path(folder / LICENSE_JOURNAL_FNAME).string(), ios::app) << "/l/e.lic\tPRJ";
+	BOOST_CHECK_EQUAL(index.query(filter, [](const LicenseRecord&) {}), 4);
+}
+
+/**
+ * The journal is written holding the lock file, as another process issuing licenses would do.
+ */
+BOOST_AUTO_TEST_CASE(journal_locked) {
+	const fs::path folder = clean_folder("license_index_locked");
+	const fs::path journal_file(folder / LICENSE_JOURNAL_FNAME);
+	LicenseIndex index(folder.string());
+	index.add(record("/l/a.lic", "PRJ", "2026-12-31", ""));
+	thread writer;
+	{
+		FileLock lock((folder / LICENSE_INDEX_LOCK_FNAME).string());
+		writer = thread([&index]() { index.flush(); });
+		this_thread::sleep_for(chrono::milliseconds(100));
+		BOOST_CHECK(!fs::exists(journal_file));
+	}
+	writer.join();
+	BOOST_CHECK(fs::exists(journal_file));
+	index.compact();
+	BOOST_CHECK(!fs::exists(journal_file));
+	BOOST_CHECK((paths(index, LicenseFilter()) == vector<string>{"/l/a.lic"}));
+}
+
+BOOST_AUTO_TEST_CASE(damaged_index) {
+	const fs::path folder = clean_folder("license_index_damaged");
+	ofstream(fs::path(folder / LICENSE_INDEX_FNAME).string()) << "not an index, but long enough to have a header";
+	LicenseIndex index(folder.string());
+	BOOST_CHECK_THROW(index.query(LicenseFilter(), [](const LicenseRecord&) {}), runtime_error);
+}
+
+}  // namespace test
+}  // namespace license
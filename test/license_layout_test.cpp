@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE test_license_layout
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/license_layout.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const fs::path clean_folder(const string& name) {
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / name);
+	fs::remove_all(folder);
+	return folder;
+}
+
+static void touch(const string& fname) {
+	fs::create_directories(fs::path(fname).parent_path());
+	ofstream(fname) << "[F]" << endl;
+}
+
+BOOST_AUTO_TEST_CASE(directory_cache) {
+	const fs::path folder = clean_folder("layout_cache");
+	DirectoryCache cache;
+	const string nested = (folder / "customer" / "site").string();
+	cache.create_directories(nested);
+	BOOST_CHECK(fs::is_directory(nested));
+	cache.create_directories(nested);
+	cache.create_directories(nested);
+	BOOST_CHECK_EQUAL(cache.size(), 1);
+	BOOST_CHECK_EQUAL(cache.hits(), 2);
+
+	touch((folder / "file").string());
+	BOOST_CHECK_THROW(cache.create_directories((folder / "file").string()), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(flat_layout) {
+	const fs::path folder = clean_folder("layout_flat");
+	const LicenseLayout layout = LicenseLayout::open(folder.string());
+	BOOST_CHECK_EQUAL(layout.fanout(), 0);
+	BOOST_CHECK_EQUAL(layout.path("customer/host.lic"), (folder / "customer/host.lic").string());
+	BOOST_CHECK(layout.find("customer/host.lic").empty());
+	BOOST_CHECK(layout.list().empty());
+	BOOST_CHECK(!fs::exists(folder / LICENSE_LAYOUT_FNAME));
+}
+
+BOOST_AUTO_TEST_CASE(trailing_separator) {
+	const fs::path folder = clean_folder("layout_trailing");
+	touch((folder / "customer" / "host.lic").string());
+	touch((folder / "demo.lic").string());
+	const LicenseLayout layout = LicenseLayout::open(folder.string() + "/");
+	const vector<string> names = layout.list();
+	BOOST_REQUIRE_EQUAL(names.size(), 2);
+	BOOST_CHECK_EQUAL(names[0], "customer/host.lic");
+	BOOST_CHECK_EQUAL(names[1], "demo.lic");
+	BOOST_CHECK(fs::equivalent(layout.find("demo.lic"), folder / "demo.lic"));
+}
+
+BOOST_AUTO_TEST_CASE(sharded_layout) {
+	const fs::path folder = clean_folder("layout_sharded");
+	touch((folder / "legacy.lic").string());
+	const LicenseLayout layout = LicenseLayout::open(folder.string(), 16);
+	BOOST_CHECK_EQUAL(layout.fanout(), 16);
+	BOOST_CHECK(fs::exists(folder / LICENSE_LAYOUT_FNAME));
+
+	vector<string> expected;
+	for (int i = 0; i < 50; i++) {
+		const string name = "customer" + to_string(i % 5) + "/host" + to_string(i) + ".lic";
+		const fs::path license_path(layout.path(name));
+		// folder/shard/customer/host.lic
+		BOOST_CHECK_EQUAL(license_path.parent_path().parent_path().parent_path(), folder);
+		BOOST_CHECK_EQUAL(license_path.parent_path().parent_path().filename().string().size(), 2);
+		BOOST_CHECK_EQUAL(layout.path(name), license_path.string());
+		touch(license_path.string());
+		expected.push_back(name);
+	}
+	expected.push_back("legacy.lic");
+	sort(expected.begin(), expected.end());
+
+	// a new run reads the layout from the folder
+	const LicenseLayout reopened = LicenseLayout::open(folder.string());
+	BOOST_CHECK_EQUAL(reopened.fanout(), 16);
+	BOOST_CHECK_EQUAL(reopened.find("customer3/host8.lic"), layout.path("customer3/host8.lic"));
+	BOOST_CHECK_MESSAGE(reopened.find("legacy.lic") == (folder / "legacy.lic").string(),
+						"licenses written before sharding are found");
+	BOOST_CHECK(reopened.find("missing.lic").empty());
+	const vector<string> names = reopened.list();
+	BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected.begin(), expected.end());
+
+	const vector<string> slash_names = LicenseLayout::open(folder.string() + "/").list();
+	BOOST_CHECK_EQUAL_COLLECTIONS(slash_names.begin(), slash_names.end(), expected.begin(), expected.end());
+
+	BOOST_CHECK_THROW(LicenseLayout::open(folder.string(), 32), invalid_argument);
+	BOOST_CHECK_THROW(LicenseLayout::open(folder.string(), 0), invalid_argument);
+	BOOST_CHECK_EQUAL(LicenseLayout::open(folder.string(), 16).fanout(), 16);
+}
+
+}  // namespace test
+}  // namespace license
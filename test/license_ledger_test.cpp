@@ -0,0 +1,150 @@
+#define BOOST_TEST_MODULE test_license_ledger
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/license_ledger.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const fs::path clean_folder(const string& name) {
+	const fs::path folder(fs::path(PROJECT_TEST_TEMP_DIR) / name);
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	return folder;
+}
+
+static LedgerRecord record(const string& output, const string& feature, const string& client_signature) {
+	LedgerRecord result;
+	result.issued_at = 1790000000;
+	result.output = output;
+	result.feature = feature;
+	result.client_signature = client_signature;
+	result.parameters = "client-signature=" + client_signature + "\nlic_ver=200\n";
+	result.signature = "c2lnbmF0dXJl";
+	return result;
+}
+
+static vector<string> find(LicenseLedger& ledger, LedgerKey key, const string& value) {
+	vector<string> found;
+	const size_t count = ledger.find(key, value, [&](const LedgerRecord& record) {
+		found.push_back(record.output + ":" + record.feature);
+		BOOST_CHECK_EQUAL(record.issued_at, 1790000000);
+		BOOST_CHECK_EQUAL(record.signature, "c2lnbmF0dXJl");
+	});
+	BOOST_CHECK_EQUAL(count, found.size());
+	return found;
+}
+
+BOOST_AUTO_TEST_CASE(find_indexed_and_appended) {
+	const fs::path folder = clean_folder("ledger_find");
+	LicenseLedger ledger(folder.string());
+	BOOST_CHECK(find(ledger, LedgerKey::OUTPUT, "a.lic").empty());
+	ledger.add(record("a.lic", "F1", "AAAA"));
+	ledger.add(record("b.lic", "F1", "BBBB"));
+	ledger.add(record("a.lic", "F2", "AAAA"));
+	ledger.add(record("", "F1", "AAAA"));
+	// records written before the index exists are scanned
+	BOOST_CHECK((find(ledger, LedgerKey::OUTPUT, "a.lic") == vector<string>{"a.lic:F1", "a.lic:F2"}));
+	LedgerCompaction compaction = ledger.compact(false);
+	BOOST_CHECK_EQUAL(compaction.records, 4);
+	BOOST_CHECK(fs::exists(folder / LICENSE_LEDGER_INDEX_FNAME));
+	// found partly in the index, partly after it
+	for (int i = 0; i < 100; i++) {
+		ledger.add(record("c" + to_string(i) + ".lic", "F1", i % 2 == 0 ? "AAAA" : "CCCC"));
+	}
+	ledger.add(record("a.lic", "F1", "AAAA"));
+	const vector<string> client = find(ledger, LedgerKey::CLIENT_SIGNATURE, "AAAA");
+	BOOST_REQUIRE_EQUAL(client.size(), 54);
+	BOOST_CHECK_EQUAL(client[0], "a.lic:F1");
+	BOOST_CHECK_EQUAL(client[2], ":F1");
+	BOOST_CHECK_EQUAL(client[3], "c0.lic:F1");
+	BOOST_CHECK_EQUAL(client[53], "a.lic:F1");
+	BOOST_CHECK_EQUAL(find(ledger, LedgerKey::OUTPUT, "a.lic").size(), 3);
+	BOOST_CHECK(find(ledger, LedgerKey::CLIENT_SIGNATURE, "AAA").empty());
+	BOOST_CHECK_THROW(find(ledger, LedgerKey::OUTPUT, ""), invalid_argument);
+
+	// everything indexed, the older licenses are superseded
+	compaction = ledger.compact(true);
+	BOOST_CHECK_EQUAL(compaction.records, 104);
+	BOOST_CHECK_EQUAL(compaction.superseded, 1);
+	BOOST_CHECK_EQUAL(compaction.damaged_bytes, 0);
+	BOOST_CHECK((find(ledger, LedgerKey::OUTPUT, "a.lic") == vector<string>{"a.lic:F2", "a.lic:F1"}));
+	BOOST_CHECK_EQUAL(find(ledger, LedgerKey::CLIENT_SIGNATURE, "CCCC").size(), 50);
+}
+
+BOOST_AUTO_TEST_CASE(damaged_records_skipped) {
+	const fs::path folder = clean_folder("ledger_damaged");
+	const string ledger_file = (folder / LICENSE_LEDGER_FNAME).string();
+	{
+		LicenseLedger ledger(folder.string());
+		for (int i = 0; i < 10; i++) {
+			ledger.add(record("l" + to_string(i) + ".lic", "F1", "AAAA"));
+		}
+	}
+	// a byte changed in the middle, and a record torn at the end
+	const size_t size = (size_t)fs::file_size(ledger_file);
+	{
+		fstream file(ledger_file, ios::in | ios::out | ios::binary);
+		file.seekp(size / 2);
+		file.put('#');
+	}
+	ofstream(ledger_file, ios::app | ios::binary) << "LREC";
+	LicenseLedger ledger(folder.string());
+	ledger.add(record("new.lic", "F1", "AAAA"));
+	const vector<string> found = find(ledger, LedgerKey::CLIENT_SIGNATURE, "AAAA");
+	BOOST_CHECK_EQUAL(found.size(), 10);
+	BOOST_CHECK_EQUAL(found.back(), "new.lic:F1");
+	const LedgerCompaction compaction = ledger.compact(false);
+	BOOST_CHECK_EQUAL(compaction.records, 10);
+	BOOST_CHECK_GT(compaction.damaged_bytes, 4);
+	BOOST_CHECK_EQUAL(find(ledger, LedgerKey::CLIENT_SIGNATURE, "AAAA").size(), 10);
+
+	ofstream(ledger_file, ios::trunc) << "not a ledger, but long enough";
+	BOOST_CHECK_THROW(find(ledger, LedgerKey::OUTPUT, "a.lic"), runtime_error);
+}
+
+/**
+ * Each ledger object stands for an issuing process: they lock the ledger independently.
+ */
+BOOST_AUTO_TEST_CASE(concurrent_writers) {
+	const fs::path folder = clean_folder("ledger_concurrent");
+	const int writers = 4, records = 3000;
+	vector<thread> threads;
+	for (int w = 0; w < writers; w++) {
+		threads.emplace_back([&folder, w]() {
+			LicenseLedger ledger(folder.string());
+			for (int i = 0; i < records; i++) {
+				ledger.add(record("w" + to_string(w) + "_" + to_string(i) + ".lic", "F1", "W" + to_string(w)));
+				if (i % 100 == 0) {
+					ledger.flush();
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	LicenseLedger ledger(folder.string());
+	for (int w = 0; w < writers; w++) {
+		const vector<string> found = find(ledger, LedgerKey::CLIENT_SIGNATURE, "W" + to_string(w));
+		BOOST_REQUIRE_EQUAL(found.size(), records);
+		// the records of a writer keep their order
+		BOOST_CHECK_EQUAL(found[records - 1], "w" + to_string(w) + "_" + to_string(records - 1) + ".lic:F1");
+	}
+	BOOST_CHECK_EQUAL(find(ledger, LedgerKey::OUTPUT, "w2_1234.lic").size(), 1);
+	const LedgerCompaction compaction = ledger.compact(false);
+	BOOST_CHECK_EQUAL(compaction.records, writers * records);
+	BOOST_CHECK_EQUAL(compaction.damaged_bytes, 0);
+}
+
+}  // namespace test
+}  // namespace license
@@ -8,12 +8,16 @@
 #else
 #include <boost/test/output_test_stream.hpp>
 #endif
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <build_properties.h>
 
 #include "../src/base_lib/base.h"
 #include "../src/ini/SimpleIni.h"
 #include "../src/license_generator/license.hpp"
+#include "../src/license_generator/parameter_schema.hpp"
+#include "../src/license_generator/project_context.hpp"
 #include "cout_redirect.hpp"
 
 namespace license {
@@ -52,6 +56,46 @@ const fs::path MyGlobalFixture::project_path(fs::path(fs::path(PROJECT_TEST_TEMP
 const fs::path MyGlobalFixture::licenses_path(project_path / "licenses");
 const std::string MyGlobalFixture::licenses_path_str(licenses_path.string());
 
+BOOST_AUTO_TEST_CASE(parameter_schema_lookup) {
+	for (const ParameterSchema &param : PARAMETER_SCHEMA) {
+		const ParameterSchema *found = find_parameter(param.name);
+		BOOST_CHECK_MESSAGE(found != nullptr && string(found->name) == param.name,
+							string("parameter found ") + param.name);
+	}
+	BOOST_CHECK(find_parameter("custom-parameter") == nullptr);
+	BOOST_CHECK(find_parameter("") == nullptr);
+	BOOST_CHECK(find_parameter(PARAM_EXPIRY_DATE)->kind == ParamKind::DATE);
+	BOOST_CHECK(find_parameter(PARAM_VERSION_FROM)->serialized);
+	BOOST_CHECK(!find_parameter(PARAM_LICENSE_OUTPUT)->serialized);
+}
+
+/**
+ * Issue licenses in memory, with a project that doesn't exist on disk.
+ */
+BOOST_AUTO_TEST_CASE(issue_in_memory) {
+	ifstream key_file((fs::path(PROJECT_TEST_SRC_DIR) / "data" / PRIVATE_KEY_FNAME).string());
+	const string private_key((istreambuf_iterator<char>(key_file)), istreambuf_iterator<char>());
+	const ProjectContext project("MEMORY_PROJECT", private_key);
+	BOOST_CHECK(project.project_folder().empty());
+	License license(project, nullptr);
+	license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB");
+	string buffer;
+	license.write_license(buffer);
+	CSimpleIniA ini;
+	BOOST_REQUIRE(ini.LoadData(buffer) == SI_OK);
+	BOOST_CHECK_EQUAL(ini.GetSectionSize("MEMORY_PROJECT"), 3);
+	BOOST_CHECK_EQUAL(license.signed_sections(), 1);
+
+	const string previous(buffer);
+	license.reset(nullptr);
+	license.add_parameter(PARAM_FEATURE_NAMES, "other_feature");
+	license.write_license(buffer, &previous);
+	ini.Reset();
+	BOOST_REQUIRE(ini.LoadData(buffer) == SI_OK);
+	BOOST_CHECK_MESSAGE(ini.GetSectionSize("MEMORY_PROJECT") == 3, "previous license extended");
+	BOOST_CHECK_EQUAL(ini.GetSectionSize("OTHER_FEATURE"), 2);
+}
+
 // this test is incompatible with older version of boost
 #ifdef BOOST_TEST_GLOBAL_FIXTURE
 
@@ -146,6 +190,123 @@ BOOST_AUTO_TEST_CASE(extend_license) {
 						"license extended");
 }
 
+/**
+ * Issuing again the same parameters on an existing license doesn't sign it again.
+ */
+BOOST_AUTO_TEST_CASE(reissue_unchanged_license) {
+	const fs::path licFile = MyGlobalFixture::licenses_path / "reissue.lic";
+	const string lic_location_str = licFile.string();
+	License license(&lic_location_str, MyGlobalFixture::project_path.string());
+	license.add_parameter(PARAM_FEATURE_NAMES, "feature1,feature2");
+	license.add_parameter(PARAM_EXPIRY_DATE, "2030-11-11");
+	license.write_license();
+	BOOST_CHECK_EQUAL(license.signed_sections(), 2);
+	BOOST_CHECK_EQUAL(license.unchanged_sections(), 0);
+	CSimpleIniA ini;
+	ini.LoadFile(licFile.c_str());
+	const string signature(ini.GetValue("FEATURE1", LICENSE_SIGNATURE));
+
+	License same_license(&lic_location_str, MyGlobalFixture::project_path.string());
+	same_license.add_parameter(PARAM_FEATURE_NAMES, "feature1,feature2");
+	same_license.add_parameter(PARAM_EXPIRY_DATE, "20301111");
+	same_license.write_license();
+	BOOST_CHECK_EQUAL(same_license.signed_sections(), 0);
+	BOOST_CHECK_EQUAL(same_license.unchanged_sections(), 2);
+
+	License changed_license(&lic_location_str, MyGlobalFixture::project_path.string());
+	changed_license.add_parameter(PARAM_FEATURE_NAMES, "feature1,feature2");
+	changed_license.add_parameter(PARAM_EXPIRY_DATE, "2031-11-11");
+	changed_license.write_license();
+	BOOST_CHECK_EQUAL(changed_license.signed_sections(), 2);
+	BOOST_CHECK_EQUAL(changed_license.unchanged_sections(), 0);
+	ini.Reset();
+	ini.LoadFile(licFile.c_str());
+	BOOST_CHECK_MESSAGE(signature != ini.GetValue("FEATURE1", LICENSE_SIGNATURE), "license signed again");
+}
+
+/**
+ * A section with a signature that doesn't match the current key is signed again even if unchanged.
+ */
+BOOST_AUTO_TEST_CASE(reissue_invalid_signature) {
+	const fs::path licFile = MyGlobalFixture::licenses_path / "reissue_invalid.lic";
+	const string lic_location_str = licFile.string();
+	{
+		ofstream tampered(lic_location_str);
+		tampered << "[TEST_PROJECT]" << endl << "lic_ver = 200" << endl << "sig = AAAA" << endl;
+	}
+	License license(&lic_location_str, MyGlobalFixture::project_path.string());
+	license.write_license();
+	BOOST_CHECK_EQUAL(license.signed_sections(), 1);
+	BOOST_CHECK_EQUAL(license.unchanged_sections(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(parameters_normalization) {
+	boost::test_tools::output_test_stream output;
+	{
+		cout_redirect guard(output.rdbuf());
+		License license(nullptr, MyGlobalFixture::project_path.string());
+		license.add_parameter(PARAM_BEGIN_DATE, "2020/02/29");
+		license.add_parameter(PARAM_VERSION_FROM, "0");
+		license.add_parameter(PARAM_VERSION_TO, "3");
+		license.add_parameter("custom-param", "custom value");
+		license.add_parameter(PARAM_PROJECT_FOLDER, "ignored");
+		BOOST_CHECK_THROW(license.add_parameter(PARAM_MAGIC_NUMBER, "1"), logic_error);
+		BOOST_CHECK_THROW(license.add_parameter(PARAM_FEATURE_NAMES, "a/b"), invalid_argument);
+		license.write_license();
+	}
+	const string stdout_str = output.str();
+	BOOST_CHECK_MESSAGE(stdout_str.find(PARAM_BEGIN_DATE " = 2020-02-29") != string::npos, "date normalized");
+	BOOST_CHECK_MESSAGE(stdout_str.find(PARAM_VERSION_FROM) == string::npos, "version 0 is not written");
+	BOOST_CHECK_MESSAGE(stdout_str.find(PARAM_VERSION_TO " = 3") != string::npos, "version written");
+	BOOST_CHECK_MESSAGE(stdout_str.find("custom-param = custom value") != string::npos, "custom parameter written");
+	BOOST_CHECK_MESSAGE(stdout_str.find(PARAM_PROJECT_FOLDER) == string::npos, stdout_str);
+}
+
+/**
+ * The same License object is reused for many licenses of a project.
+ */
+BOOST_AUTO_TEST_CASE(reuse_license_object) {
+	const ProjectContext project(MyGlobalFixture::project_path.string());
+	BOOST_CHECK_EQUAL(project.default_features(), "test_project");
+	BOOST_CHECK_MESSAGE(project.crypto() == project.crypto(), "key is loaded once");
+	AtomicFileWriter file_writer(10);
+	string license_name;
+	License license(project, &license_name, false, &file_writer);
+	for (int i = 0; i < 3; i++) {
+		license_name = (MyGlobalFixture::licenses_path / "reuse" / (to_string(i) + ".lic")).string();
+		license.reset(&license_name);
+		if (i == 0) {
+			license.add_parameter(PARAM_FEATURE_NAMES, "feature_a");
+			license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB");
+		}
+		license.add_parameter(PARAM_EXPIRY_DATE, "2030-01-0" + to_string(i + 1));
+		license.write_license();
+	}
+	file_writer.commit();
+	BOOST_CHECK_EQUAL(file_writer.commit_stats().commits, 1);
+	CSimpleIniA ini;
+	ini.LoadFile((MyGlobalFixture::licenses_path / "reuse" / "2.lic").c_str());
+	BOOST_CHECK_MESSAGE(ini.GetSectionSize("TEST_PROJECT") == 3, "default feature restored by reset");
+	BOOST_CHECK_MESSAGE(ini.GetValue("TEST_PROJECT", PARAM_CLIENT_SIGNATURE) == nullptr, "parameters cleared");
+	BOOST_CHECK_EQUAL(string(ini.GetValue("TEST_PROJECT", PARAM_EXPIRY_DATE)), "2030-01-03");
+}
+
+/**
+ * Licenses issued in memory are not recorded in the ledger of the project, even if it is on disk.
+ */
+BOOST_AUTO_TEST_CASE(in_memory_license_not_in_ledger) {
+	const ProjectContext project(MyGlobalFixture::project_path.string());
+	License license(project, nullptr);
+	license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-IN-MEMORY");
+	string buffer;
+	license.write_license(buffer);
+	BOOST_CHECK_EQUAL(license.signed_sections(), 1);
+	project.ledger()->flush();
+	BOOST_CHECK_EQUAL(project.ledger()->find(LedgerKey::CLIENT_SIGNATURE, "AAAA-IN-MEMORY",
+											  [](const LedgerRecord &) {}),
+					  0);
+}
+
 #else
 BOOST_AUTO_TEST_CASE(mock) { BOOST_CHECKPOINT("Mock test for older boost versions"); }
 #endif
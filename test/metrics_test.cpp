@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE test_metrics
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/metrics.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(log_linear_buckets) {
+	for (uint64_t value : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, 1ull << 40,
+						   (1ull << 63) + 12345, ~0ull}) {
+		const size_t bucket = HistogramSnapshot::bucket(value);
+		BOOST_REQUIRE_LT(bucket, HistogramSnapshot::BUCKETS);
+		BOOST_CHECK_LE(HistogramSnapshot::bucket_lower_bound(bucket), value);
+		if (bucket + 1 < HistogramSnapshot::BUCKETS) {
+			BOOST_CHECK_GT(HistogramSnapshot::bucket_lower_bound(bucket + 1), value);
+		}
+	}
+	BOOST_CHECK_EQUAL(HistogramSnapshot::bucket(~0ull), HistogramSnapshot::BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(quantiles) {
+	const MetricsSnapshot start = Metrics::snapshot();
+	// 1..10000 microseconds
+	for (uint64_t i = 1; i <= 10000; i++) {
+		Metrics::observe(Histogram::COMMIT_LATENCY, i * 1000);
+	}
+	const HistogramSnapshot latency = Metrics::snapshot().since(start)[Histogram::COMMIT_LATENCY];
+	BOOST_CHECK_EQUAL(latency.count, 10000);
+	BOOST_CHECK_EQUAL(latency.sum_ns, 50005000ull * 1000);
+	BOOST_CHECK_CLOSE((double)latency.quantile(0.5), 5000000.0, 12.5);
+	BOOST_CHECK_CLOSE((double)latency.quantile(0.99), 9900000.0, 12.5);
+	BOOST_CHECK_CLOSE((double)latency.quantile(0.999), 9990000.0, 12.5);
+	BOOST_CHECK_EQUAL(HistogramSnapshot().quantile(0.5), 0);
+}
+
+BOOST_AUTO_TEST_CASE(threads_merged_on_read) {
+	const MetricsSnapshot start = Metrics::snapshot();
+	vector<thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.push_back(thread([]() {
+			for (int i = 0; i < 1000; i++) {
+				Metrics::add(Counter::LICENSES_ISSUED);
+				Metrics::observe(Histogram::LICENSE_LATENCY, 1000);
+			}
+			Metrics::add(Gauge::PENDING_COMMIT_FILES, 3);
+		}));
+	}
+	for (auto& t : threads) t.join();
+	// the metrics of the terminated threads are still there
+	const MetricsSnapshot delta = Metrics::snapshot().since(start);
+	BOOST_CHECK_EQUAL(delta[Counter::LICENSES_ISSUED], 4000);
+	BOOST_CHECK_EQUAL(delta[Histogram::LICENSE_LATENCY].count, 4000);
+	BOOST_CHECK_EQUAL(delta[Gauge::PENDING_COMMIT_FILES] - start[Gauge::PENDING_COMMIT_FILES], 12);
+	Metrics::add(Gauge::PENDING_COMMIT_FILES, -12);
+}
+
+BOOST_AUTO_TEST_CASE(openmetrics_file) {
+	const fs::path metrics_file(fs::path(PROJECT_TEST_TEMP_DIR) / "lccgen.prom");
+	fs::remove(metrics_file);
+	{
+		MetricsReporter reporter(metrics_file.string(), chrono::milliseconds(10));
+		Metrics::add(Counter::KEY_CACHE_HITS, 3);
+		Metrics::add(Counter::KEY_CACHE_MISSES);
+		for (int i = 0; i < 200 && !fs::exists(metrics_file); i++) {
+			this_thread::sleep_for(chrono::milliseconds(10));
+		}
+		BOOST_CHECK(fs::exists(metrics_file));
+	}
+	ifstream metrics_stream(metrics_file.string());
+	const string metrics((istreambuf_iterator<char>(metrics_stream)), istreambuf_iterator<char>());
+	BOOST_CHECK(metrics.find("# TYPE lccgen_licenses counter\n") != string::npos);
+	BOOST_CHECK(metrics.find("\nlccgen_key_cache_misses_total ") != string::npos);
+	BOOST_CHECK(metrics.find("\nlccgen_license_latency_seconds{quantile=\"0.999\"} ") != string::npos);
+	BOOST_CHECK(metrics.find("\nlccgen_licenses_per_second ") != string::npos);
+	BOOST_REQUIRE_GE(metrics.size(), 6);
+	BOOST_CHECK_EQUAL(metrics.substr(metrics.size() - 6), "# EOF\n");
+}
+
+}  // namespace test
+}  // namespace license
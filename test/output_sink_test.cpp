@@ -0,0 +1,137 @@
+#define BOOST_TEST_MODULE test_output_sink
+
+#define SI_SUPPORT_IOSTREAMS
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <build_properties.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "../src/base_lib/base.h"
+#include "../src/ini/SimpleIni.h"
+#include "../src/license_generator/license.hpp"
+#include "../src/license_generator/output_sink.hpp"
+#include "../src/license_generator/project_context.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const string read_file(const fs::path& fname) {
+	ifstream is(fname.string(), ios::binary);
+	return string((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+}
+
+static const string private_key() { return read_file(fs::path(PROJECT_TEST_SRC_DIR) / "data" / PRIVATE_KEY_FNAME); }
+
+/**
+ * The segments must be the same bytes CSimpleIniA::Save would write, or existing licenses would change.
+ */
+BOOST_AUTO_TEST_CASE(segments_match_simpleini) {
+	const ProjectContext project("SINK_PROJECT", private_key());
+	License license(project, nullptr);
+	license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB");
+	license.add_parameter(PARAM_EXPIRY_DATE, "2040-01-01");
+	string buffer;
+	license.write_license(buffer);
+	const string previous(buffer);
+	license.reset(nullptr);
+	license.add_parameter(PARAM_FEATURE_NAMES, "feature1,feature2");
+	license.add_parameter(PARAM_EXTRA_DATA, "some data");
+	license.write_license(buffer, &previous);
+
+	CSimpleIniA ini;
+	BOOST_REQUIRE(ini.LoadData(buffer) == SI_OK);
+	BOOST_CHECK_EQUAL(ini.GetSectionSize("FEATURE2"), 3);
+	string saved;
+	ini.Save(saved, true);
+	BOOST_CHECK_EQUAL(buffer, saved);
+}
+
+/**
+ * Licenses with comments are written by SimpleIni and keep their comments.
+ */
+BOOST_AUTO_TEST_CASE(license_with_comments) {
+	const ProjectContext project("SINK_PROJECT", private_key());
+	License license(project, nullptr);
+	string buffer;
+	const string previous("; issued to ACME\n\n[OTHER]\n; old feature\nlic_ver = 200\n");
+	license.write_license(buffer, &previous);
+	BOOST_CHECK(buffer.find("; issued to ACME") != string::npos);
+	BOOST_CHECK(buffer.find("; old feature") != string::npos);
+	BOOST_CHECK(buffer.find("[SINK_PROJECT]") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(license_to_buffer_sink) {
+	const fs::path license_file(fs::path(PROJECT_TEST_TEMP_DIR) / "sink_buffer.lic");
+	// an unrelated file with the same name
+	ofstream(license_file.string(), ios::trunc) << "[OTHER]\nlic_ver = 200\nsig = AAAA\n";
+	const string license_name = license_file.string();
+	const ProjectContext project("SINK_PROJECT", private_key());
+	string output;
+	BufferSink sink(output);
+	License license(project, &license_name);
+	license.set_sink(&sink);
+	license.write_license();
+	const size_t first_size = output.size();
+	BOOST_CHECK_GT(first_size, 0);
+	license.reset(&license_name);
+	license.add_parameter(PARAM_CLIENT_SIGNATURE, "AAAA-BBBB");
+	license.write_license();
+	BOOST_CHECK_GT(output.size(), first_size * 2);
+	BOOST_CHECK_EQUAL(output.find("[SINK_PROJECT]", first_size), first_size);
+	BOOST_CHECK_MESSAGE(output.find("[OTHER]") == string::npos, "the license name is only a label for the sink");
+	BOOST_CHECK_EQUAL(fs::file_size(license_file), 33);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(fd_sink_many_segments) {
+	int pipe_fd[2];
+	BOOST_REQUIRE(pipe(pipe_fd) == 0);
+	// more segments than a single writev call takes
+	vector<string> pieces;
+	vector<Segment> segments;
+	string expected;
+	for (size_t i = 0; i < 150; i++) {
+		pieces.push_back(string(i % 7, 'a' + (char)(i % 26)) + to_string(i));
+		expected += pieces.back();
+	}
+	for (const auto& piece : pieces) {
+		const Segment segment = {piece.data(), piece.size()};
+		segments.push_back(segment);
+	}
+	FdSink sink(pipe_fd[1]);
+	sink.write(nullptr, segments.data(), segments.size());
+	close(pipe_fd[1]);
+	BOOST_CHECK_EQUAL(sink.bytes_written(), expected.size());
+
+	string received;
+	char buf[512];
+	ssize_t res;
+	while ((res = read(pipe_fd[0], buf, sizeof(buf))) > 0) {
+		received.append(buf, (size_t)res);
+	}
+	close(pipe_fd[0]);
+	BOOST_CHECK_EQUAL(received, expected);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(file_sink_segments) {
+	const fs::path license_file(fs::path(PROJECT_TEST_TEMP_DIR) / "sink_file.lic");
+	const string license_name = license_file.string();
+	const Segment segments[] = {{"[A]\n", 4}, {"sig = ", 6}, {"xyz", 3}, {"\n", 1}};
+	AtomicFileWriter writer;
+	FileSink sink(writer);
+	sink.write(&license_name, segments, 4);
+	BOOST_CHECK_EQUAL(read_file(license_file), "[A]\nsig = xyz\n");
+	BOOST_CHECK_THROW(sink.write(nullptr, segments, 4), invalid_argument);
+}
+
+}  // namespace test
+}  // namespace license
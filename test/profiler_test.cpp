@@ -0,0 +1,73 @@
+#define BOOST_TEST_MODULE test_profiler
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <build_properties.h>
+
+#include "../src/license_generator/command_line-parser.hpp"
+#include "../src/license_generator/profiler.hpp"
+
+namespace license {
+namespace test {
+namespace fs = boost::filesystem;
+using namespace std;
+
+static const string profile_of(const char** argv, int argc) {
+	stringstream err, out;
+	streambuf* const old_err = cerr.rdbuf(err.rdbuf());
+	streambuf* const old_out = cout.rdbuf(out.rdbuf());
+	CommandLineParser::parseCommandLine(argc, argv);
+	cerr.rdbuf(old_err);
+	cout.rdbuf(old_out);
+	return err.str();
+}
+
+BOOST_AUTO_TEST_CASE(disabled_by_default) {
+	BOOST_CHECK(!Profiler::enabled());
+	StageTimer timer(Stage::SIGNING);
+	timer.stop();
+	Profiler::enable(true);
+	stringstream json;
+	Profiler::print_json(json);
+	Profiler::enable(false);
+	BOOST_CHECK_MESSAGE(json.str().find("\"stages\": {}") != string::npos, json.str());
+}
+
+BOOST_AUTO_TEST_CASE(percentiles) {
+	Profiler::enable(true);
+	for (uint64_t i = 1; i <= 100; i++) {
+		Profiler::record(Stage::SIGNING, i * 1000000, 0);
+	}
+	Profiler::record(Stage::KEY_LOAD, 3000000, 2000000);
+	// the sample is bounded, the totals are not
+	for (size_t i = 0; i < Profiler::MAX_SAMPLES; i++) {
+		Profiler::record(Stage::FILE_WRITE, 1000, 0);
+	}
+	stringstream json;
+	Profiler::print_json(json);
+	Profiler::enable(false);
+	const string profile = json.str();
+	BOOST_CHECK_MESSAGE(profile.find("\"signing\": {\"count\": 100, \"wall_ms\": 5050, \"cpu_ms\": 0, \"wall_ms_p50\": 50, "
+									 "\"wall_ms_p90\": 90, \"wall_ms_p99\": 99, \"wall_ms_max\": 100}") != string::npos,
+						profile);
+	BOOST_CHECK_MESSAGE(profile.find("\"key_load\": {\"count\": 1, \"wall_ms\": 3, \"cpu_ms\": 2}") != string::npos,
+						profile);
+	BOOST_CHECK_MESSAGE(profile.find("\"file_write\": {\"count\": 65536,") != string::npos, profile);
+	BOOST_CHECK(profile.find("option_parsing") == string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(profile_option) {
+	const string key_file = (fs::path(PROJECT_TEST_SRC_DIR) / "data" / "private_key.rsa").string();
+	const char* argv[] = {"lcc", "test", "sign", "-p", key_file.c_str(), "-d", "data", "-o", "cout", "--profile"};
+	const string profile = profile_of(argv, 10);
+	BOOST_CHECK_MESSAGE(profile.find("\"option_parsing\": {\"count\": 2") != string::npos, profile);
+	BOOST_CHECK(!Profiler::enabled());
+	const char* quiet_argv[] = {"lcc", "test", "sign", "-p", key_file.c_str(), "-d", "data", "-o", "cout"};
+	BOOST_CHECK_EQUAL(profile_of(quiet_argv, 9), "");
+}
+
+}  // namespace test
+}  // namespace license
@@ -1,11 +1,19 @@
 #define BOOST_TEST_MODULE test_project
 
 #include <fstream>
+#include <iterator>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <boost/test/unit_test.hpp>
 #include <boost/filesystem.hpp>
 #include <build_properties.h>
 
+#include "../src/license_generator/file_lock.hpp"
+#include "../src/license_generator/parallel.hpp"
 #include "../src/license_generator/project.hpp"
+#include "../src/license_generator/project_index.hpp"
 #include "../src/ini/SimpleIni.h"
 #include "../src/base_lib/base.h"
 
@@ -40,3 +48,130 @@ BOOST_AUTO_TEST_CASE(project_initialize) {
 }
 
 BOOST_AUTO_TEST_CASE(project_initialize_force) {}
+
+/**
+ * Many projects share the same parsed template, also from different threads.
+ */
+BOOST_AUTO_TEST_CASE(projects_share_template) {
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path project_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "product_shared_template");
+	fs::remove_all(project_folder);
+	const shared_ptr<const KeyTemplates> key_templates =
+		KeyTemplates::get(mock_source_folder.string());
+	// not vector<bool>: its elements can't be written from different threads
+	vector<int> generated(6);
+	parallel_for(generated.size(), 3, [&](size_t i) {
+		Project prj("SHARED" + to_string(i), project_folder.string(), key_templates);
+		prj.initialize();
+		generated[i] = prj.keys_generated();
+	});
+	for (size_t i = 0; i < generated.size(); i++) {
+		const string project_name = "SHARED" + to_string(i);
+		BOOST_CHECK(generated[i]);
+		BOOST_CHECK(fs::exists(project_folder / project_name / PRIVATE_KEY_FNAME));
+		std::ifstream t(
+			(project_folder / project_name / "include" / "licensecc" / project_name / PUBLIC_KEY_INC_FNAME).string());
+		std::string pub_key((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
+		BOOST_CHECK_MESSAGE(pub_key.find(project_name) != std::string::npos, "Project defined");
+	}
+	Project existing("SHARED0", project_folder.string(), key_templates);
+	existing.initialize();
+	BOOST_CHECK(!existing.keys_generated());
+}
+
+BOOST_AUTO_TEST_CASE(key_artifacts) {
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path project_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "product_artifacts");
+	fs::remove_all(project_folder);
+	const shared_ptr<const KeyTemplates> key_templates = KeyTemplates::get(mock_source_folder.string());
+	BOOST_CHECK_MESSAGE(KeyTemplates::get((mock_source_folder / "templates").string()) == key_templates,
+						"templates are parsed once");
+	const vector<KeyTemplates::Artifact>& artifacts = key_templates->artifacts();
+	BOOST_REQUIRE_EQUAL(artifacts.size(), 3);
+	BOOST_CHECK_EQUAL(artifacts[0].output_name, "public_key.h");
+	BOOST_CHECK(artifacts[0].needs_key_array);
+	BOOST_CHECK_EQUAL(artifacts[1].output_name, "public_key.py");
+	BOOST_CHECK(!artifacts[1].needs_key_array);
+	BOOST_CHECK_EQUAL(artifacts[2].output_name, "public_key.rs");
+	BOOST_CHECK(!artifacts[2].needs_key_array);
+
+	const vector<unsigned char> key = {0, 1, 0xab, 255};
+	const vector<string> rendered = key_templates->render("ART", key);
+	BOOST_CHECK(rendered[0].find("0,1,171,255") != string::npos);
+	BOOST_CHECK(rendered[1].find("bytes.fromhex(\"0001abff\")") != string::npos);
+	BOOST_CHECK(rendered[2].find("[u8; 4] = [0,1,171,255]") != string::npos);
+
+	Project prj("ART", project_folder.string(), key_templates);
+	prj.initialize();
+	const fs::path rust_key(project_folder / "ART" / "keys" / "public_key.rs");
+	BOOST_REQUIRE(fs::exists(rust_key));
+	BOOST_CHECK(fs::exists(project_folder / "ART" / "keys" / "public_key.py"));
+	// a missing artifact is rendered again with the existing key
+	fs::remove(rust_key);
+	Project existing("ART", project_folder.string(), key_templates);
+	existing.initialize();
+	BOOST_CHECK(!existing.keys_generated());
+	BOOST_CHECK(fs::exists(rust_key));
+}
+
+BOOST_AUTO_TEST_CASE(project_manifest_and_index) {
+	const fs::path mock_source_folder(fs::path(PROJECT_TEST_SRC_DIR) / "data" / "src");
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "product_index");
+	fs::remove_all(projects_folder);
+	const shared_ptr<const KeyTemplates> key_templates = KeyTemplates::get(mock_source_folder.string());
+	Project second("SECOND", projects_folder.string(), key_templates);
+	second.initialize();
+	Project first("FIRST", projects_folder.string(), key_templates);
+	first.initialize();
+
+	ProjectManifest manifest;
+	BOOST_REQUIRE(read_manifest((projects_folder / "FIRST").string(), manifest));
+	BOOST_CHECK_EQUAL(manifest.name, "FIRST");
+	BOOST_CHECK_EQUAL(manifest.key_algorithm, PROJECT_KEY_ALGORITHM);
+	BOOST_CHECK_EQUAL(manifest.key_fingerprint.size(), 64);
+	BOOST_CHECK_EQUAL(manifest.created.size(), 20);
+	BOOST_CHECK_EQUAL(manifest.artifacts, "public_key.h,public_key.py,public_key.rs");
+
+	vector<ProjectManifest> projects = load_project_index(projects_folder.string());
+	BOOST_REQUIRE_EQUAL(projects.size(), 2);
+	BOOST_CHECK_EQUAL(projects[0].name, "FIRST");
+	BOOST_CHECK_EQUAL(projects[0].key_fingerprint, manifest.key_fingerprint);
+	BOOST_CHECK_EQUAL(projects[1].name, "SECOND");
+	BOOST_CHECK_NE(projects[1].key_fingerprint, manifest.key_fingerprint);
+
+	// the index is built again from the manifests if it's lost
+	fs::remove(projects_folder / PROJECT_INDEX_FNAME);
+	projects = load_project_index(projects_folder.string());
+	BOOST_REQUIRE_EQUAL(projects.size(), 2);
+	BOOST_CHECK_EQUAL(projects[0].created, manifest.created);
+}
+
+/**
+ * The index is updated holding the lock file, as another process would do.
+ */
+BOOST_AUTO_TEST_CASE(project_index_locked) {
+	const fs::path projects_folder(fs::path(PROJECT_TEST_TEMP_DIR) / "product_index_locked");
+	fs::remove_all(projects_folder);
+	fs::create_directories(projects_folder);
+	ProjectManifest first;
+	first.name = "FIRST";
+	update_project_index(projects_folder.string(), {first});
+	ProjectManifest second;
+	second.name = "SECOND";
+	thread updater;
+	{
+		FileLock lock((projects_folder / PROJECT_INDEX_LOCK_FNAME).string());
+		updater = thread([&projects_folder, &second]() { update_project_index(projects_folder.string(), {second}); });
+		this_thread::sleep_for(chrono::milliseconds(100));
+		// not load_project_index: the updater holds the index mutex
+		ifstream index((projects_folder / PROJECT_INDEX_FNAME).string());
+		const string content((istreambuf_iterator<char>(index)), istreambuf_iterator<char>());
+		BOOST_CHECK(content.find("FIRST") != string::npos);
+		BOOST_CHECK(content.find("SECOND") == string::npos);
+	}
+	updater.join();
+	const vector<ProjectManifest> projects = load_project_index(projects_folder.string());
+	BOOST_REQUIRE_EQUAL(projects.size(), 2);
+	BOOST_CHECK_EQUAL(projects[0].name, "FIRST");
+	BOOST_CHECK_EQUAL(projects[1].name, "SECOND");
+}